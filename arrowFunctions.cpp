@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "arrowFunctions.h"
+
+/**
+ * @brief Arrow - Columnar export
+ * 
+ * @details Saving the datapoints of a channel between two timestamps
+ * (inclusive) into an Arrow IPC file. Read only: late datapoints still
+ * in the side buffer are merged into the batches in timestamp order
+ * (after the column datapoints of equal timestamp), not into the channel.
+ */
+
+bool saveChannelArrow(const DataChannel& channel, const std::string& path, 
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp) 
+{
+    size_t start = channel.lowerBound(lowerBoundTimestamp);
+    size_t end = std::max(start, channel.upperBound(upperBoundTimestamp));
+    auto late = std::lower_bound(channel.m_late.begin(), channel.m_late.end(), lowerBoundTimestamp,
+        [](const DataPoint& dp, Timestamp t) { return dp.m_timestamp < t; });
+    auto lateEnd = std::upper_bound(late, channel.m_late.end(), upperBoundTimestamp,
+        [](Timestamp t, const DataPoint& dp) { return t < dp.m_timestamp; });
+
+    ArrowWriter writer;
+    if (!writer.open(path)) return false;
+
+    std::vector<Timestamp> timestamps(std::min(end - start, ArrowWriter::kBatchRows));
+    std::vector<double> values(timestamps.size());
+    if (late == lateEnd) {
+        for (size_t first = start; first < end; first += ArrowWriter::kBatchRows) {
+            size_t last = std::min(end, first + ArrowWriter::kBatchRows);
+            channel.m_timestamps.decode(first, last, timestamps.data());
+            channel.m_values.decode(first, last, values.data());
+            writer.writeBatch(timestamps.data(), values.data(), last - first);
+        }
+        return writer.close();
+    }
+
+    std::vector<Timestamp> batchTimestamps;
+    std::vector<double> batchValues;
+    batchTimestamps.reserve(ArrowWriter::kBatchRows);
+    batchValues.reserve(ArrowWriter::kBatchRows);
+    auto add = [&](Timestamp timestamp, double value) {
+        batchTimestamps.push_back(timestamp);
+        batchValues.push_back(value);
+        if (batchTimestamps.size() == ArrowWriter::kBatchRows) {
+            writer.writeBatch(batchTimestamps.data(), batchValues.data(), batchTimestamps.size());
+            batchTimestamps.clear();
+            batchValues.clear();
+        }
+    };
+    for (size_t first = start; first < end; first += ArrowWriter::kBatchRows) {
+        size_t last = std::min(end, first + ArrowWriter::kBatchRows);
+        channel.m_timestamps.decode(first, last, timestamps.data());
+        channel.m_values.decode(first, last, values.data());
+        for (size_t i = 0; i < last - first; i++) {
+            for (; late != lateEnd && late->m_timestamp < timestamps[i]; late++) add(late->m_timestamp, late->m_value);
+            add(timestamps[i], values[i]);
+        }
+    }
+    for (; late != lateEnd; late++) add(late->m_timestamp, late->m_value);
+    if (!batchTimestamps.empty()) writer.writeBatch(batchTimestamps.data(), batchValues.data(), batchTimestamps.size());
+    return writer.close();
+}
+
+/**
+ * @brief Arrow - Columnar export
+ * 
+ * @details Saving a subset returned by retrieveChannelSubsets. The NaN
+ * datapoints left out of the subset are put back in place (as nulls)
+ * from its NaN bitmap, with their timestamps read from the channel
+ * (see ExtractedSubChannel::nanDatapoints).
+ */
+
+bool saveSubChannelArrow(const ExtractedSubChannel& subChannel, const DataChannel& channel, const std::string& path) {
+    ArrowWriter writer;
+    if (!writer.open(path)) return false;
+
+    std::vector<Timestamp> timestamps;
+    std::vector<double> values;
+    timestamps.reserve(std::min(subChannel.m_rangeSize, ArrowWriter::kBatchRows));
+    values.reserve(timestamps.capacity());
+
+    std::vector<DataPoint> nanDatapoints = subChannel.nanDatapoints(channel);
+    size_t valid = 0, nan = 0;
+    for (size_t j = 0; j < subChannel.m_rangeSize; j++) {
+        if ((subChannel.m_nanMask[j / 64] >> (j % 64)) & 1) {
+            timestamps.push_back(nanDatapoints[nan++].m_timestamp);
+            values.push_back(std::numeric_limits<double>::quiet_NaN());
+        } else {
+            timestamps.push_back(subChannel.m_timestamps[valid]);
+            values.push_back(subChannel.m_values[valid]);
+            valid++;
+        }
+        if (timestamps.size() == ArrowWriter::kBatchRows) {
+            writer.writeBatch(timestamps.data(), values.data(), timestamps.size());
+            timestamps.clear();
+            values.clear();
+        }
+    }
+    if (!timestamps.empty()) writer.writeBatch(timestamps.data(), values.data(), timestamps.size());
+    return writer.close();
+}
+
+/**
+ * @brief Arrow - Columnar export
+ * 
+ * @details Saving every channel into its own Arrow file
+ * (../storage/channel_<id>.arrow), reporting the export throughput.
+ */
+
+void saveArrow(std::unordered_map<uint16_t, DataChannel>& channels) {
+    Timer timer("arrow export");
+    uint64_t bytes = 0;
+
+    for (auto& pair : channels) {
+        std::string path = "../storage/channel_" + std::to_string(pair.first) + ".arrow";
+        if (!saveChannelArrow(pair.second, path, std::numeric_limits<Timestamp>::min(), std::numeric_limits<Timestamp>::max())) {
+            std::cout << "Could not write " << path << std::endl;
+            continue;
+        }
+        bytes += pair.second.size() * (sizeof(Timestamp) + sizeof(double));
+    }
+
+    double ms = timer.elapsed();
+    std::cout << "All Channels saved (Arrow): " << bytes / 1e6 << " MB of columns, " 
+              << (ms > 0 ? bytes / 1e3 / ms : 0) << " MB/s" << std::endl;
+}
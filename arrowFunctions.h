@@ -0,0 +1,29 @@
+#ifndef ARROWFUNCTIONS_H
+#define ARROWFUNCTIONS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "arrowWriter.h"
+#include "dataChannel.h"
+#include "extractedSubChannel.h"
+#include "timer.h"
+#include "timestamp.h"
+
+/**
+ * @brief Arrow export functions.
+ * 
+ * @details Columnar alternative to the JSON persistence, for analytics
+ * tools: a channel, or a range of it, is written as an Arrow IPC file
+ * (.arrow / Feather v2) with a timestamp[ns] and a float64 column, NaN
+ * values being nulls. Columns are decoded and written in record batches
+ * of ArrowWriter::kBatchRows, so memory use doesn't grow with the range.
+ */
+
+bool saveChannelArrow(const DataChannel& channel, const std::string& path, 
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp);
+bool saveSubChannelArrow(const ExtractedSubChannel& subChannel, const DataChannel& channel, const std::string& path);
+void saveArrow(std::unordered_map<uint16_t, DataChannel>& channels);
+
+#endif // ARROWFUNCTIONS_H
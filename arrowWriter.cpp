@@ -0,0 +1,216 @@
+#include <cmath>
+
+#include "arrowWriter.h"
+
+namespace {
+
+constexpr uint8_t kHeaderSchema = 1;
+constexpr uint8_t kHeaderRecordBatch = 3;
+constexpr uint8_t kTypeFloatingPoint = 3;
+constexpr uint8_t kTypeTimestamp = 10;
+constexpr int16_t kPrecisionDouble = 2;
+constexpr int16_t kUnitNanosecond = 3;
+constexpr char kMagic[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+
+struct ArrowFieldNode {
+    int64_t m_length;
+    int64_t m_nullCount;
+};
+
+struct ArrowBuffer {
+    int64_t m_offset;
+    int64_t m_length;
+};
+
+size_t padded(size_t size) {
+    return (size + 7) / 8 * 8;
+}
+
+/**
+ * @brief Field table: name, nullable, type (union), empty children.
+ */
+
+size_t writeField(FlatBufferWriter& fb, const std::string& name, bool nullable, uint8_t typeType, int16_t typeValue) {
+    fb.beginTable();
+    fb.addOffset(0);
+    fb.addScalar(1, nullable, 1);
+    fb.addScalar(2, typeType, 1);
+    fb.addOffset(3);
+    fb.addOffset(5);
+    size_t field = fb.endTable();
+    size_t nameAt = fb.fieldPosition(0), typeAt = fb.fieldPosition(3), childrenAt = fb.fieldPosition(5);
+
+    fb.patchOffset(nameAt, fb.addString(name));
+    fb.beginTable();
+    fb.addScalar(0, static_cast<uint16_t>(typeValue), 2); // Timestamp.unit / FloatingPoint.precision
+    fb.patchOffset(typeAt, fb.endTable());
+    fb.patchOffset(childrenAt, fb.addOffsetVector(0));
+    return field;
+}
+
+/**
+ * @brief Schema table (little endian, timestamp + value fields).
+ */
+
+size_t writeSchema(FlatBufferWriter& fb) {
+    fb.beginTable();
+    fb.addScalar(0, 0, 2);
+    fb.addOffset(1);
+    size_t schema = fb.endTable();
+    size_t fieldsAt = fb.fieldPosition(1);
+
+    size_t fields = fb.addOffsetVector(2);
+    fb.patchOffset(fieldsAt, fields);
+    fb.patchOffset(fields + 4, writeField(fb, "timestamp", false, kTypeTimestamp, kUnitNanosecond));
+    fb.patchOffset(fields + 8, writeField(fb, "value", true, kTypeFloatingPoint, kPrecisionDouble));
+    return schema;
+}
+
+/**
+ * @brief Message table; headerAt receives the position of its header field, to link.
+ */
+
+size_t writeMessageTable(FlatBufferWriter& fb, uint8_t headerType, int64_t bodyLength, size_t& headerAt) {
+    fb.beginTable();
+    fb.addScalar(0, ArrowWriter::kMetadataVersion, 2);
+    fb.addScalar(1, headerType, 1);
+    fb.addOffset(2);
+    fb.addScalar(3, static_cast<uint64_t>(bodyLength), 8);
+    size_t message = fb.endTable();
+    headerAt = fb.fieldPosition(2);
+    return message;
+}
+
+} // namespace
+
+ArrowWriter::~ArrowWriter() {
+    if (m_file.is_open()) close();
+}
+
+bool ArrowWriter::open(const std::string& path) {
+    m_fileBuffer.resize(kFileBufferSize);
+    m_file.rdbuf()->pubsetbuf(m_fileBuffer.data(), m_fileBuffer.size());
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file) return false;
+
+    m_blocks.clear();
+    m_position = 0;
+    m_rows = 0;
+    writeBytes(kMagic, sizeof(kMagic));
+
+    FlatBufferWriter fb;
+    size_t headerAt;
+    size_t message = writeMessageTable(fb, kHeaderSchema, 0, headerAt);
+    fb.patchOffset(headerAt, writeSchema(fb));
+    fb.finish(message);
+    writeMessage(fb);
+    return m_file.good();
+}
+
+/**
+ * @brief Append one record batch.
+ * 
+ * @details Body layout (every buffer 8 byte aligned): timestamp
+ * validity (empty, no nulls), timestamp data, value validity bitmap
+ * (bit i set when value i is not NaN), value data.
+ */
+
+void ArrowWriter::writeBatch(const Timestamp* timestamps, const double* values, size_t size) {
+    m_validity.assign(padded((size + 7) / 8), 0);
+    int64_t nullCount = 0;
+    for (size_t i = 0; i < size; i++) {
+        bool valid = !std::isnan(values[i]);
+        m_validity[i >> 3] |= static_cast<uint8_t>(valid) << (i & 7);
+        nullCount += !valid;
+    }
+    size_t bitmapBytes = nullCount > 0 ? m_validity.size() : 0; // no bitmap needed without nulls
+
+    int64_t dataBytes = static_cast<int64_t>(padded(size * 8));
+    ArrowBuffer buffers[4] = {
+        {0, 0},
+        {0, static_cast<int64_t>(size * 8)},
+        {dataBytes, static_cast<int64_t>(bitmapBytes)},
+        {dataBytes + static_cast<int64_t>(bitmapBytes), static_cast<int64_t>(size * 8)}
+    };
+    ArrowFieldNode nodes[2] = {{static_cast<int64_t>(size), 0}, {static_cast<int64_t>(size), nullCount}};
+    int64_t bodyLength = 2 * dataBytes + static_cast<int64_t>(bitmapBytes);
+
+    FlatBufferWriter fb;
+    size_t headerAt;
+    size_t message = writeMessageTable(fb, kHeaderRecordBatch, bodyLength, headerAt);
+    fb.beginTable();
+    fb.addScalar(0, size, 8);
+    fb.addOffset(1);
+    fb.addOffset(2);
+    size_t batch = fb.endTable();
+    size_t nodesAt = fb.fieldPosition(1), buffersAt = fb.fieldPosition(2);
+    fb.patchOffset(headerAt, batch);
+    fb.patchOffset(nodesAt, fb.addVector(nodes, 2, sizeof(ArrowFieldNode), 8));
+    fb.patchOffset(buffersAt, fb.addVector(buffers, 4, sizeof(ArrowBuffer), 8));
+    fb.finish(message);
+
+    ArrowBlock block{m_position, 0, 0, bodyLength};
+    writeMessage(fb);
+    block.m_metaDataLength = static_cast<int32_t>(m_position - block.m_offset);
+
+    writeBytes(timestamps, size * 8);
+    writePadding(dataBytes - size * 8);
+    writeBytes(m_validity.data(), bitmapBytes);
+    writeBytes(values, size * 8);
+    writePadding(dataBytes - size * 8);
+
+    m_blocks.push_back(block);
+    m_rows += size;
+}
+
+/**
+ * @brief End-of-stream marker, footer (schema + record batch index), footer size and magic.
+ */
+
+bool ArrowWriter::close() {
+    if (!m_file.is_open()) return false;
+
+    const uint32_t endOfStream[2] = {0xFFFFFFFF, 0};
+    writeBytes(endOfStream, sizeof(endOfStream));
+
+    FlatBufferWriter fb;
+    fb.beginTable();
+    fb.addScalar(0, kMetadataVersion, 2);
+    fb.addOffset(1);
+    fb.addOffset(3);
+    size_t footer = fb.endTable();
+    size_t schemaAt = fb.fieldPosition(1), batchesAt = fb.fieldPosition(3);
+    fb.patchOffset(schemaAt, writeSchema(fb));
+    fb.patchOffset(batchesAt, fb.addVector(m_blocks.data(), m_blocks.size(), sizeof(ArrowBlock), 8));
+    fb.finish(footer);
+
+    writeBytes(fb.m_buffer.data(), fb.m_buffer.size());
+    int32_t footerLength = static_cast<int32_t>(fb.m_buffer.size());
+    writeBytes(&footerLength, 4);
+    writeBytes(kMagic, 6);
+
+    m_file.close();
+    return !m_file.fail();
+}
+
+void ArrowWriter::writeBytes(const void* data, size_t size) {
+    m_file.write(static_cast<const char*>(data), size);
+    m_position += size;
+}
+
+void ArrowWriter::writePadding(size_t size) {
+    static const char zeros[8] = {};
+    writeBytes(zeros, size);
+}
+
+/**
+ * @brief Encapsulated message: continuation marker, metadata size, metadata (8 byte aligned).
+ */
+
+void ArrowWriter::writeMessage(const FlatBufferWriter& metadata) {
+    const uint32_t continuation = 0xFFFFFFFF;
+    int32_t length = static_cast<int32_t>(metadata.m_buffer.size());
+    writeBytes(&continuation, 4);
+    writeBytes(&length, 4);
+    writeBytes(metadata.m_buffer.data(), metadata.m_buffer.size());
+}
@@ -0,0 +1,66 @@
+#ifndef ARROWWRITER_H
+#define ARROWWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "flatBufferWriter.h"
+#include "timestamp.h"
+
+/**
+ * @brief Position of a record batch in the file (Arrow footer Block struct).
+ */
+
+struct ArrowBlock {
+    int64_t m_offset;
+    int32_t m_metaDataLength; // including the 8 byte message prefix
+    int32_t m_padding;
+    int64_t m_bodyLength;
+};
+
+/**
+ * @class ArrowWriter
+ * 
+ * @brief Writes a (timestamp, value) series as an Arrow IPC file (Feather v2).
+ * 
+ * Schema: "timestamp" (timestamp[ns], not null) and "value" (float64,
+ * nullable; NaN values are written as nulls with a validity bitmap).
+ * The file is streamed: open() writes the magic and the schema message,
+ * every writeBatch() appends one record batch, and close() writes the
+ * footer that indexes them. The metadata is encoded with the small
+ * FlatBufferWriter, so no Arrow library is needed; readers (pyarrow,
+ * polars, DuckDB...) can memory-map the columns without parsing.
+ * 
+ */
+
+class ArrowWriter {
+
+    public:
+        static constexpr size_t kBatchRows = 64 * 1024;
+        static constexpr int16_t kMetadataVersion = 4; // V5
+        static constexpr size_t kFileBufferSize = 1 << 20;
+
+        std::ofstream m_file;
+        std::vector<char> m_fileBuffer;
+        std::vector<ArrowBlock> m_blocks;
+        std::vector<uint8_t> m_validity;
+        int64_t m_position = 0;
+        uint64_t m_rows = 0;
+
+        ArrowWriter() = default;
+        ~ArrowWriter();
+
+        bool open(const std::string& path);
+        void writeBatch(const Timestamp* timestamps, const double* values, size_t size);
+        bool close();
+
+    private:
+        void writeBytes(const void* data, size_t size);
+        void writePadding(size_t size);
+        void writeMessage(const FlatBufferWriter& metadata);
+};
+
+#endif // ARROWWRITER_H
@@ -0,0 +1,68 @@
+#include <tuple>
+
+#include "asyncFileWriter.h"
+
+AsyncFileWriter::AsyncFileWriter(Executor& executor)
+    : m_executor(executor), m_thread([this] { ioLoop(); }) {}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    close();
+}
+
+AsyncFileWriter::AppendAwaiter AsyncFileWriter::append(const std::string& path, std::vector<char> data) {
+    return AppendAwaiter{*this, path, std::move(data)};
+}
+
+void AsyncFileWriter::AppendAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    // The coroutine (and this awaiter) can be resumed as soon as the request is queued
+    AsyncFileWriter& writer = m_writer;
+    {
+        std::lock_guard<std::mutex> lock(writer.m_mtx);
+        writer.m_requests.emplace_back(handle, this);
+    }
+    writer.m_cv.notify_one();
+}
+
+/**
+ * @brief Wait for the pending writes, then flush and close the files.
+ */
+
+void AsyncFileWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_closing = true;
+    }
+    m_cv.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+/**
+ * @brief I/O thread: write the requests in order and resume their coroutines on the executor.
+ */
+
+void AsyncFileWriter::ioLoop() {
+    while (true) {
+        std::coroutine_handle<> handle;
+        AppendAwaiter* request;
+        {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_cv.wait(lock, [this] { return !m_requests.empty() || m_closing; });
+            if (m_requests.empty()) break;
+            std::tie(handle, request) = m_requests.front();
+            m_requests.pop_front();
+        }
+
+        auto it = m_files.find(request->m_path);
+        if (it == m_files.end()) {
+            it = m_files.emplace(request->m_path, std::ofstream(request->m_path, std::ios::binary | std::ios::trunc)).first;
+        }
+        it->second.write(request->m_data.data(), request->m_data.size());
+        request->m_written = it->second.good();
+        m_bytesWritten += request->m_data.size();
+        m_writes++;
+        m_executor.post(handle);
+    }
+
+    for (auto& file : m_files) file.second.close();
+    m_files.clear();
+}
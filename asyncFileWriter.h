@@ -0,0 +1,66 @@
+#ifndef ASYNCFILEWRITER_H
+#define ASYNCFILEWRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "executor.h"
+
+/**
+ * @class AsyncFileWriter
+ * 
+ * @brief Asynchronous appends to files, for the persistence stage.
+ * 
+ * co_await append(path, bytes) hands the buffer to a dedicated I/O
+ * thread and suspends the coroutine until the bytes have been written,
+ * so the executor threads never block on the disk. Writes are applied
+ * in submission order. A file is truncated the first time the writer
+ * opens it, and kept open until close(), which waits for the pending
+ * writes, flushes and closes every file (deterministic flush).
+ * 
+ */
+
+class AsyncFileWriter {
+
+    public:
+        struct AppendAwaiter {
+            AsyncFileWriter& m_writer;
+            std::string m_path;
+            std::vector<char> m_data;
+            bool m_written = false;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle);
+            bool await_resume() const noexcept { return m_written; }
+        };
+
+        Executor& m_executor;
+        std::deque<std::pair<std::coroutine_handle<>, AppendAwaiter*>> m_requests;
+        std::unordered_map<std::string, std::ofstream> m_files;
+        std::atomic<uint64_t> m_bytesWritten{0};
+        std::atomic<uint64_t> m_writes{0};
+        bool m_closing = false;
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+        std::thread m_thread;
+
+        explicit AsyncFileWriter(Executor& executor);
+        ~AsyncFileWriter();
+
+        AppendAwaiter append(const std::string& path, std::vector<char> data);
+        void close();
+
+    private:
+        void ioLoop();
+};
+
+#endif // ASYNCFILEWRITER_H
@@ -0,0 +1,273 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+
+#include "asyncFileWriter.h"
+#include "asyncPipeline.h"
+#include "asyncQueue.h"
+#include "dataCollector.h"
+#include "executor.h"
+#include "task.h"
+#include "timer.h"
+
+namespace {
+
+using Clock = Executor::Clock;
+
+struct PersistChunk {
+    uint16_t m_id;
+    std::vector<char> m_bytes;
+};
+
+/**
+ * @brief Everything the stages share; outlives them (runAsyncPipeline joins the executor).
+ */
+
+struct AsyncPipelineState {
+    const GeneratorConfig& m_generatorConfig;
+    const AsyncPipelineConfig& m_config;
+    Executor& m_executor;
+    AsyncFileWriter& m_writer;
+    std::vector<std::unique_ptr<AsyncQueue<std::vector<DataInput>>>> m_queues;
+    AsyncQueue<PersistChunk> m_persistQueue;
+    std::vector<std::unordered_map<uint16_t, DataChannel>> m_shards;
+    std::vector<uint64_t> m_generated;
+    std::atomic<unsigned> m_generatorsLeft;
+    std::atomic<unsigned> m_collectorsLeft;
+    std::atomic<uint64_t> m_persisted{0};
+    Clock::time_point m_start;
+    Clock::time_point m_generatorsDone;
+    Clock::time_point m_collectorsDone;
+
+    AsyncPipelineState(const GeneratorConfig& generatorConfig, const AsyncPipelineConfig& config, 
+        Executor& executor, AsyncFileWriter& writer)
+        : m_generatorConfig(generatorConfig), m_config(config), m_executor(executor), m_writer(writer),
+          m_persistQueue(executor, config.m_queueCapacity),
+          m_shards(std::max(1u, config.m_numCollectors)),
+          m_generated(std::max(1u, config.m_generatorTasks), 0),
+          m_generatorsLeft(static_cast<unsigned>(m_generated.size())),
+          m_collectorsLeft(static_cast<unsigned>(m_shards.size())),
+          m_start(Clock::now()) 
+    {
+        for (size_t i = 0; i < m_shards.size(); i++) {
+            m_queues.push_back(std::make_unique<AsyncQueue<std::vector<DataInput>>>(executor, config.m_queueCapacity));
+        }
+    }
+};
+
+// Block header: uint32 count + 4 bytes of padding, so the columns after it stay 8 byte aligned
+constexpr size_t kChunkHeader = 8;
+
+/**
+ * @brief Datapoints [first, last) of a channel, encoded as a persisted block.
+ *
+ * @details The columns are decoded in place: the buffer comes from
+ * operator new (aligned for any scalar) and the header is padded to
+ * 8 bytes, so the int64 and double pointers are properly aligned.
+ */
+
+PersistChunk encodeChunk(const DataChannel& channel, size_t first, size_t last) {
+    uint32_t count = static_cast<uint32_t>(last - first);
+    PersistChunk chunk{channel.m_id, std::vector<char>(kChunkHeader + count * (sizeof(Timestamp) + sizeof(double)))};
+    char* out = chunk.m_bytes.data();
+    std::memcpy(out, &count, 4);
+    static_assert(kChunkHeader % alignof(Timestamp) == 0 && kChunkHeader % alignof(double) == 0);
+    channel.m_timestamps.decode(first, last, reinterpret_cast<Timestamp*>(out + kChunkHeader));
+    channel.m_values.decode(first, last, reinterpret_cast<double*>(out + kChunkHeader + count * sizeof(Timestamp)));
+    return chunk;
+}
+
+/**
+ * @brief Generator stage: the channels [startIndex, endIndex), routed to the collector queues.
+ */
+
+Task generatorTask(AsyncPipelineState& state, unsigned index, uint16_t startIndex, uint16_t endIndex, uint32_t seed) {
+    const GeneratorConfig& config = state.m_generatorConfig;
+    const size_t numQueues = state.m_queues.size();
+    std::mt19937 gen(seed);
+    std::vector<DataInput> batch;
+    std::vector<std::vector<DataInput>> routed(numQueues);
+    uint64_t generated = 0;
+
+    const Timestamp duration = fromMilliseconds(config.m_duration);
+    const double basePeriod = config.basePeriod();
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(basePeriod));
+    const Clock::time_point startTime = Clock::now();
+    for (uint64_t tick = 1; ; tick++) {
+
+        Timestamp timestamp;
+        if (config.m_paced) {
+            // Absolute deadlines: a late tick doesn't delay the following ones
+            co_await state.m_executor.sleepUntil(startTime + static_cast<int64_t>(tick - 1) * period);
+            timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count();
+        } else {
+            timestamp = fromMilliseconds((tick - 1) * basePeriod);
+        }
+        if (timestamp >= duration) break;
+
+        batch.clear();
+        generateTick(config, tick, timestamp, batch, startIndex, endIndex, gen);
+        generated += batch.size();
+        for (DataInput& input : batch) routed[input.m_id % numQueues].push_back(std::move(input));
+        for (size_t q = 0; q < numQueues; q++) {
+            if (routed[q].empty()) continue;
+            co_await state.m_queues[q]->push(std::move(routed[q]));
+            routed[q] = std::vector<DataInput>();
+        }
+    }
+
+    state.m_generated[index] = generated;
+    if (--state.m_generatorsLeft == 0) {
+        state.m_generatorsDone = Clock::now();
+        for (auto& queue : state.m_queues) queue->close();
+    }
+}
+
+/**
+ * @brief Persist what's left of a collector's channels once its queue is drained.
+ */
+
+Task flushShard(AsyncPipelineState& state, std::unordered_map<uint16_t, DataChannel>& channels, 
+    std::unordered_map<uint16_t, size_t>& persisted) 
+{
+    for (auto& pair : channels) {
+        pair.second.mergeLate();
+        size_t first = persisted[pair.first];
+        if (pair.second.size() > first) {
+            co_await state.m_persistQueue.push(encodeChunk(pair.second, first, pair.second.size()));
+            persisted[pair.first] = pair.second.size();
+        }
+    }
+}
+
+/**
+ * @brief Collector stage: stores the batches of its queue, hands full chunks to the persister.
+ */
+
+Task collectorTask(AsyncPipelineState& state, unsigned index) {
+    std::unordered_map<uint16_t, DataChannel>& channels = state.m_shards[index];
+    std::unordered_map<uint16_t, size_t> persisted;
+    const bool persist = !state.m_config.m_persistDirectory.empty();
+    const size_t chunk = std::max<size_t>(1, state.m_config.m_persistChunk);
+
+    while (std::optional<std::vector<DataInput>> batch = co_await state.m_queues[index]->pop()) {
+        for (DataInput& input : *batch) {
+            auto it = channels.find(input.m_id);
+            if (it == channels.end()) it = channels.emplace(input.m_id, DataChannel(input.m_id, input.m_name, input.m_unit)).first;
+            DataChannel& channel = it->second;
+            channel.insert(input.m_dp);
+
+            size_t& first = persisted[input.m_id];
+            if (persist && channel.size() - first >= chunk) {
+                co_await state.m_persistQueue.push(encodeChunk(channel, first, channel.size()));
+                first = channel.size();
+            }
+        }
+    }
+    if (persist) co_await flushShard(state, channels, persisted);
+
+    if (--state.m_collectorsLeft == 0) {
+        state.m_collectorsDone = Clock::now();
+        state.m_persistQueue.close();
+    }
+}
+
+/**
+ * @brief Persist stage: appends the chunks to the channel files.
+ */
+
+Task persisterTask(AsyncPipelineState& state) {
+    const std::filesystem::path directory(state.m_config.m_persistDirectory);
+    while (std::optional<PersistChunk> chunk = co_await state.m_persistQueue.pop()) {
+        std::string path = (directory / ("channel_" + std::to_string(chunk->m_id) + ".bin")).string();
+        uint32_t count;
+        std::memcpy(&count, chunk->m_bytes.data(), 4);
+        if (co_await state.m_writer.append(path, std::move(chunk->m_bytes))) state.m_persisted += count;
+    }
+}
+
+double millisecondsBetween(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+double AsyncPipelineReport::throughput() const {
+    return m_elapsed > 0 ? m_generated / (m_elapsed / 1e3) : 0.0;
+}
+
+/**
+ * @brief Run generation + collection (+ persistence) as coroutines.
+ * 
+ * @param generatorConfig 
+ * @param config 
+ * @param channels filled with the collected channels of every collector
+ * @return AsyncPipelineReport 
+ */
+
+AsyncPipelineReport runAsyncPipeline(
+    const GeneratorConfig& generatorConfig,
+    const AsyncPipelineConfig& config,
+    std::unordered_map<uint16_t, DataChannel>& channels)
+{
+    Timer timer("async pipeline");
+    if (!generatorConfig.valid()) {
+        std::cerr << "Invalid generator config: every group and channel rate must be positive" << std::endl;
+        return AsyncPipelineReport();
+    }
+    uint32_t seed = generatorConfig.m_seed != 0 ? generatorConfig.m_seed : std::random_device{}();
+    if (!config.m_persistDirectory.empty()) std::filesystem::create_directories(config.m_persistDirectory);
+
+    Executor executor(config.m_executorThreads);
+    AsyncFileWriter writer(executor);
+    AsyncPipelineState state(generatorConfig, config, executor, writer);
+
+    const unsigned numGenerators = static_cast<unsigned>(state.m_generated.size());
+    for (unsigned i = 0; i < state.m_shards.size(); i++) executor.spawn(collectorTask(state, i));
+    executor.spawn(persisterTask(state));
+    for (unsigned j = 0; j < numGenerators; j++) {
+        uint16_t startIndex = static_cast<uint16_t>(j * generatorConfig.m_numChannels / numGenerators);
+        uint16_t endIndex = static_cast<uint16_t>((j + 1) * generatorConfig.m_numChannels / numGenerators);
+        executor.spawn(generatorTask(state, j, startIndex, endIndex, seed + j));
+    }
+
+    executor.join();
+    writer.close();
+    Clock::time_point flushed = Clock::now();
+
+    AsyncPipelineReport report;
+    report.m_resumes = executor.resumed();
+    executor.shutdown();
+
+    for (auto& shard : state.m_shards) {
+        for (auto& pair : shard) channels.insert_or_assign(pair.first, std::move(pair.second));
+    }
+    report.m_generated = std::accumulate(state.m_generated.begin(), state.m_generated.end(), uint64_t(0));
+    report.m_persisted = state.m_persisted;
+    report.m_bytesWritten = writer.m_bytesWritten;
+    report.m_suspensions = state.m_persistQueue.m_suspendedPushes + state.m_persistQueue.m_suspendedPops;
+    for (auto& queue : state.m_queues) report.m_suspensions += queue->m_suspendedPushes + queue->m_suspendedPops;
+    report.m_generateMs = millisecondsBetween(state.m_start, state.m_generatorsDone);
+    report.m_drainMs = millisecondsBetween(state.m_generatorsDone, state.m_collectorsDone);
+    report.m_flushMs = millisecondsBetween(state.m_collectorsDone, flushed);
+    report.m_elapsed = timer.elapsed();
+    return report;
+}
+
+/**
+ * @brief Print throughput, persistence and shutdown timings of an async pipeline run.
+ */
+
+void printAsyncPipelineReport(const std::string& name, const AsyncPipelineReport& report) {
+    std::cout << name << ": " << report.m_generated << " datapoints in " << report.m_elapsed << " ms (";
+    std::cout << report.throughput() << " datapoints/s)" << std::endl;
+    std::cout << "  Persisted " << report.m_persisted << " datapoints (" << report.m_bytesWritten << " bytes)" << std::endl;
+    std::cout << "  Coroutine resumes: " << report.m_resumes << ", queue suspensions: " << report.m_suspensions << std::endl;
+    std::cout << "  Generation " << report.m_generateMs << " ms, drain " << report.m_drainMs;
+    std::cout << " ms, flush " << report.m_flushMs << " ms" << std::endl;
+}
@@ -0,0 +1,65 @@
+#ifndef ASYNCPIPELINE_H
+#define ASYNCPIPELINE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dataChannel.h"
+#include "generatorConfig.h"
+
+/**
+ * @brief Coroutine pipeline: generate -> collect -> persist.
+ * 
+ * @details The stages are coroutine Tasks on a small Executor instead
+ * of one thread each: m_generatorTasks generators (each one a slice of
+ * the channels; paced runs wait for their next tick with a timer, not
+ * a sleeping thread), m_numCollectors collectors (each one owning the
+ * channels with id % m_numCollectors == i, so no channel lock) and a
+ * persister, connected by AsyncQueues. When m_persistDirectory is set,
+ * every m_persistChunk new datapoints of a channel are appended to
+ * <dir>/channel_<id>.bin through the AsyncFileWriter, as a block of
+ * (uint32 count, 4 bytes of padding, count int64 timestamps, count
+ * double values).
+ * 
+ * Shutdown is ordered: the last generator closes the collector queues,
+ * the collectors drain them and flush their partial chunks, the last
+ * collector closes the persist queue, and the file writer is closed
+ * once the persister is done. The report times each phase.
+ */
+
+class AsyncPipelineConfig {
+
+    public:
+        unsigned m_executorThreads = 2;
+        unsigned m_generatorTasks = 4;
+        unsigned m_numCollectors = 4;
+        size_t m_queueCapacity = 256; // batches (one tick of a generator)
+        size_t m_persistChunk = 4096; // datapoints
+        std::string m_persistDirectory; // empty -> no persistence
+
+        AsyncPipelineConfig() = default;
+};
+
+class AsyncPipelineReport {
+
+    public:
+        uint64_t m_generated = 0;
+        uint64_t m_persisted = 0;
+        uint64_t m_bytesWritten = 0;
+        uint64_t m_resumes = 0; // coroutine resumptions by the executor
+        uint64_t m_suspensions = 0; // stage suspended on a full / empty queue
+        double m_elapsed = 0.0; // in milliseconds
+        double m_generateMs = 0.0; // until the last generator is done
+        double m_drainMs = 0.0; // then until the collectors are drained and flushed
+        double m_flushMs = 0.0; // then until every file is written and closed
+
+        double throughput() const;
+};
+
+AsyncPipelineReport runAsyncPipeline(const GeneratorConfig& generatorConfig, const AsyncPipelineConfig& config,
+    std::unordered_map<uint16_t, DataChannel>& channels);
+void printAsyncPipelineReport(const std::string& name, const AsyncPipelineReport& report);
+
+#endif // ASYNCPIPELINE_H
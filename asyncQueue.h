@@ -0,0 +1,154 @@
+#ifndef ASYNCQUEUE_H
+#define ASYNCQUEUE_H
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "executor.h"
+
+/**
+ * @class AsyncQueue
+ * 
+ * @brief Bounded FIFO between coroutines (the awaitable counterpart of DataQueue).
+ * 
+ * co_await push(value) suspends the producer while the queue is full
+ * and co_await pop() suspends the consumer while it is empty, instead
+ * of blocking their thread; the waiting coroutine is resumed on the
+ * Executor when the other side makes progress. A value is handed
+ * straight to a waiting consumer when there is one. After close(),
+ * pop() drains the remaining values and then returns std::nullopt, and
+ * push() returns false.
+ * 
+ */
+
+template <typename T>
+class AsyncQueue {
+
+    public:
+        struct PushAwaiter {
+            AsyncQueue& m_queue;
+            T m_value;
+            bool m_accepted = false;
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle);
+            bool await_resume() const noexcept { return m_accepted; }
+        };
+
+        struct PopAwaiter {
+            AsyncQueue& m_queue;
+            std::optional<T> m_value;
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle);
+            std::optional<T> await_resume() { return std::move(m_value); }
+        };
+
+        Executor& m_executor;
+        size_t m_capacity;
+        std::deque<T> m_items;
+        std::deque<std::pair<std::coroutine_handle<>, PushAwaiter*>> m_pushers;
+        std::deque<std::pair<std::coroutine_handle<>, PopAwaiter*>> m_poppers;
+        bool m_closed = false;
+        uint64_t m_suspendedPushes = 0;
+        uint64_t m_suspendedPops = 0;
+        mutable std::mutex m_mtx;
+
+        AsyncQueue(Executor& executor, size_t capacity);
+
+        PushAwaiter push(T value);
+        PopAwaiter pop();
+        void close();
+        size_t size() const;
+};
+
+template <typename T>
+AsyncQueue<T>::AsyncQueue(Executor& executor, size_t capacity)
+    : m_executor(executor), m_capacity(capacity > 0 ? capacity : 1) {}
+
+template <typename T>
+typename AsyncQueue<T>::PushAwaiter AsyncQueue<T>::push(T value) {
+    return PushAwaiter{*this, std::move(value)};
+}
+
+template <typename T>
+typename AsyncQueue<T>::PopAwaiter AsyncQueue<T>::pop() {
+    return PopAwaiter{*this, std::nullopt};
+}
+
+/**
+ * @brief Hand the value to a waiting consumer, queue it, or suspend while the queue is full.
+ */
+
+template <typename T>
+bool AsyncQueue<T>::PushAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    std::lock_guard<std::mutex> lock(m_queue.m_mtx);
+    if (m_queue.m_closed) return false;
+    m_accepted = true;
+    if (!m_queue.m_poppers.empty()) {
+        auto [popper, awaiter] = m_queue.m_poppers.front();
+        m_queue.m_poppers.pop_front();
+        awaiter->m_value = std::move(m_value);
+        m_queue.m_executor.post(popper);
+        return false;
+    }
+    if (m_queue.m_items.size() < m_queue.m_capacity) {
+        m_queue.m_items.push_back(std::move(m_value));
+        return false;
+    }
+    m_accepted = false;
+    m_queue.m_pushers.emplace_back(handle, this);
+    m_queue.m_suspendedPushes++;
+    return true;
+}
+
+/**
+ * @brief Take the oldest value (making room for a waiting producer), or suspend while empty.
+ */
+
+template <typename T>
+bool AsyncQueue<T>::PopAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    std::lock_guard<std::mutex> lock(m_queue.m_mtx);
+    if (!m_queue.m_items.empty()) {
+        m_value = std::move(m_queue.m_items.front());
+        m_queue.m_items.pop_front();
+        if (!m_queue.m_pushers.empty()) {
+            auto [pusher, awaiter] = m_queue.m_pushers.front();
+            m_queue.m_pushers.pop_front();
+            m_queue.m_items.push_back(std::move(awaiter->m_value));
+            awaiter->m_accepted = true;
+            m_queue.m_executor.post(pusher);
+        }
+        return false;
+    }
+    if (m_queue.m_closed) return false;
+    m_queue.m_poppers.emplace_back(handle, this);
+    m_queue.m_suspendedPops++;
+    return true;
+}
+
+/**
+ * @brief Close the queue, resuming every waiting coroutine.
+ */
+
+template <typename T>
+void AsyncQueue<T>::close() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_closed = true;
+    for (auto& popper : m_poppers) m_executor.post(popper.first);
+    for (auto& pusher : m_pushers) m_executor.post(pusher.first);
+    m_poppers.clear();
+    m_pushers.clear();
+}
+
+template <typename T>
+size_t AsyncQueue<T>::size() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_items.size();
+}
+
+#endif // ASYNCQUEUE_H
@@ -0,0 +1,22 @@
+#include <cmath>
+#include <limits>
+
+#include "blockSummary.h"
+
+BlockSummary::BlockSummary()
+    : m_min(std::numeric_limits<double>::infinity()),
+      m_max(-std::numeric_limits<double>::infinity()) {}
+
+void BlockSummary::add(const DataPoint& dp) {
+    m_count++;
+    if (std::isnan(dp.m_value)) {
+        m_nanCount++;
+        return;
+    }
+    if (dp.m_value < m_min) m_min = dp.m_value;
+    if (dp.m_value > m_max) m_max = dp.m_value;
+}
+
+bool BlockSummary::allNan() const {
+    return m_nanCount == m_count;
+}
@@ -0,0 +1,38 @@
+#ifndef BLOCKSUMMARY_H
+#define BLOCKSUMMARY_H
+
+#include <cstdint>
+
+#include "dataPoint.h"
+#include "quantileSketch.h"
+
+/**
+ * @class BlockSummary
+ * 
+ * @brief Zone map of a block of datapoints of a channel.
+ * 
+ * Minimum and maximum of the valid (non NaN) values of the block,
+ * together with the number of datapoints and of NaN values. Value
+ * predicate queries use it to skip whole blocks that can't contain
+ * a match. A block with only NaN values has m_min > m_max. Once the
+ * block is full (sealed), m_sketch summarizes the distribution of its
+ * values for approximate percentile queries.
+ * 
+ */
+
+class BlockSummary {
+
+    public:
+        double m_min;
+        double m_max;
+        uint32_t m_count = 0;
+        uint32_t m_nanCount = 0;
+        QuantileSketch m_sketch;
+
+        BlockSummary();
+
+        void add(const DataPoint& dp);
+        bool allNan() const;
+};
+
+#endif // BLOCKSUMMARY_H
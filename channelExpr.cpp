@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <sstream>
+
+#include "channelExpr.h"
+
+ChannelExpr ChannelExpr::channel(uint16_t id) {
+    ChannelExpr expr;
+    expr.m_op = ExprOp::Channel;
+    expr.m_channelId = id;
+    return expr;
+}
+
+ChannelExpr ChannelExpr::constant(double value) {
+    ChannelExpr expr;
+    expr.m_op = ExprOp::Constant;
+    expr.m_constant = value;
+    return expr;
+}
+
+ChannelExpr ChannelExpr::binary(ExprOp op, const ChannelExpr& left, const ChannelExpr& right) {
+    ChannelExpr expr;
+    expr.m_op = op;
+    expr.m_operands = {left, right};
+    return expr;
+}
+
+/**
+ * @brief Mean of the (non NaN) values of the operand in (t - window, t].
+ */
+
+ChannelExpr ChannelExpr::movingAverage(const ChannelExpr& operand, Timestamp window) {
+    ChannelExpr expr;
+    expr.m_op = ExprOp::MovingAverage;
+    expr.m_window = window;
+    expr.m_operands = {operand};
+    return expr;
+}
+
+/**
+ * @brief Channels used by the expression, in order of appearance (no repeats).
+ * 
+ * @details The first one is the reference channel, whose timestamps
+ * are the timestamps of the result.
+ */
+
+std::vector<uint16_t> ChannelExpr::channelIds() const {
+    std::vector<uint16_t> ids;
+    if (m_op == ExprOp::Channel) ids.push_back(m_channelId);
+    for (const ChannelExpr& operand : m_operands) {
+        for (uint16_t id : operand.channelIds()) {
+            if (std::find(ids.begin(), ids.end(), id) == ids.end()) ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+/**
+ * @brief How far before a timestamp the expression needs data (nested windows add up).
+ */
+
+Timestamp ChannelExpr::lookback() const {
+    Timestamp lookback = 0;
+    for (const ChannelExpr& operand : m_operands) lookback = std::max(lookback, operand.lookback());
+    return m_op == ExprOp::MovingAverage ? lookback + m_window : lookback;
+}
+
+std::string ChannelExpr::toString() const {
+    std::ostringstream out;
+    switch (m_op) {
+        case ExprOp::Channel: out << "ch" << m_channelId; break;
+        case ExprOp::Constant: out << m_constant; break;
+        case ExprOp::Add: out << "(" << m_operands[0].toString() << " + " << m_operands[1].toString() << ")"; break;
+        case ExprOp::Subtract: out << "(" << m_operands[0].toString() << " - " << m_operands[1].toString() << ")"; break;
+        case ExprOp::Multiply: out << "(" << m_operands[0].toString() << " * " << m_operands[1].toString() << ")"; break;
+        case ExprOp::Divide: out << "(" << m_operands[0].toString() << " / " << m_operands[1].toString() << ")"; break;
+        case ExprOp::MovingAverage: 
+            out << "movingAverage(" << m_operands[0].toString() << ", " << toMilliseconds(m_window) << " ms)"; 
+            break;
+    }
+    return out.str();
+}
+
+ChannelExpr operator+(const ChannelExpr& left, const ChannelExpr& right) {
+    return ChannelExpr::binary(ExprOp::Add, left, right);
+}
+
+ChannelExpr operator-(const ChannelExpr& left, const ChannelExpr& right) {
+    return ChannelExpr::binary(ExprOp::Subtract, left, right);
+}
+
+ChannelExpr operator*(const ChannelExpr& left, const ChannelExpr& right) {
+    return ChannelExpr::binary(ExprOp::Multiply, left, right);
+}
+
+ChannelExpr operator/(const ChannelExpr& left, const ChannelExpr& right) {
+    return ChannelExpr::binary(ExprOp::Divide, left, right);
+}
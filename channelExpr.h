@@ -0,0 +1,56 @@
+#ifndef CHANNELEXPR_H
+#define CHANNELEXPR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "timestamp.h"
+
+/**
+ * @brief Operation of a node of a derived-channel expression.
+ */
+
+enum class ExprOp : uint8_t { Channel, Constant, Add, Subtract, Multiply, Divide, MovingAverage };
+
+/**
+ * @class ChannelExpr
+ * 
+ * @brief Expression over channels, e.g. ch3 - ch16 or movingAverage(ch45, 500 ms).
+ * 
+ * Leaves are channels or constants, inner nodes are arithmetic (binary)
+ * or a moving average over a time window. The expression only describes
+ * the computation: it's evaluated by retrieveDerivedChannel, on the
+ * timeline of its first channel (the reference channel), the other
+ * channels being aligned by sample-and-hold. NaN propagates through
+ * arithmetic and is ignored by moving averages.
+ * 
+ */
+
+class ChannelExpr {
+
+    public:
+        ExprOp m_op = ExprOp::Constant;
+        uint16_t m_channelId = 0;
+        double m_constant = 0.0;
+        Timestamp m_window = 0;
+        std::vector<ChannelExpr> m_operands;
+
+        ChannelExpr() = default;
+
+        static ChannelExpr channel(uint16_t id);
+        static ChannelExpr constant(double value);
+        static ChannelExpr binary(ExprOp op, const ChannelExpr& left, const ChannelExpr& right);
+        static ChannelExpr movingAverage(const ChannelExpr& operand, Timestamp window);
+
+        std::vector<uint16_t> channelIds() const;
+        Timestamp lookback() const;
+        std::string toString() const;
+};
+
+ChannelExpr operator+(const ChannelExpr& left, const ChannelExpr& right);
+ChannelExpr operator-(const ChannelExpr& left, const ChannelExpr& right);
+ChannelExpr operator*(const ChannelExpr& left, const ChannelExpr& right);
+ChannelExpr operator/(const ChannelExpr& left, const ChannelExpr& right);
+
+#endif // CHANNELEXPR_H
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "channelLog.h"
+
+ChannelLog::~ChannelLog() {
+    waitCompaction();
+    if (m_fd >= 0) {
+        sync();
+        ::close(m_fd);
+    }
+    else if (m_retiredFd >= 0) {
+        ::fdatasync(m_retiredFd);
+        ::close(m_retiredFd);
+    }
+}
+
+/**
+ * @brief Open the log directory, starting a new file after the existing ones.
+ */
+
+bool ChannelLog::open(const std::string& directory) {
+    std::filesystem::create_directories(directory);
+    m_directory = directory;
+    std::vector<uint64_t> existing = sequences(directory);
+    m_sequence = existing.empty() ? 1 : existing.back() + 1;
+    return openFile();
+}
+
+/**
+ * @brief Log a datapoint (and its channel, the first time it appears in the file).
+ */
+
+void ChannelLog::append(const DataInput& input) {
+    if (m_defined.insert(input.m_id).second) {
+        uint16_t nameLength = static_cast<uint16_t>(input.m_name.size());
+        LogRecord channel{0, 0.0, input.m_id, kLogChannel, static_cast<uint32_t>(2 + input.m_name.size() + input.m_unit.size())};
+        write(&channel, sizeof(channel));
+        write(&nameLength, 2);
+        write(input.m_name.data(), input.m_name.size());
+        write(input.m_unit.data(), input.m_unit.size());
+        m_bytes += sizeof(channel) + channel.m_length;
+    }
+    LogRecord record{input.m_dp.m_timestamp, input.m_dp.m_value, input.m_id, kLogData, 0};
+    write(&record, sizeof(record));
+    m_bytes += sizeof(record);
+}
+
+/**
+ * @brief Write the buffered records to the file.
+ */
+
+bool ChannelLog::flush() {
+    const char* data = m_buffer.data();
+    size_t left = m_buffer.size();
+    while (left > 0) {
+        ssize_t written = ::write(m_fd, data, left);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+    m_buffer.clear();
+    return true;
+}
+
+/**
+ * @brief Write the buffered records and wait until the file is on disk.
+ *
+ * @details The file closed by the last rotate(), if any, is synced and
+ * closed first.
+ */
+
+bool ChannelLog::sync() {
+    bool synced = true;
+    if (m_retiredFd >= 0) {
+        synced = ::fdatasync(m_retiredFd) == 0;
+        ::close(m_retiredFd);
+        m_retiredFd = -1;
+    }
+    if (m_fd < 0) return false;
+    return flush() && ::fdatasync(m_fd) == 0 && synced;
+}
+
+/**
+ * @brief Flush the current file and continue in the next sequence.
+ *
+ * @details The file is synced and closed by the next sync().
+ */
+
+bool ChannelLog::rotate() {
+    if (m_fd >= 0) {
+        if (!flush()) return false;
+        if (m_retiredFd >= 0 && !sync()) return false;
+        m_retiredFd = m_fd;
+        m_fd = -1;
+    }
+    m_sequence++;
+    return openFile();
+}
+
+bool ChannelLog::checkpointDue() const {
+    return m_bytes >= m_checkpointBytes;
+}
+
+/**
+ * @brief Wait for the snapshot compaction in progress, if any.
+ * 
+ * @return false if it failed
+ */
+
+bool ChannelLog::waitCompaction() {
+    return m_compaction.valid() ? m_compaction.get() : true;
+}
+
+std::string ChannelLog::path(const std::string& directory, uint64_t sequence) {
+    return (std::filesystem::path(directory) / ("wal_" + std::to_string(sequence) + ".log")).string();
+}
+
+/**
+ * @brief Sequences of the log files in a directory, in increasing order.
+ */
+
+std::vector<uint64_t> ChannelLog::sequences(const std::string& directory) {
+    std::vector<uint64_t> result;
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = file.path().filename().string();
+        if (name.rfind("wal_", 0) != 0 || file.path().extension() != ".log") continue;
+        result.push_back(std::stoull(name.substr(4, name.size() - 8)));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @brief Read a log file, calling onChannel / onData for every record.
+ * 
+ * @return uint64_t number of data records
+ */
+
+uint64_t ChannelLog::replay(
+    const std::string& path,
+    const std::function<void(uint16_t, const std::string&, const std::string&)>& onChannel,
+    const std::function<void(uint16_t, const DataPoint&)>& onData)
+{
+    std::ifstream file(path, std::ios::binary);
+    uint64_t records = 0;
+    LogRecord record;
+    std::string payload;
+    while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        if (record.m_kind == kLogChannel) {
+            payload.resize(record.m_length);
+            if (record.m_length < 2 || !file.read(payload.data(), record.m_length)) break;
+            uint16_t nameLength;
+            std::memcpy(&nameLength, payload.data(), 2);
+            if (2u + nameLength > payload.size()) break;
+            onChannel(record.m_id, payload.substr(2, nameLength), payload.substr(2 + nameLength));
+        } else {
+            onData(record.m_id, DataPoint(record.m_timestamp, record.m_value));
+            records++;
+        }
+    }
+    return records;
+}
+
+void ChannelLog::write(const void* data, size_t size) {
+    if (m_buffer.size() + size > kFileBufferSize) flush();
+    const char* bytes = static_cast<const char*>(data);
+    m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+}
+
+bool ChannelLog::openFile() {
+    m_buffer.reserve(kFileBufferSize);
+    m_buffer.clear();
+    m_fd = ::open(path(m_directory, m_sequence).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    m_bytes = 0;
+    m_defined.clear();
+    return m_fd >= 0;
+}
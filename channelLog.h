@@ -0,0 +1,100 @@
+#ifndef CHANNELLOG_H
+#define CHANNELLOG_H
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "dataInput.h"
+#include "dataPoint.h"
+
+/**
+ * @brief Fixed size record of the channel log (24 bytes, little endian).
+ * 
+ * Data records carry one datapoint. The first time a channel appears in
+ * a log file, a channel record (kind kLogChannel) is written before its
+ * data, followed by m_length bytes: uint16 name length, name, unit.
+ */
+
+struct LogRecord {
+    int64_t m_timestamp;
+    double m_value;
+    uint16_t m_id;
+    uint16_t m_kind;
+    uint32_t m_length;
+};
+
+/**
+ * @class ChannelLog
+ * 
+ * @brief Append-only log of the datapoints stored since the last snapshot.
+ * 
+ * The log is split in files <dir>/wal_<sequence>.log. A checkpoint
+ * (see snapshotFunctions) rotates to the next sequence, saves a
+ * snapshot that covers everything before it and deletes the older
+ * files, so recovery only has to replay the logs from the snapshot's
+ * sequence on. open() always starts a new file after the existing
+ * ones, and replay() stops at a torn (incomplete) last record.
+ * 
+ * Records are buffered in m_buffer: flush() writes them to the file
+ * and sync() also makes them durable (fdatasync). The collector syncs
+ * once per batch (group commit), so a crash loses at most the batch
+ * being stored. rotate() only flushes the file it closes: the next
+ * sync() makes it durable and closes it, so a checkpoint taken under
+ * the channels lock doesn't wait for the disk.
+ * 
+ * The log also keeps the state of the snapshot chain: the size of the
+ * base (last full snapshot) and of the deltas written since, and the
+ * background compaction in progress (see checkpoint).
+ * 
+ */
+
+class ChannelLog {
+
+    public:
+        static constexpr uint16_t kLogData = 0;
+        static constexpr uint16_t kLogChannel = 1;
+        static constexpr uint64_t kDefaultCheckpointBytes = 16 << 20;
+        static constexpr size_t kFileBufferSize = 1 << 16;
+
+        std::string m_directory;
+        uint64_t m_sequence = 0;
+        uint64_t m_bytes = 0; // written to the current file
+        uint64_t m_checkpointBytes = kDefaultCheckpointBytes;
+        uint64_t m_checkpoints = 0;
+        uint64_t m_baseBytes = 0;
+        uint64_t m_deltaBytes = 0;
+        uint64_t m_compactions = 0;
+        uint64_t m_checkpointFailures = 0;
+        std::future<bool> m_compaction;
+        std::unordered_set<uint16_t> m_defined;
+        std::vector<char> m_buffer;
+        int m_fd = -1;
+        int m_retiredFd = -1; // rotated out, synced and closed by the next sync()
+
+        ChannelLog() = default;
+        ~ChannelLog();
+
+        bool open(const std::string& directory);
+        void append(const DataInput& input);
+        bool flush();
+        bool sync();
+        bool rotate();
+        bool checkpointDue() const;
+        bool waitCompaction();
+
+        static std::string path(const std::string& directory, uint64_t sequence);
+        static std::vector<uint64_t> sequences(const std::string& directory);
+        static uint64_t replay(const std::string& path, 
+            const std::function<void(uint16_t, const std::string&, const std::string&)>& onChannel,
+            const std::function<void(uint16_t, const DataPoint&)>& onData);
+
+    private:
+        void write(const void* data, size_t size);
+        bool openFile();
+};
+
+#endif // CHANNELLOG_H
@@ -0,0 +1,108 @@
+#ifndef CHANNELQUERY_H
+#define CHANNELQUERY_H
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "extractedSubChannel.h"
+#include "timestamp.h"
+
+/**
+ * @brief Query interface shared by every channel layout.
+ *
+ * A channel is queryable when it exposes its identity (m_id, m_name,
+ * m_unit), its number of datapoints and, for an index, the timestamp
+ * and the value (NaN when missing). lowerBound / upperBound locate a
+ * time range: a binary search for DataChannel, index arithmetic for
+ * FixedRateChannel. Range queries are written once against this
+ * concept and specialized by the compiler for each layout.
+ */
+
+template <typename Channel>
+concept QueryableChannel = requires(const Channel& channel, size_t index, Timestamp timestamp) {
+    { channel.m_id } -> std::convertible_to<uint16_t>;
+    { channel.size() } -> std::convertible_to<size_t>;
+    { channel.timestampAt(index) } -> std::convertible_to<Timestamp>;
+    { channel.valueAt(index) } -> std::convertible_to<double>;
+    { channel.lowerBound(timestamp) } -> std::convertible_to<size_t>;
+    { channel.upperBound(timestamp) } -> std::convertible_to<size_t>;
+};
+
+/**
+ * @brief Extracts the datapoints of a channel between 2 timestamps.
+ *
+ * @param channel
+ * @param lowerBoundTimestamp
+ * @param upperBoundTimestamp
+ * @return ExtractedSubChannel
+ *
+ * @details Same output as retrieveChannelSubsets: NaN values (and the
+ * gaps of a fixed-rate channel) are omitted and marked in the NaN
+ * bitmap of the range. DataChannel late datapoints must be merged
+ * first.
+ */
+
+template <QueryableChannel Channel>
+ExtractedSubChannel extractSubset(const Channel& channel, Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp) {
+    ExtractedSubChannel subChannel;
+    subChannel.m_id = channel.m_id;
+    subChannel.m_name = channel.m_name;
+    subChannel.m_unit = channel.m_unit;
+
+    size_t start = channel.lowerBound(lowerBoundTimestamp);
+    size_t size = std::max(start, channel.upperBound(upperBoundTimestamp)) - start;
+    subChannel.m_rangeStart = start;
+    subChannel.m_rangeSize = size;
+    subChannel.m_timestamps.resize(size);
+    subChannel.m_values.resize(size);
+    subChannel.m_nanMask.assign((size + 63) / 64, 0);
+
+    // Branch-free compaction, the output position only advances for valid values
+    size_t valid = 0;
+    for (size_t j = 0; j < size; j++) {
+        double value = channel.valueAt(start + j);
+        bool nan = std::isnan(value);
+        subChannel.m_timestamps[valid] = channel.timestampAt(start + j);
+        subChannel.m_values[valid] = value;
+        subChannel.m_nanMask[j / 64] |= uint64_t(nan) << (j % 64);
+        valid += !nan;
+    }
+    subChannel.m_timestamps.resize(valid);
+    subChannel.m_values.resize(valid);
+    subChannel.m_nanCount = size - valid;
+    return subChannel;
+}
+
+/**
+ * @brief Retrieves subsets of channels of any layout (between 2 timestamps).
+ *
+ * @param channels
+ * @param channelIds
+ * @param lowerBoundTimestamp
+ * @param upperBoundTimestamp
+ * @return std::unordered_map<uint16_t, ExtractedSubChannel>
+ *
+ * @details Generic counterpart of retrieveChannelSubsets (which stays
+ * the overload used for DataChannel maps). Unknown ids are skipped.
+ */
+
+template <QueryableChannel Channel>
+std::unordered_map<uint16_t, ExtractedSubChannel> retrieveChannelSubsets(
+    std::unordered_map<uint16_t, Channel>& channels, const std::vector<uint16_t>& channelIds,
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp)
+{
+    std::unordered_map<uint16_t, ExtractedSubChannel> subsetChannels;
+    for (uint16_t channelId : channelIds) {
+        auto it = channels.find(channelId);
+        if (it == channels.end()) continue;
+        if constexpr (requires { it->second.mergeLate(); }) it->second.mergeLate();
+        subsetChannels.emplace(channelId, extractSubset(it->second, lowerBoundTimestamp, upperBoundTimestamp));
+    }
+    return subsetChannels;
+}
+
+#endif // CHANNELQUERY_H
@@ -1,26 +1,310 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <span>
+
 #include "dataChannel.h"
 
 DataChannel::DataChannel(uint16_t id, const std::string& name, const std::string& unit)
     : m_id(id), m_name(name), m_unit(unit) {
-        m_data.reserve(20000);
+        m_values.m_encoding = ValueEncoding::forUnit(unit);
+        reserve(20000);
     }
 
 DataChannel::DataChannel(DataChannel&& other) noexcept 
     : m_id(other.m_id),
       m_name(std::move(other.m_name)),
       m_unit(std::move(other.m_unit)),
-      m_data(std::move(other.m_data)) {}
+      m_timestamps(std::move(other.m_timestamps)),
+      m_values(std::move(other.m_values)),
+      m_late(std::move(other.m_late)),
+      m_maxLateness(other.m_maxLateness),
+      m_lateCount(other.m_lateCount),
+      m_tooLateCount(other.m_tooLateCount),
+      m_blocks(std::move(other.m_blocks)),
+      m_validity(std::move(other.m_validity)),
+      m_summarized(other.m_summarized),
+      m_persisted(other.m_persisted),
+      m_snapshotted(other.m_snapshotted) {}
 
 DataChannel& DataChannel::operator=(DataChannel&& other) noexcept {
     if (this != &other) {
         m_id = other.m_id;
         m_name = std::move(other.m_name),
         m_unit = std::move(other.m_unit),
-        m_data = std::move(other.m_data),
+        m_timestamps = std::move(other.m_timestamps),
+        m_values = std::move(other.m_values),
+        m_late = std::move(other.m_late);
+        m_maxLateness = other.m_maxLateness;
+        m_lateCount = other.m_lateCount;
+        m_tooLateCount = other.m_tooLateCount;
+        m_blocks = std::move(other.m_blocks);
+        m_validity = std::move(other.m_validity);
+        m_summarized = other.m_summarized;
+        m_persisted = other.m_persisted;
+        m_snapshotted = other.m_snapshotted;
         other.m_id = 0;
         other.m_name.clear();
         other.m_unit.clear();
-        other.m_data.clear(); {}
+        other.m_timestamps.clear();
+        other.m_values.clear();
+        other.m_late.clear();
+        other.m_lateCount = 0;
+        other.m_tooLateCount = 0;
+        other.m_blocks.clear();
+        other.m_validity.clear();
+        other.m_summarized = 0;
+        other.m_persisted = 0;
+        other.m_snapshotted = 0;
     }
     return *this;
-}
\ No newline at end of file
+}
+
+size_t DataChannel::size() const {
+    return m_timestamps.size();
+}
+
+bool DataChannel::empty() const {
+    return m_timestamps.empty();
+}
+
+Timestamp DataChannel::timestampAt(size_t index) const {
+    return m_timestamps.get(index);
+}
+
+double DataChannel::valueAt(size_t index) const {
+    return m_values.get(index);
+}
+
+DataPoint DataChannel::at(size_t index) const {
+    return DataPoint(timestampAt(index), valueAt(index));
+}
+
+/**
+ * @brief Index of the first datapoint with timestamp >= the given one.
+ */
+
+size_t DataChannel::lowerBound(Timestamp timestamp) const {
+    return m_timestamps.lowerBound(timestamp);
+}
+
+/**
+ * @brief Index of the first datapoint with timestamp > the given one.
+ */
+
+size_t DataChannel::upperBound(Timestamp timestamp) const {
+    return m_timestamps.upperBound(timestamp);
+}
+
+/**
+ * @brief Datapoint held by the channel at a timestamp (point lookup).
+ * 
+ * @details Latest datapoint at or before the timestamp, late
+ * datapoints not merged yet included, located with the same
+ * interpolation search as range queries. nullopt before the first
+ * datapoint.
+ */
+
+std::optional<DataPoint> DataChannel::asOf(Timestamp timestamp) const {
+    size_t index = upperBound(timestamp);
+    auto late = std::upper_bound(m_late.begin(), m_late.end(), timestamp,
+        [](Timestamp t, const DataPoint& dp) { return t < dp.m_timestamp; });
+    if (late != m_late.begin() && (index == 0 || std::prev(late)->m_timestamp >= timestampAt(index - 1))) {
+        return *std::prev(late);
+    }
+    if (index == 0) return std::nullopt;
+    return at(index - 1);
+}
+
+/**
+ * @brief Value held by the channel at a timestamp (NaN before the first datapoint).
+ */
+
+double DataChannel::valueAtTime(Timestamp timestamp) const {
+    std::optional<DataPoint> dp = asOf(timestamp);
+    return dp ? dp->m_value : std::numeric_limits<double>::quiet_NaN();
+}
+
+void DataChannel::reserve(size_t size) {
+    m_timestamps.reserve(size);
+    m_values.reserve(size);
+    m_blocks.reserve((size + kBlockSize - 1) / kBlockSize);
+    m_validity.reserve((size + 63) / 64);
+}
+
+/**
+ * @brief Append a datapoint (must not be older than the last one).
+ */
+
+void DataChannel::append(const DataPoint& dp) {
+    m_timestamps.push_back(dp.m_timestamp);
+    m_values.push_back(dp.m_value);
+    summarize();
+}
+
+/**
+ * @brief Keep only the first size datapoints.
+ */
+
+void DataChannel::truncate(size_t size) {
+    m_timestamps.truncate(size);
+    m_values.truncate(size);
+    m_summarized = std::min(m_summarized, size);
+    m_persisted = std::min(m_persisted, size);
+    m_snapshotted = std::min(m_snapshotted, size);
+}
+
+/**
+ * @brief Insert a datapoint, tolerating late arrivals.
+ * 
+ * @param dp 
+ * @return true if the datapoint was stored
+ * @return false if it was too late (and dropped)
+ * 
+ * @details In-order datapoints are appended. Datapoints older
+ * than the newest one, but within m_maxLateness, are inserted in
+ * the sorted side buffer (already quantized to the channel's
+ * encoding), which gets merged when it grows past kLateMergeThreshold.
+ */
+
+bool DataChannel::insert(const DataPoint& dp) {
+    if (empty() || dp.m_timestamp >= m_timestamps.back()) {
+        append(dp);
+        return true;
+    }
+    if (dp.m_timestamp < m_timestamps.back() - m_maxLateness) {
+        m_tooLateCount++;
+        return false;
+    }
+    m_lateCount++;
+    DataPoint late(dp.m_timestamp, m_values.m_encoding.quantize(dp.m_value));
+    auto it = std::upper_bound(m_late.begin(), m_late.end(), late);
+    m_late.insert(it, late);
+    if (m_late.size() >= kLateMergeThreshold) mergeLate();
+    return true;
+}
+
+/**
+ * @brief Merge the late side buffer into the columns.
+ * 
+ * @details Late datapoints are at most m_maxLateness older than
+ * the newest one, so only the tail of the columns from the first
+ * late timestamp onwards is affected: it is taken out, merged with
+ * the side buffer (both sorted) and appended again, keeping the cost
+ * proportional to that tail.
+ */
+
+void DataChannel::mergeLate() {
+    if (m_late.empty()) return;
+    size_t tailIndex = upperBound(m_late.front().m_timestamp);
+
+    std::vector<DataPoint> tail;
+    tail.reserve(size() - tailIndex);
+    for (size_t i = tailIndex; i < size(); i++) tail.push_back(at(i));
+
+    std::vector<DataPoint> merged;
+    merged.reserve(tail.size() + m_late.size());
+    std::merge(tail.begin(), tail.end(), m_late.begin(), m_late.end(), std::back_inserter(merged));
+    m_late.clear();
+
+    truncate(tailIndex);
+    for (const DataPoint& dp : merged) {
+        m_timestamps.push_back(dp.m_timestamp);
+        m_values.push_back(dp.m_value);
+    }
+    summarize();
+}
+
+/**
+ * @brief Change the storage type of the values (re-encoding them).
+ */
+
+void DataChannel::setEncoding(const ValueEncoding& encoding) {
+    mergeLate();
+    m_values.setEncoding(encoding);
+    m_summarized = 0;
+    m_persisted = 0;
+    m_snapshotted = 0;
+    summarize();
+}
+
+/**
+ * @brief Memory used by the timestamp and value columns.
+ */
+
+size_t DataChannel::memoryBytes() const {
+    return m_timestamps.memoryBytes() + m_values.memoryBytes();
+}
+
+/**
+ * @brief Bring the block summaries and the validity bitmap up to date.
+ * 
+ * @details The block containing the first datapoint not summarized
+ * yet is recomputed from its start, and the following ones are built.
+ * When appending, this only adds the new datapoint to the last block.
+ */
+
+void DataChannel::summarize() {
+    if (m_summarized > size()) m_summarized = size() / kBlockSize * kBlockSize;
+    if (m_summarized == size()) return;
+
+    size_t block = m_summarized / kBlockSize;
+    size_t index = block * kBlockSize;
+    if (m_summarized % kBlockSize != 0 && m_summarized + 1 == size() && block < m_blocks.size()) {
+        // Common case: a single datapoint appended to the open block
+        DataPoint dp = at(m_summarized);
+        m_blocks[block].add(dp);
+        setValid(m_summarized, !std::isnan(dp.m_value));
+        m_summarized = size();
+        if (m_summarized % kBlockSize == 0) sealBlock(block);
+        return;
+    }
+
+    m_blocks.resize(block);
+    m_validity.resize((size() + 63) / 64, 0);
+    for (; index < size(); index++) {
+        DataPoint dp = at(index);
+        if (index % kBlockSize == 0) m_blocks.emplace_back();
+        m_blocks.back().add(dp);
+        setValid(index, !std::isnan(dp.m_value));
+        if ((index + 1) % kBlockSize == 0) sealBlock(index / kBlockSize);
+    }
+    m_summarized = size();
+}
+
+/**
+ * @brief Build the quantile sketch of a full block.
+ */
+
+void DataChannel::sealBlock(size_t block) {
+    double values[kBlockSize];
+    m_values.decode(block * kBlockSize, (block + 1) * kBlockSize, values);
+    double* valid = std::remove_if(values, values + kBlockSize, [](double value) { return std::isnan(value); });
+    m_blocks[block].m_sketch.build(std::span<double>(values, valid));
+}
+
+void DataChannel::setValid(size_t index, bool valid) {
+    if (index / 64 >= m_validity.size()) m_validity.resize(index / 64 + 1, 0);
+    uint64_t bit = uint64_t(1) << (index % 64);
+    m_validity[index / 64] = valid ? (m_validity[index / 64] | bit) : (m_validity[index / 64] & ~bit);
+}
+
+bool DataChannel::isValid(size_t index) const {
+    return (m_validity[index / 64] >> (index % 64)) & 1;
+}
+
+/**
+ * @brief 64 validity bits starting at index (bit 0 = index).
+ * 
+ * @details Bits past the end of the bitmap read as 0.
+ */
+
+uint64_t DataChannel::validityWord(size_t index) const {
+    size_t word = index / 64;
+    size_t offset = index % 64;
+    if (word >= m_validity.size()) return 0;
+    uint64_t bits = m_validity[word] >> offset;
+    if (offset != 0 && word + 1 < m_validity.size()) bits |= m_validity[word + 1] << (64 - offset);
+    return bits;
+}
@@ -1,34 +1,103 @@
 #ifndef DATACHANNEL_H
 #define DATACHANNEL_H
 
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "blockSummary.h"
 #include "dataPoint.h"
+#include "timestamp.h"
+#include "timestampColumn.h"
+#include "valueColumn.h"
+#include "valueEncoding.h"
 
 /**
  * @class DataChannel 
  * 
  * @brief DataChannel class. Belongs to a specific sensor / data source.
  * 
- * Contains information about the channel (id, name, unit) + a vector 
- * which will store the time series datapoints.
+ * Contains information about the channel (id, name, unit) + the time
+ * series datapoints, stored as two columns: m_timestamps (integer
+ * nanoseconds, as chunk base + 32 bit offset) and m_values.
+ * Values are stored with the channel's ValueEncoding (double, float or
+ * scaled 16 bit integer), taken from the unit when the channel is
+ * created, and decoded when read (valueAt, at).
+ * 
+ * Datapoints arriving in order are appended in O(1). Late datapoints
+ * (older than the newest stored one, by at most m_maxLateness ns) go
+ * to the small sorted side buffer m_late, which is merged into the tail
+ * of the columns once it reaches kLateMergeThreshold points. Queries
+ * read both. Datapoints later than m_maxLateness are rejected and
+ * counted as too late, so the columns always stay sorted.
+ * 
+ * The datapoints are split in blocks of kBlockSize, each one with a
+ * BlockSummary (zone map, NaN count) in m_blocks, maintained on
+ * insertion, and a validity bitmap m_validity (bit i set when value i
+ * is not NaN; kBlockSize / 64 words per block). Both cover the first
+ * m_summarized datapoints; summarize() brings them up to date, and
+ * builds the quantile sketch of every block it completes (sealBlock).
+ * 
+ * m_persisted is the persisted watermark: the first m_persisted
+ * datapoints are already in the channel's segment file (see
+ * saveSegment). Changing them (truncate, late merge, new encoding)
+ * moves it back, so the next save rewrites them. m_snapshotted is the
+ * same watermark for the binary snapshots (see saveSnapshot).
  * 
  */
 
 class DataChannel {
 
     public:
+        static constexpr size_t kLateMergeThreshold = 64;
+        static constexpr Timestamp kDefaultMaxLateness = 1000 * kNanosPerMilli;
+        static constexpr size_t kBlockSize = 1024;
+
         uint16_t m_id;
         std::string m_name;
         std::string m_unit;
-        std::vector<DataPoint> m_data;
+        TimestampColumn m_timestamps;
+        ValueColumn m_values;
+        std::vector<DataPoint> m_late;
+        Timestamp m_maxLateness = kDefaultMaxLateness;
+        uint64_t m_lateCount = 0;
+        uint64_t m_tooLateCount = 0;
+        std::vector<BlockSummary> m_blocks;
+        std::vector<uint64_t> m_validity;
+        size_t m_summarized = 0;
+        size_t m_persisted = 0;
+        size_t m_snapshotted = 0;
 
         DataChannel() = default;
         DataChannel(uint16_t id, const std::string& name, const std::string& unit);
         DataChannel(DataChannel&& other) noexcept;
 
         DataChannel& operator=(DataChannel&& other) noexcept;
+
+        size_t size() const;
+        bool empty() const;
+        Timestamp timestampAt(size_t index) const;
+        double valueAt(size_t index) const;
+        DataPoint at(size_t index) const;
+        size_t lowerBound(Timestamp timestamp) const;
+        size_t upperBound(Timestamp timestamp) const;
+        std::optional<DataPoint> asOf(Timestamp timestamp) const;
+        double valueAtTime(Timestamp timestamp) const;
+
+        void reserve(size_t size);
+        void append(const DataPoint& dp);
+        void truncate(size_t size);
+        bool insert(const DataPoint& dp);
+        void mergeLate();
+        void setEncoding(const ValueEncoding& encoding);
+        size_t memoryBytes() const;
+
+        void summarize();
+        void sealBlock(size_t block);
+        void setValid(size_t index, bool valid);
+        bool isValid(size_t index) const;
+        uint64_t validityWord(size_t index) const;
 };
 
-#endif // DATACHANNEL_H
\ No newline at end of file
+#endif // DATACHANNEL_H
@@ -1,5 +1,45 @@
 #include "dataCollector.h"
 
+/**
+ * @brief DataInput creation for a range of channels.
+ * 
+ * @param timestamp 
+ * @param batch 
+ * @param startIndex 
+ * @param endIndex
+ * @param gen
+ * @param nanProbability
+ * 
+ * @details Generates a random value for every channel from
+ * startIndex to endIndex and appends the resulting DataInputs
+ * to the batch. The random generator is supplied by the caller
+ * so that each producer thread owns its own.
+ */
+
+void generateDataInputs(
+    Timestamp timestamp,
+    std::vector<DataInput>& batch,
+    uint16_t startIndex, 
+    uint16_t endIndex,
+    std::mt19937& gen,
+    double nanProbability) 
+{
+    std::uniform_real_distribution<double> valueDist(0.0, 1.0);
+    std::bernoulli_distribution nanDist(nanProbability);
+
+    for (uint16_t index = startIndex; index < endIndex; index++) {
+        double randomValue = valueDist(gen);
+        if (nanDist(gen)) randomValue = std::numeric_limits<double>::quiet_NaN();
+        DataPoint dp(timestamp, randomValue);
+        batch.emplace_back(
+            index, 
+            "Sensor_" + std::to_string(index), 
+            "Unit_" + std::to_string(index),
+            std::move(dp)
+        );
+    }
+}
+
 /**
  * @brief DataPoint creation and insertion into the data queue.
  * 
@@ -7,80 +47,205 @@
  * @param dataQueue 
  * @param startIndex 
  * @param endIndex
+ * @param gen
+ * @param nanProbability
  * 
  * @details Generates a random value and receives a timestamp in
  * order to create a DataPoint and insert it into the appropriate
- * channels (from channel startIndex to channel endIndex). 
+ * channels (from channel startIndex to channel endIndex). The inputs
+ * are built outside of the critical section and moved into the queue
+ * as one batch (single lock acquisition, subject to the queue's
+ * overload policy).
+ */
+
+void generateDataPoint(
+    Timestamp timestamp,
+    DataQueue& dataQueue, 
+    uint16_t startIndex, 
+    uint16_t endIndex,
+    std::mt19937& gen,
+    double nanProbability) 
+{
+    thread_local std::vector<DataInput> batch;
+    batch.clear();
+    generateDataInputs(timestamp, batch, startIndex, endIndex, gen, nanProbability);
+    dataQueue.pushBatch(batch);
+}
+
+/**
+ * @brief DataPoint creation with the default NaN probability.
+ * 
+ * @details Same as above, using a random generator local to
+ * the calling thread.
  */
 
 void generateDataPoint(
-    double timestamp,
-    std::queue<DataInput>& dataQueue, 
+    Timestamp timestamp,
+    DataQueue& dataQueue, 
     uint16_t startIndex, 
     uint16_t endIndex) 
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<double> valueDist(0.0, 1.0);
-    static double probability = 0.005;
+    thread_local std::mt19937 gen(std::random_device{}());
+    generateDataPoint(timestamp, dataQueue, startIndex, endIndex, gen, GeneratorConfig().m_nanProbability);
+}
 
-    for (uint16_t index = startIndex; index < endIndex; index++) {
-        double randomValue = valueDist(gen);
-        if (std::bernoulli_distribution(probability)(gen))
-            randomValue = std::numeric_limits<double>::quiet_NaN();
-        {
-            std::unique_lock<std::mutex> lock(queueMtx);
-            DataPoint dp(timestamp, randomValue);
-            dataQueue.emplace(
-                index, 
-                "Sensor_" + std::to_string(index), 
-                "Unit_" + std::to_string(index),
-                std::move(dp)
-            );
+/**
+ * @brief Generate the inputs of one tick.
+ * 
+ * @details Appends to batch a datapoint for every channel in
+ * [startIndex, endIndex) whose group is due in the tick (sensor
+ * sample rates, see GeneratorConfig::groupDue), or whose own rate
+ * is due when the config has per-channel rates. The maximum rate is
+ * computed once for the tick, not once per channel.
+ */
+
+void generateTick(const GeneratorConfig& config, uint64_t tick, Timestamp timestamp, std::vector<DataInput>& batch, 
+    uint16_t startIndex, uint16_t endIndex, std::mt19937& gen)
+{
+    const double maxRate = config.maxRate();
+    if (!config.m_channelRates.empty()) {
+        for (uint16_t channel = startIndex; channel < endIndex; channel++) {
+            if (config.channelDue(channel, tick, maxRate)) generateDataInputs(timestamp, batch, channel, channel + 1, gen, config.m_nanProbability);
+        }
+        return;
+    }
+    for (size_t group = 0; group < config.m_groupRates.size(); group++) {
+        if (!config.groupDue(group, tick, maxRate)) continue;
+        uint16_t first = std::max(startIndex, config.groupStart(group));
+        uint16_t last = std::min(endIndex, config.groupEnd(group));
+        if (first >= last) continue;
+        generateDataInputs(timestamp, batch, first, last, gen, config.m_nanProbability);
+    }
+}
+
+/**
+ * @brief Producer thread of the data generator.
+ * 
+ * @param config 
+ * @param startIndex 
+ * @param endIndex 
+ * @param seed 
+ * @param emit called once per tick with the inputs of that tick
+ * @return uint64_t number of generated datapoints
+ * 
+ * @details Generates the channels in [startIndex, endIndex) with its
+ * own random generator. Paced mode is driven by a DeadlineScheduler:
+ * every rate has its own absolute deadlines, channels due at the same
+ * deadline are generated in one tick stamped with it, and the wake-up
+ * and period jitter go to report (if given). Unpaced mode never sleeps
+ * and uses simulated timestamps, so the output only depends on the seed.
+ * Where the inputs go is decided by emit (a single queue, or one queue
+ * per pipeline shard). Generates nothing if the config isn't valid().
+ */
+
+uint64_t generatorProducer(
+    const GeneratorConfig& config,
+    uint16_t startIndex,
+    uint16_t endIndex,
+    uint32_t seed,
+    const std::function<void(std::vector<DataInput>&)>& emit,
+    DeadlineScheduler* report)
+{
+    if (!config.valid()) return 0;
+
+    std::mt19937 gen(seed);
+    std::vector<DataInput> batch;
+    uint64_t generated = 0;
+
+    const Timestamp duration = fromMilliseconds(config.m_duration);
+    if (config.m_paced) {
+        DeadlineScheduler scheduler(config, startIndex, endIndex);
+        generated = scheduler.run(duration, [&](Timestamp timestamp, const std::vector<uint16_t>& due) {
+            batch.clear();
+            for (uint16_t channel : due) generateDataInputs(timestamp, batch, channel, channel + 1, gen, config.m_nanProbability);
+            emit(batch);
+        });
+        if (report != nullptr) *report = std::move(scheduler);
+        return generated;
+    }
+
+    const double period = config.basePeriod();
+    for (uint64_t tick = 1; ; tick++) {
+        Timestamp timestamp = fromMilliseconds((tick - 1) * period);
+        if (timestamp >= duration) break;
+
+        batch.clear();
+        generateTick(config, tick, timestamp, batch, startIndex, endIndex, gen);
+        if (!batch.empty()) {
+            generated += batch.size();
+            emit(batch);
         }
     }
+    return generated;
+}
+
+uint64_t generatorProducer(
+    DataQueue& dataQueue,
+    const GeneratorConfig& config,
+    uint16_t startIndex,
+    uint16_t endIndex,
+    uint32_t seed)
+{
+    return generatorProducer(config, startIndex, endIndex, seed, 
+        [&](std::vector<DataInput>& batch) { dataQueue.pushBatch(batch); });
 }
 
 /**
  * @brief Data Generator solution.
  * 
  * @param dataQueue 
+ * @param config 
+ * @return uint64_t number of generated datapoints
  * 
  * @details Design solution: Implement a data queue, in order
  * to use it as the input data source pipe, where the program will
  * collect each data point and store it appropriately. Simulate
- * sample rates by using sleep and modulo functions. Generate
- * input data for a defined amount of time (desiredDuration).
+ * sample rates per channel group (see GeneratorConfig). The channels
+ * are split between the producer threads, so every channel is still
+ * produced in order by a single thread. Generate input data for a
+ * defined amount of time (m_duration). Paced runs print the period
+ * jitter of their schedulers. An invalid config (see
+ * GeneratorConfig::valid) is reported and only closes the queue.
  */
 
-void dataGenerator(std::queue<DataInput>& dataQueue) {
+uint64_t dataGenerator(DataQueue& dataQueue, const GeneratorConfig& config) {
 
     Timer timer("data generator");
 
-    // Start time & amount of time for data generation
-    auto startTime = std::chrono::high_resolution_clock::now();
-    double desiredDuration = 30000.0; // in milliseconds
+    if (!config.valid()) {
+        std::cerr << "Invalid generator config: every group and channel rate must be positive" << std::endl;
+        dataQueue.close();
+        return 0;
+    }
 
-    int count = 1;
-    while (true) {
+    uint32_t seed = config.m_seed != 0 ? config.m_seed : std::random_device{}();
+    unsigned numThreads = std::max(1u, config.m_producerThreads);
 
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(currentTime - startTime);
-        double timestamp = static_cast<double>(elapsed.count()) / 1e3;
-        if (timestamp >= desiredDuration) break;
+    std::vector<uint64_t> generated(numThreads, 0);
+    std::vector<DeadlineScheduler> schedulers(numThreads);
+    std::vector<std::thread> producers;
+    for (unsigned i = 0; i < numThreads; i++) {
+        uint16_t startIndex = static_cast<uint16_t>(i * config.m_numChannels / numThreads);
+        uint16_t endIndex = static_cast<uint16_t>((i + 1) * config.m_numChannels / numThreads);
+        producers.emplace_back([&, i, startIndex, endIndex] {
+            generated[i] = generatorProducer(config, startIndex, endIndex, seed + i,
+                [&](std::vector<DataInput>& batch) { dataQueue.pushBatch(batch); }, &schedulers[i]);
+        });
+    }
+    for (auto& producer : producers) producer.join();
 
-        // Sensor sample rates
-        if (count % 1 == 0) generateDataPoint(timestamp, dataQueue, 0, 25); // 100hz
-        if (count % 2 == 0) generateDataPoint(timestamp, dataQueue, 25, 50); // 50hz
-        if (count % 5 == 0) generateDataPoint(timestamp, dataQueue, 50, 75); // 25hz
-        if (count % 10 == 0) generateDataPoint(timestamp, dataQueue, 75, 101); // 10hz
+    uint64_t total = std::accumulate(generated.begin(), generated.end(), uint64_t(0));
+    dataQueue.close();
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        count += 1;
+    std::cout << "Generated " << total << " datapoints (" 
+              << total / (timer.elapsed() / 1e3) << " datapoints/s)" << std::endl;
+    if (config.m_paced) {
+        JitterHistogram jitter;
+        for (const DeadlineScheduler& scheduler : schedulers) jitter.merge(scheduler.periodJitter());
+        std::cout << "Period jitter: mean " << jitter.mean() / kNanosPerMicro << " us, p99 < " 
+                  << jitter.percentile(99.0) / kNanosPerMicro << " us, max " << jitter.m_max / kNanosPerMicro << " us" << std::endl;
     }
-    finishedGenerating = true;
-    cv.notify_all();
-
+    return total;
 }
 
 /**
@@ -93,34 +258,210 @@ void dataGenerator(std::queue<DataInput>& dataQueue) {
  * from the data queue and store it in its respective
  * channel. With the macro thread_pool we can specify if
  * we want 1 thread performing the collection, or many
- * concurrently.
+ * concurrently. Datapoints are stored with DataChannel::insert,
+ * which absorbs the slightly late arrivals caused by concurrent
+ * collectors without breaking the channel's order.
  */
 
 void dataCollector(
-    std::queue<DataInput>& dataQueue,
-    std::unordered_map<uint16_t, DataChannel>& channels) 
+    DataQueue& dataQueue,
+    std::unordered_map<uint16_t, DataChannel>& channels,
+    LatestValueTable* latest) 
 {
     Timer timer("data collector");
 
     while (true) {
 
         DataInput toMove;
-        {
-            std::unique_lock<std::mutex> lock(queueMtx);
-            cv.wait(lock, [&] { return finishedGenerating || !dataQueue.empty(); });
-            if (finishedGenerating && dataQueue.empty()) break; 
-            toMove = std::move(dataQueue.front());
-            dataQueue.pop();
-        }
+        if (!dataQueue.pop(toMove)) break;
         {
             std::unique_lock<std::mutex> lock(channelsMtx);
             if (channels.find(toMove.m_id) == channels.end()) {
                 DataChannel dc(toMove.m_id, toMove.m_name, toMove.m_unit);
                 channels.emplace(toMove.m_id, std::move(dc));
             }
-            channels[toMove.m_id].m_data.push_back(std::move(toMove.m_dp));
+            bool stored = channels[toMove.m_id].insert(toMove.m_dp);
+            if (stored && latest != nullptr) latest->update(toMove.m_id, toMove.m_dp);
+        }
+    }
+}
+
+/**
+ * @brief Data Collector solution (drain-all mode).
+ * 
+ * @param dataQueue 
+ * @param channels 
+ * @param maxBatch maximum inputs per batch (0 = whole queue)
+ * @param mtx lock protecting channels (nullptr = channelsMtx)
+ * @param log log of the stored datapoints (nullptr = not logged)
+ * @param latest latest-value table to publish to (nullptr = none)
+ * 
+ * @details Instead of one queue lock and one channels lock per
+ * input, takes every pending input (or a large batch) in a single
+ * queue critical section, groups the batch by channel id outside
+ * of any lock, and then appends each group with one channel lookup
+ * and one bulk insert inside a single channels critical section.
+ * Inputs of the same channel keep their queue order. With a log,
+ * every stored input is also appended to it, the log is synced once
+ * per batch (group commit, outside the channels lock), and a
+ * checkpoint (snapshot + log rotation) is taken once the log is large
+ * enough: only the rows are copied under the channels lock, the
+ * snapshot is written and synced after it is released. A failed
+ * checkpoint is reported (and counted in the log's
+ * m_checkpointFailures), and its rows are saved by the next one.
+ * With a latest-value table, the newest stored datapoint of each
+ * group is published to it.
+ */
+
+void dataCollectorBatched(
+    DataQueue& dataQueue,
+    std::unordered_map<uint16_t, DataChannel>& channels,
+    size_t maxBatch,
+    std::mutex* mtx,
+    ChannelLog* log,
+    LatestValueTable* latest)
+{
+    Timer timer("data collector (batched)");
+
+    DataQueue::Batch batch = dataQueue.makeBatch();
+    std::vector<std::pair<uint16_t, uint32_t>> order;
+    SnapshotDelta delta;
+    uint64_t failures = log != nullptr ? log->m_checkpointFailures : 0;
+
+    while (dataQueue.popBatch(batch, maxBatch)) {
+
+        // (channel id, position in the batch): sorting groups by channel, keeping the order
+        order.clear();
+        order.reserve(batch.size());
+        for (uint32_t i = 0; i < batch.size(); i++) order.emplace_back(batch[i].m_id, i);
+        std::sort(order.begin(), order.end());
+
+        std::unique_lock<std::mutex> lock(mtx != nullptr ? *mtx : channelsMtx);
+        for (size_t begin = 0; begin < order.size(); ) {
+            uint16_t id = order[begin].first;
+            size_t end = begin;
+            while (end < order.size() && order[end].first == id) end++;
+
+            auto it = channels.find(id);
+            if (it == channels.end()) {
+                const DataInput& first = batch[order[begin].second];
+                it = channels.emplace(id, DataChannel(id, first.m_name, first.m_unit)).first;
+            }
+            DataChannel& channel = it->second;
+            const DataPoint* newest = nullptr;
+            for (size_t i = begin; i < end; i++) {
+                const DataPoint& dp = batch[order[i].second].m_dp;
+                if (channel.insert(dp) && (newest == nullptr || dp.m_timestamp >= newest->m_timestamp)) newest = &dp;
+            }
+            if (latest != nullptr && newest != nullptr) latest->update(id, *newest);
+            if (log != nullptr) {
+                for (size_t i = begin; i < end; i++) log->append(batch[order[i].second]);
+            }
+
+            begin = end;
+        }
+        bool checkpointing = log != nullptr && log->checkpointDue() && beginCheckpoint(channels, *log, delta);
+        lock.unlock();
+        if (log != nullptr) log->sync();
+        if (checkpointing && !finishCheckpoint(*log, delta)) {
+            lock.lock();
+            restoreSnapshotted(channels, delta);
+            lock.unlock();
+        }
+        if (log != nullptr && log->m_checkpointFailures > failures) {
+            failures = log->m_checkpointFailures;
+            std::cerr << "Error taking checkpoint in: " << log->m_directory << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Extracts one channel's datapoints between 2 timestamps.
+ * 
+ * @param channel 
+ * @param lowerBoundTimestamp 
+ * @param upperBoundTimestamp 
+ * @param subChannel output, its vectors are allocated from its own resource
+ * 
+ * @details Read only: the channel is not merged nor summarized (the
+ * ingest path does both). Without late datapoints in the range, NaN
+ * values are omitted using the channel's validity bitmap
+ * (branch-free) and described by a NaN bitmap over the range. Late
+ * datapoints still in the side buffer are merged into the output in
+ * timestamp order, after the column datapoints of equal timestamp.
+ */
+
+static void extractSubChannel(const DataChannel& channel, Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp,
+    ExtractedSubChannel& subChannel)
+{
+    size_t start = channel.lowerBound(lowerBoundTimestamp);
+    size_t columnSize = std::max(start, channel.upperBound(upperBoundTimestamp)) - start;
+    auto lateFirst = std::lower_bound(channel.m_late.begin(), channel.m_late.end(), lowerBoundTimestamp,
+        [](const DataPoint& dp, Timestamp t) { return dp.m_timestamp < t; });
+    auto lateLast = std::upper_bound(lateFirst, channel.m_late.end(), upperBoundTimestamp,
+        [](Timestamp t, const DataPoint& dp) { return t < dp.m_timestamp; });
+    size_t lateSize = static_cast<size_t>(lateLast - lateFirst);
+    size_t size = columnSize + lateSize;
+
+    subChannel.m_rangeStart = start;
+    subChannel.m_rangeSize = size;
+    subChannel.m_lateStart = static_cast<size_t>(lateFirst - channel.m_late.begin());
+    subChannel.m_lateSize = lateSize;
+    subChannel.m_timestamps.resize(size);
+    subChannel.m_values.resize(size);
+    subChannel.m_nanMask.assign((size + 63) / 64, 0);
+    Timestamp* timestamps = subChannel.m_timestamps.data();
+    double* values = subChannel.m_values.data();
+    size_t valid = 0;
+
+    if (lateSize == 0) {
+        // Branch-free compaction: values are decoded into the output, then
+        // every datapoint is written and the output position only advances
+        // when its validity bit is set
+        channel.m_timestamps.decode(start, start + size, timestamps);
+        channel.m_values.decode(start, start + size, values);
+        for (size_t j = 0; j < size; j++) {
+            timestamps[valid] = timestamps[j];
+            values[valid] = values[j];
+            valid += channel.isValid(start + j);
+        }
+
+        // NaN bitmap of the range: inverted validity bits, realigned to the range start
+        if (valid < size) {
+            for (size_t word = 0; word < subChannel.m_nanMask.size(); word++) {
+                uint64_t bits = ~channel.validityWord(start + word * 64);
+                size_t remaining = size - word * 64;
+                if (remaining < 64) bits &= (uint64_t(1) << remaining) - 1;
+                subChannel.m_nanMask[word] = bits;
+            }
+        }
+    } else {
+        // The columns are decoded at the end of the output, then merged forward
+        // with the late datapoints (the write position never passes the read one)
+        channel.m_timestamps.decode(start, start + columnSize, timestamps + lateSize);
+        channel.m_values.decode(start, start + columnSize, values + lateSize);
+        size_t column = lateSize;
+        auto late = lateFirst;
+        for (size_t position = 0; position < size; position++) {
+            DataPoint dp;
+            if (late != lateLast && (column == size || late->m_timestamp < timestamps[column])) {
+                dp = *late++;
+            } else {
+                dp = DataPoint(timestamps[column], values[column]);
+                column++;
+            }
+            if (std::isnan(dp.m_value)) {
+                subChannel.m_nanMask[position / 64] |= uint64_t(1) << (position % 64);
+            } else {
+                timestamps[valid] = dp.m_timestamp;
+                values[valid] = dp.m_value;
+                valid++;
+            }
         }
     }
+    subChannel.m_timestamps.resize(valid);
+    subChannel.m_values.resize(valid);
+    subChannel.m_nanCount = size - valid;
 }
 
 /**
@@ -135,54 +476,448 @@ void dataCollector(
  * @details Recieves a list of channel Ids and two timestamps.
  * Extracts the datapoints between the two timestamps and returns
  * it in a structured way more suitable for calculations on the 
- * values. Also handles NaN values by omitting them from the
- * output. Returns a map of the extracted subsets from each channel.
+ * values (decoded from the channel's storage type). Also handles
+ * NaN values by omitting them from the output, using the channel's
+ * validity bitmap (branch-free), and
+ * describing them with a NaN bitmap over the range instead of
+ * copying them. Late datapoints still in the channel's side buffer
+ * are merged into the output (the channel itself is left untouched).
+ * Returns a map of the extracted subsets from each channel.
  */
 
 std::unordered_map<uint16_t, ExtractedSubChannel> retrieveChannelSubsets(
     std::unordered_map<uint16_t, DataChannel>& channels, 
     const std::vector<uint16_t>& channelIds, 
-    double lowerBoundTimestamp, 
-    double upperBoundTimestamp) 
+    Timestamp lowerBoundTimestamp, 
+    Timestamp upperBoundTimestamp) 
 {
     Timer timer("subset retrieval");
     std::unordered_map<uint16_t, ExtractedSubChannel> subsetChannels;
 
     for (uint16_t channelId : channelIds) {
+        DataChannel& channel = channels[channelId];
+        ExtractedSubChannel subChannel(channel, 0);
+        extractSubChannel(channel, lowerBoundTimestamp, upperBoundTimestamp, subChannel);
+        subsetChannels.emplace(channelId, std::move(subChannel));
+    }
+    return subsetChannels;
+}
 
-        auto startIt = std::lower_bound(
-            channels[channelId].m_data.begin(), 
-            channels[channelId].m_data.end(), 
-            lowerBoundTimestamp,
-            [](const DataPoint& dp, double t) { 
-                return dp.m_timestamp < t; 
-            }
-        );
+/**
+ * @brief Retrieves subsets of channels into caller-supplied memory.
+ * 
+ * @param channels 
+ * @param channelIds 
+ * @param lowerBoundTimestamp 
+ * @param upperBoundTimestamp 
+ * @param subsetChannels output map, cleared first
+ * 
+ * @details Same extraction as the overload returning a map, but the
+ * map nodes and every subset's vectors come from the output map's
+ * memory resource (e.g. a monotonic buffer over a stack array), so
+ * a query on the hot path makes no heap allocation. Not timed, the
+ * Timer's label would allocate.
+ */
+
+void retrieveChannelSubsets(
+    std::unordered_map<uint16_t, DataChannel>& channels, 
+    const std::vector<uint16_t>& channelIds, 
+    Timestamp lowerBoundTimestamp, 
+    Timestamp upperBoundTimestamp,
+    SubChannelMap& subsetChannels) 
+{
+    subsetChannels.clear();
+    std::pmr::memory_resource* resource = subsetChannels.get_allocator().resource();
+    for (uint16_t channelId : channelIds) {
+        DataChannel& channel = channels[channelId];
+        ExtractedSubChannel subChannel(channel, resource);
+        extractSubChannel(channel, lowerBoundTimestamp, upperBoundTimestamp, subChannel);
+        subsetChannels.emplace(channelId, std::move(subChannel));
+    }
+}
 
-        auto endIt = std::upper_bound(
-            channels[channelId].m_data.begin(), 
-            channels[channelId].m_data.end(), 
-            upperBoundTimestamp,
-            [](double t, const DataPoint& dp) { 
-                return t < dp.m_timestamp; 
+/**
+ * @brief Datapoints held by several channels at a timestamp ("as of" query).
+ * 
+ * @param channels 
+ * @param channelIds 
+ * @param timestamp 
+ * @param out one datapoint per id, in the same order (NaN value and
+ * timestamp 0 when the channel has no datapoint at or before it)
+ * @return size_t number of channels with a datapoint
+ * 
+ * @details One bound search per channel (DataChannel::asOf) and no
+ * extraction: only the datapoint found is copied. out is reused, so
+ * a dashboard refreshing the same ids doesn't allocate. Callers hold
+ * the channels lock while ingest is running; for the latest values
+ * only, LatestValueTable needs no lock.
+ */
+
+size_t retrieveChannelsAsOf(
+    const std::unordered_map<uint16_t, DataChannel>& channels, 
+    const std::vector<uint16_t>& channelIds, 
+    Timestamp timestamp, 
+    std::vector<DataPoint>& out)
+{
+    out.resize(channelIds.size());
+    size_t found = 0;
+    for (size_t i = 0; i < channelIds.size(); i++) {
+        auto it = channels.find(channelIds[i]);
+        std::optional<DataPoint> dp;
+        if (it != channels.end()) dp = it->second.asOf(timestamp);
+        out[i] = dp.value_or(DataPoint(0, std::numeric_limits<double>::quiet_NaN()));
+        found += dp.has_value();
+    }
+    return found;
+}
+
+/**
+ * @brief Whether a block can contain a value matching the predicate.
+ * 
+ * @param block 
+ * @param comparison 
+ * @param threshold 
+ * @return true if the block has to be scanned
+ * @return false if it can be skipped
+ * 
+ * @details Uses the block's zone map (min / max of its valid values).
+ * Blocks with only NaN values never match.
+ */
+
+bool blockMayMatch(const BlockSummary& block, Comparison comparison, double threshold) {
+    if (block.allNan()) return false;
+    switch (comparison) {
+        case Comparison::Greater: return block.m_max > threshold;
+        case Comparison::GreaterEqual: return block.m_max >= threshold;
+        case Comparison::Less: return block.m_min < threshold;
+        case Comparison::LessEqual: return block.m_min <= threshold;
+    }
+    return true;
+}
+
+/**
+ * @brief Branch-free filter of a range of datapoints.
+ * 
+ * @details Every datapoint is written at the current output position,
+ * which only advances when the value matches, so the loop has no
+ * data-dependent branch. NaN values never match. The output arrays
+ * must have room for count elements.
+ */
+
+template <Comparison comparison>
+static size_t filterDatapoints(
+    const Timestamp* inTimestamps, 
+    const double* inValues, 
+    size_t count,
+    double threshold, 
+    Timestamp* timestamps, 
+    double* values)
+{
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i++) {
+        double value = inValues[i];
+        timestamps[matches] = inTimestamps[i];
+        values[matches] = value;
+        bool match;
+        if constexpr (comparison == Comparison::Greater) match = value > threshold;
+        else if constexpr (comparison == Comparison::GreaterEqual) match = value >= threshold;
+        else if constexpr (comparison == Comparison::Less) match = value < threshold;
+        else match = value <= threshold;
+        matches += match;
+    }
+    return matches;
+}
+
+static size_t filterDatapoints(
+    const Timestamp* inTimestamps, 
+    const double* inValues, 
+    size_t count,
+    Comparison comparison,
+    double threshold, 
+    Timestamp* timestamps, 
+    double* values)
+{
+    switch (comparison) {
+        case Comparison::Greater: 
+            return filterDatapoints<Comparison::Greater>(inTimestamps, inValues, count, threshold, timestamps, values);
+        case Comparison::GreaterEqual: 
+            return filterDatapoints<Comparison::GreaterEqual>(inTimestamps, inValues, count, threshold, timestamps, values);
+        case Comparison::Less: 
+            return filterDatapoints<Comparison::Less>(inTimestamps, inValues, count, threshold, timestamps, values);
+        case Comparison::LessEqual: 
+            return filterDatapoints<Comparison::LessEqual>(inTimestamps, inValues, count, threshold, timestamps, values);
+    }
+    return 0;
+}
+
+/**
+ * @brief Retrieves the datapoints of channels matching a value predicate.
+ * 
+ * @param channels 
+ * @param channelIds 
+ * @param lowerBoundTimestamp 
+ * @param upperBoundTimestamp 
+ * @param comparison 
+ * @param threshold 
+ * @return std::unordered_map<uint16_t, ExtractedSubChannel>
+ * 
+ * @details Answers queries such as "all times when the value of the
+ * channel was above T between t0 and t1". After locating the time
+ * range, blocks whose zone map can't match are skipped entirely, and
+ * only candidate blocks are decoded and scanned with a branch-free
+ * filter, so the cost depends on the number of candidate blocks
+ * rather than on the width of the range. Late datapoints not merged
+ * yet are filtered as well. NaN values never match.
+ */
+
+std::unordered_map<uint16_t, ExtractedSubChannel> retrieveChannelMatches(
+    std::unordered_map<uint16_t, DataChannel>& channels, 
+    const std::vector<uint16_t>& channelIds, 
+    Timestamp lowerBoundTimestamp, 
+    Timestamp upperBoundTimestamp,
+    Comparison comparison,
+    double threshold)
+{
+    Timer timer("predicate retrieval");
+    std::unordered_map<uint16_t, ExtractedSubChannel> matchChannels;
+    const size_t blockSize = DataChannel::kBlockSize;
+    std::vector<Timestamp> decodedTimestamps(blockSize);
+    std::vector<double> decoded(blockSize);
+
+    for (uint16_t channelId : channelIds) {
+
+        DataChannel& channel = channels[channelId];
+        channel.summarize();
+        ExtractedSubChannel subChannel(channel, 0);
+
+        size_t start = channel.lowerBound(lowerBoundTimestamp);
+        size_t end = channel.upperBound(upperBoundTimestamp);
+
+        for (size_t block = start / blockSize; block * blockSize < end; block++) {
+            if (!blockMayMatch(channel.m_blocks[block], comparison, threshold)) continue;
+            size_t first = std::max(start, block * blockSize);
+            size_t last = std::min(end, (block + 1) * blockSize);
+            size_t size = subChannel.m_timestamps.size();
+            subChannel.m_timestamps.resize(size + (last - first));
+            subChannel.m_values.resize(size + (last - first));
+            channel.m_timestamps.decode(first, last, decodedTimestamps.data());
+            channel.m_values.decode(first, last, decoded.data());
+            size_t matches = filterDatapoints(decodedTimestamps.data(), decoded.data(), last - first,
+                comparison, threshold, subChannel.m_timestamps.data() + size, subChannel.m_values.data() + size);
+            subChannel.m_timestamps.resize(size + matches);
+            subChannel.m_values.resize(size + matches);
+        }
+
+        // Late datapoints (small, unsummarized side buffer) are merged into the matches
+        std::vector<Timestamp> lateTimestamps;
+        std::vector<double> lateValues;
+        for (const DataPoint& dp : channel.m_late) {
+            if (dp.m_timestamp < lowerBoundTimestamp || dp.m_timestamp > upperBoundTimestamp) continue;
+            lateTimestamps.push_back(dp.m_timestamp);
+            lateValues.push_back(dp.m_value);
+        }
+        if (!lateTimestamps.empty()) {
+            size_t matches = filterDatapoints(lateTimestamps.data(), lateValues.data(), lateTimestamps.size(),
+                comparison, threshold, lateTimestamps.data(), lateValues.data());
+
+            std::pmr::vector<Timestamp> timestamps;
+            std::pmr::vector<double> values;
+            timestamps.reserve(subChannel.m_timestamps.size() + matches);
+            values.reserve(subChannel.m_values.size() + matches);
+            size_t i = 0;
+            size_t j = 0;
+            while (i < subChannel.m_timestamps.size() || j < matches) {
+                bool takeLate = j < matches && 
+                    (i == subChannel.m_timestamps.size() || lateTimestamps[j] < subChannel.m_timestamps[i]);
+                timestamps.push_back(takeLate ? lateTimestamps[j] : subChannel.m_timestamps[i]);
+                values.push_back(takeLate ? lateValues[j++] : subChannel.m_values[i++]);
             }
-        );
+            subChannel.m_timestamps = std::move(timestamps);
+            subChannel.m_values = std::move(values);
+        }
 
-        std::span<DataPoint> subsequence_span(startIt, endIt);
-        ExtractedSubChannel subChannel(channels[channelId], subsequence_span.size());
+        matchChannels.emplace(channelId, std::move(subChannel));
+    }
+    return matchChannels;
+}
 
-        for (const DataPoint& dp : subsequence_span) {
-            if (!std::isnan(dp.m_value)) {
-                subChannel.m_timestamps.push_back(dp.m_timestamp);
-                subChannel.m_values.push_back(dp.m_value);
-            } else {
-                subChannel.m_nan_dps.push_back(dp);
+/**
+ * @brief Aggregates (count, sum, min, max) of channels between 2 timestamps.
+ * 
+ * @param channels 
+ * @param channelIds 
+ * @param lowerBoundTimestamp 
+ * @param upperBoundTimestamp 
+ * @return std::unordered_map<uint16_t, ValueAggregate>
+ * 
+ * @details Computed on the stored values without extracting them,
+ * with kernels working on the channel's storage type (double, float
+ * or scaled 16 bit integers). NaN values are ignored.
+ */
+
+std::unordered_map<uint16_t, ValueAggregate> retrieveChannelAggregates(
+    std::unordered_map<uint16_t, DataChannel>& channels, 
+    const std::vector<uint16_t>& channelIds, 
+    Timestamp lowerBoundTimestamp, 
+    Timestamp upperBoundTimestamp)
+{
+    Timer timer("aggregate retrieval");
+    std::unordered_map<uint16_t, ValueAggregate> aggregates;
+
+    for (uint16_t channelId : channelIds) {
+        DataChannel& channel = channels[channelId];
+        channel.mergeLate();
+        size_t start = channel.lowerBound(lowerBoundTimestamp);
+        size_t end = channel.upperBound(upperBoundTimestamp);
+        aggregates.emplace(channelId, channel.m_values.aggregate(start, end));
+    }
+    return aggregates;
+}
+
+/**
+ * @brief Approximate percentiles of channels between 2 timestamps.
+ * 
+ * @param channels 
+ * @param channelIds 
+ * @param lowerBoundTimestamp 
+ * @param upperBoundTimestamp 
+ * @return std::unordered_map<uint16_t, PercentileSummary>
+ * 
+ * @details Whole sealed blocks in the range contribute their quantile
+ * sketch (128 weighted samples instead of up to 1024 values), the
+ * partial blocks at both ends and the open last block their exact
+ * values, so nothing is extracted or sorted beyond the edges. The rank
+ * error of the answers is bounded by PercentileSummary::m_rankError
+ * (at most 1 / QuantileSketch::kSamples of the values). NaN values are
+ * ignored.
+ */
+
+std::unordered_map<uint16_t, PercentileSummary> retrieveChannelPercentiles(
+    std::unordered_map<uint16_t, DataChannel>& channels, 
+    const std::vector<uint16_t>& channelIds, 
+    Timestamp lowerBoundTimestamp, 
+    Timestamp upperBoundTimestamp)
+{
+    Timer timer("percentile retrieval");
+    std::unordered_map<uint16_t, PercentileSummary> summaries;
+    const size_t blockSize = DataChannel::kBlockSize;
+    std::vector<double> values(blockSize);
+
+    for (uint16_t channelId : channelIds) {
+        DataChannel& channel = channels[channelId];
+        channel.mergeLate();
+        channel.summarize();
+        size_t start = channel.lowerBound(lowerBoundTimestamp);
+        size_t end = channel.upperBound(upperBoundTimestamp);
+        PercentileSummary& summary = summaries[channelId];
+
+        for (size_t block = start / blockSize; block * blockSize < end; block++) {
+            size_t first = std::max(start, block * blockSize);
+            size_t last = std::min(end, (block + 1) * blockSize);
+            const QuantileSketch& sketch = channel.m_blocks[block].m_sketch;
+            if (last - first == blockSize && sketch.m_count + channel.m_blocks[block].m_nanCount == blockSize) {
+                summary.add(sketch);
+                continue;
+            }
+            channel.m_values.decode(first, last, values.data());
+            for (size_t i = 0; i < last - first; i++) {
+                if (!std::isnan(values[i])) summary.add(values[i]);
             }
         }
+    }
+    return summaries;
+}
 
-        subsetChannels.emplace(channelId, std::move(subChannel));
+/**
+ * @brief Evaluates a derived channel (expression over channels) between 2 timestamps.
+ * 
+ * @param channels 
+ * @param expr 
+ * @param lowerBoundTimestamp 
+ * @param upperBoundTimestamp 
+ * @return ExtractedSubChannel
+ * 
+ * @details The result has the timestamps of the expression's first
+ * channel (the reference channel) in the range, and the same shape as
+ * retrieveChannelSubsets' output: NaN results are left out and marked
+ * in the NaN bitmap, whose positions refer to the reference channel's
+ * datapoints from m_rangeStart. The expression is evaluated lazily, one
+ * block of kBlockSize timestamps at a time, so intermediate results
+ * never take more than a block per node. Moving averages start
+ * lookback() before the lower bound so that the first results are
+ * computed over full windows.
+ */
+
+ExtractedSubChannel retrieveDerivedChannel(
+    std::unordered_map<uint16_t, DataChannel>& channels, 
+    const ChannelExpr& expr,
+    Timestamp lowerBoundTimestamp, 
+    Timestamp upperBoundTimestamp)
+{
+    Timer timer("derived channel evaluation");
+    std::vector<uint16_t> channelIds = expr.channelIds();
+    if (channelIds.empty()) return ExtractedSubChannel();
+
+    for (uint16_t channelId : channelIds) channels[channelId].mergeLate();
+    DataChannel& reference = channels[channelIds.front()];
+
+    ExtractedSubChannel derived(reference, 0);
+    derived.m_name = expr.toString();
+    derived.m_unit.clear();
+
+    size_t warmup = reference.lowerBound(lowerBoundTimestamp - expr.lookback());
+    size_t start = reference.lowerBound(lowerBoundTimestamp);
+    size_t end = reference.upperBound(upperBoundTimestamp);
+    size_t size = end - start;
+    derived.m_rangeStart = start;
+    derived.m_rangeSize = size;
+    derived.m_timestamps.resize(size);
+    derived.m_values.resize(size);
+    derived.m_nanMask.assign((size + 63) / 64, 0);
+
+    const size_t blockSize = DataChannel::kBlockSize;
+    std::vector<Timestamp> timestamps(blockSize);
+    std::vector<double> values(blockSize);
+    ExprEvaluator evaluator(channels, expr, reference.m_id);
+
+    size_t valid = 0;
+    for (size_t block = warmup; block < end; block += blockSize) {
+        size_t count = std::min(blockSize, end - block);
+        reference.m_timestamps.decode(block, block + count, timestamps.data());
+        evaluator.evaluate(timestamps.data(), block, count, values.data());
+
+        // Branch-free compaction of the part of the block inside the range
+        size_t skip = start > block ? std::min(start - block, count) : 0;
+        for (size_t j = skip; j < count; j++) {
+            size_t position = block + j - start;
+            bool nan = std::isnan(values[j]);
+            derived.m_timestamps[valid] = timestamps[j];
+            derived.m_values[valid] = values[j];
+            valid += !nan;
+            derived.m_nanMask[position / 64] |= uint64_t(nan) << (position % 64);
+        }
     }
-    return subsetChannels;
+    derived.m_timestamps.resize(valid);
+    derived.m_values.resize(valid);
+    derived.m_nanCount = size - valid;
+    return derived;
+}
+
+/**
+ * @brief Check that the datapoints of a channel are sorted.
+ * 
+ * @param channel 
+ * @return true 
+ * @return false 
+ */
+
+bool OrderedByTimestamp(const DataChannel& channel) {
+    for (size_t i = 1; i < channel.size(); i++) {
+        if (channel.timestampAt(i - 1) >= channel.timestampAt(i)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 /**
@@ -215,14 +950,14 @@ bool OrderedByTimestamp(const std::vector<DataPoint>& datapoints) {
  * 
  * @details Checks that the vector of datapoints is sorted.
  * In the thread pool case, due to race conditions, there is
- * no certainty that the datapoints will be inserted in order,
- * hence using a thread pool for data collection does not
- * ensure order.
+ * no certainty that the datapoints arrive in order. Late ones
+ * are kept in each channel's side buffer (m_late) until merged,
+ * so the channel's columns themselves stay sorted.
  */
 
 bool checkOrder(std::unordered_map<uint16_t, DataChannel>& channels) {
     for (auto& channel : channels) {
-        if (!OrderedByTimestamp(channel.second.m_data)) return false;
+        if (!OrderedByTimestamp(channel.second)) return false;
     }
     return true;
 }
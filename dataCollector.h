@@ -1,20 +1,37 @@
 #ifndef DATACOLLECTOR_H
 #define DATACOLLECTOR_H
 
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <mutex>
+#include <numeric>
 #include <queue>
 #include <random>
 #include <span>
 #include <thread>
+#include <unordered_map>
 
+#include "channelExpr.h"
+#include "channelLog.h"
 #include "dataChannel.h"
 #include "dataInput.h"
 #include "dataPoint.h"
+#include "dataQueue.h"
+#include "deadlineScheduler.h"
+#include "exprEvaluator.h"
 #include "extractedSubChannel.h"
+#include "generatorConfig.h"
 #include "jsonFunctions.h"
+#include "latestValueTable.h"
+#include "percentileSummary.h"
+#include "snapshotFunctions.h"
 #include "timer.h"
+#include "timestamp.h"
+#include "valueAggregate.h"
 
 /**
  * @brief Utility functions for the main program.
@@ -24,21 +41,52 @@
  * which do the collection and storage of the data. RetrieveChannelSubsets
  * is used for extracting the values between 2 timestamps from one or many
  * channels, and the rest are other helper / utility functions. We can also
- * find some static variables related to concurrency (as dataGenerator and
- * dataCollector can be used concurrently).
+ * find the default channels lock of the collectors (inline, so a single
+ * mutex is shared by every translation unit). The synchronisation of the
+ * data queue itself lives in DataQueue, and the coroutine version of the
+ * pipeline in asyncPipeline.
  */
 
-static std::mutex channelsMtx;
-static std::mutex queueMtx;
-static std::condition_variable cv;
-static bool finishedGenerating = false;
+inline std::mutex channelsMtx;
 
-void generateDataPoint(double timestamp, std::queue<DataInput>& dataQueue, uint16_t startIndex, uint16_t endIndex);
-void dataGenerator(std::queue<DataInput>& dataQueue);
-void dataCollector(std::queue<DataInput>& dataQueue, std::unordered_map<uint16_t, DataChannel>& channels);
+enum class Comparison { Greater, GreaterEqual, Less, LessEqual };
+
+void generateDataInputs(Timestamp timestamp, std::vector<DataInput>& batch, uint16_t startIndex, uint16_t endIndex, 
+    std::mt19937& gen, double nanProbability);
+void generateTick(const GeneratorConfig& config, uint64_t tick, Timestamp timestamp, std::vector<DataInput>& batch, 
+    uint16_t startIndex, uint16_t endIndex, std::mt19937& gen);
+void generateDataPoint(Timestamp timestamp, DataQueue& dataQueue, uint16_t startIndex, uint16_t endIndex);
+void generateDataPoint(Timestamp timestamp, DataQueue& dataQueue, uint16_t startIndex, uint16_t endIndex, 
+    std::mt19937& gen, double nanProbability);
+uint64_t generatorProducer(const GeneratorConfig& config, uint16_t startIndex, uint16_t endIndex, uint32_t seed, 
+    const std::function<void(std::vector<DataInput>&)>& emit, DeadlineScheduler* report = nullptr);
+uint64_t generatorProducer(DataQueue& dataQueue, const GeneratorConfig& config, 
+    uint16_t startIndex, uint16_t endIndex, uint32_t seed);
+uint64_t dataGenerator(DataQueue& dataQueue, const GeneratorConfig& config = GeneratorConfig());
+void dataCollector(DataQueue& dataQueue, std::unordered_map<uint16_t, DataChannel>& channels, 
+    LatestValueTable* latest = nullptr);
+void dataCollectorBatched(DataQueue& dataQueue, std::unordered_map<uint16_t, DataChannel>& channels, size_t maxBatch = 0, 
+    std::mutex* mtx = nullptr, ChannelLog* log = nullptr, LatestValueTable* latest = nullptr);
 std::unordered_map<uint16_t, ExtractedSubChannel> retrieveChannelSubsets(
     std::unordered_map<uint16_t, DataChannel>& channels, const std::vector<uint16_t>& channelIds, 
-    double lowerBoundTimestamp, double upperBoundTimestamp);
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp);
+void retrieveChannelSubsets(std::unordered_map<uint16_t, DataChannel>& channels, const std::vector<uint16_t>& channelIds, 
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp, SubChannelMap& subsetChannels);
+size_t retrieveChannelsAsOf(const std::unordered_map<uint16_t, DataChannel>& channels, 
+    const std::vector<uint16_t>& channelIds, Timestamp timestamp, std::vector<DataPoint>& out);
+std::unordered_map<uint16_t, ExtractedSubChannel> retrieveChannelMatches(
+    std::unordered_map<uint16_t, DataChannel>& channels, const std::vector<uint16_t>& channelIds, 
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp, Comparison comparison, double threshold);
+std::unordered_map<uint16_t, ValueAggregate> retrieveChannelAggregates(
+    std::unordered_map<uint16_t, DataChannel>& channels, const std::vector<uint16_t>& channelIds, 
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp);
+std::unordered_map<uint16_t, PercentileSummary> retrieveChannelPercentiles(
+    std::unordered_map<uint16_t, DataChannel>& channels, const std::vector<uint16_t>& channelIds, 
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp);
+ExtractedSubChannel retrieveDerivedChannel(std::unordered_map<uint16_t, DataChannel>& channels, const ChannelExpr& expr, 
+    Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp);
+bool blockMayMatch(const BlockSummary& block, Comparison comparison, double threshold);
+bool OrderedByTimestamp(const DataChannel& channel);
 bool OrderedByTimestamp(const std::vector<DataPoint>& datapoints);
 bool checkOrder(std::unordered_map<uint16_t, DataChannel>& channels);
 bool compareByTimestamp(const DataPoint& a, const DataPoint& b);
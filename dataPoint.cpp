@@ -1,6 +1,6 @@
 #include "dataPoint.h"
 
-DataPoint::DataPoint(double timestamp, double val)
+DataPoint::DataPoint(Timestamp timestamp, double val)
     : m_timestamp(timestamp), m_value(val) {}
 
 DataPoint::DataPoint(const DataPoint& other)
@@ -9,6 +9,12 @@ DataPoint::DataPoint(const DataPoint& other)
 DataPoint::DataPoint(DataPoint&& other) noexcept
     : m_timestamp(other.m_timestamp), m_value(other.m_value) {}
 
+DataPoint& DataPoint::operator=(const DataPoint& other) {
+    m_timestamp = other.m_timestamp;
+    m_value = other.m_value;
+    return *this;
+}
+
 DataPoint& DataPoint::operator=(DataPoint&& other) {
     if (this != &other) {
         m_timestamp = other.m_timestamp;
@@ -1,12 +1,14 @@
 #ifndef DATAPOINT_H
 #define DATAPOINT_H
 
+#include "timestamp.h"
+
 /**
  * @class DataPoint
  * 
  * @brief DataPoint class.
  * 
- * Contains a timestamp and a value. Public member
+ * Contains a timestamp (integer nanoseconds) and a value. Public member
  * variables mainly for easier access from the main
  * function.
  * 
@@ -15,14 +17,15 @@
 class DataPoint {
 
     public:
-        double m_timestamp;
+        Timestamp m_timestamp;
         double m_value;
     
         DataPoint() = default;
-        DataPoint(double timestamp, double val);
+        DataPoint(Timestamp timestamp, double val);
         DataPoint(const DataPoint& other);
         DataPoint(DataPoint&& other) noexcept;
 
+        DataPoint& operator=(const DataPoint& other);
         DataPoint& operator=(DataPoint&& other);
         bool operator<(const DataPoint& other) const;
 };
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <iterator>
+
+#include "dataQueue.h"
+
+DataQueue::DataQueue(size_t capacity, OverloadPolicy policy)
+    : m_capacity(capacity), m_policy(policy) {}
+
+/**
+ * @brief Insert one input, applying the overload policy.
+ */
+
+void DataQueue::push(DataInput&& input) {
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        pushLocked(lock, std::move(input));
+    }
+    m_notEmpty.notify_one();
+}
+
+/**
+ * @brief Insert a batch of inputs with a single lock acquisition.
+ * 
+ * @details The batch is left with moved-from elements, the
+ * caller is in charge of clearing it.
+ */
+
+void DataQueue::pushBatch(std::vector<DataInput>& batch) {
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        for (DataInput& input : batch) pushLocked(lock, std::move(input));
+    }
+    m_notEmpty.notify_all();
+}
+
+/**
+ * @brief Overload policy + insertion. Must be called with m_mtx held.
+ */
+
+void DataQueue::pushLocked(std::unique_lock<std::mutex>& lock, DataInput&& input) {
+
+    if (m_capacity > 0) {
+        switch (m_policy) {
+            case OverloadPolicy::Block:
+                if (m_queue.size() >= m_capacity) {
+                    m_blocked++;
+                    m_notEmpty.notify_all();
+                    m_notFull.wait(lock, [&] { return m_queue.size() < m_capacity || m_closed; });
+                    // Woken up by close() with the queue still full: the input has nowhere to go
+                    if (m_queue.size() >= m_capacity) {
+                        m_dropped++;
+                        return;
+                    }
+                }
+                break;
+            case OverloadPolicy::DropOldest:
+                if (m_queue.size() >= m_capacity) {
+                    m_queue.pop_front();
+                    m_dropped++;
+                }
+                break;
+            case OverloadPolicy::DropNewest:
+                if (m_queue.size() >= m_capacity) {
+                    m_dropped++;
+                    return;
+                }
+                break;
+            case OverloadPolicy::Decimate:
+                if (m_queue.size() >= m_capacity - m_capacity / 4) {
+                    if (m_decimationCounters.size() <= input.m_id) m_decimationCounters.resize(input.m_id + 1, 0);
+                    if (m_decimationCounters[input.m_id]++ % std::max<uint32_t>(m_decimationFactor, 1) != 0) {
+                        m_decimated++;
+                        return;
+                    }
+                    if (m_queue.size() >= m_capacity) {
+                        m_dropped++;
+                        return;
+                    }
+                }
+                break;
+        }
+    }
+
+    m_queue.push_back(std::move(input));
+    if (m_queue.size() > m_highWater) m_highWater = m_queue.size();
+}
+
+/**
+ * @brief Retrieve the first input, waiting for one if needed.
+ * 
+ * @param out 
+ * @return true if an input was retrieved
+ * @return false if the queue is closed and empty
+ */
+
+bool DataQueue::pop(DataInput& out) {
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_notEmpty.wait(lock, [&] { return m_closed || !m_queue.empty(); });
+        if (m_queue.empty()) return false;
+        out = std::move(m_queue.front());
+        m_queue.pop_front();
+    }
+    if (m_capacity > 0) m_notFull.notify_one();
+    return true;
+}
+
+/**
+ * @brief Retrieve all pending inputs (or up to maxBatch) at once.
+ * 
+ * @param out emptied and filled with the retrieved inputs
+ * @param maxBatch 0 means no limit
+ * @return true if inputs were retrieved
+ * @return false if the queue is closed and empty
+ * 
+ * @details Waits for at least one input. When the whole queue
+ * fits in the batch, and the batch uses the queue's pool (see
+ * makeBatch), it is swapped with out in O(1), so the lock is held
+ * for a constant time regardless of the batch size.
+ */
+
+bool DataQueue::popBatch(Batch& out, size_t maxBatch) {
+    out.clear();
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_notEmpty.wait(lock, [&] { return m_closed || !m_queue.empty(); });
+        if (m_queue.empty()) return false;
+        if ((maxBatch == 0 || m_queue.size() <= maxBatch) && out.get_allocator() == m_queue.get_allocator()) {
+            out.swap(m_queue);
+        } else {
+            auto last = maxBatch == 0 ? m_queue.end() : m_queue.begin() + std::min(maxBatch, m_queue.size());
+            out.insert(out.end(), std::make_move_iterator(m_queue.begin()), std::make_move_iterator(last));
+            m_queue.erase(m_queue.begin(), last);
+        }
+    }
+    if (m_capacity > 0) m_notFull.notify_all();
+    return true;
+}
+
+bool DataQueue::popBatch(std::deque<DataInput>& out, size_t maxBatch) {
+    out.clear();
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_notEmpty.wait(lock, [&] { return m_closed || !m_queue.empty(); });
+        if (m_queue.empty()) return false;
+        auto last = maxBatch == 0 ? m_queue.end() : m_queue.begin() + std::min(maxBatch, m_queue.size());
+        out.insert(out.end(), std::make_move_iterator(m_queue.begin()), std::make_move_iterator(last));
+        m_queue.erase(m_queue.begin(), last);
+    }
+    if (m_capacity > 0) m_notFull.notify_all();
+    return true;
+}
+
+/**
+ * @brief Empty batch allocating from the queue's pool (must not outlive the queue).
+ */
+
+DataQueue::Batch DataQueue::makeBatch() {
+    return Batch(&m_pool);
+}
+
+/**
+ * @brief No more inputs will be produced. Wakes up every waiting thread.
+ */
+
+void DataQueue::close() {
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_closed = true;
+    }
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+}
+
+bool DataQueue::closed() const {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    return m_closed;
+}
+
+size_t DataQueue::size() const {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    return m_queue.size();
+}
+
+bool DataQueue::empty() const {
+    return size() == 0;
+}
+
+DataInput& DataQueue::front() {
+    return m_queue.front();
+}
+
+DataInput& DataQueue::back() {
+    return m_queue.back();
+}
+
+void DataQueue::pop() {
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_queue.pop_front();
+    }
+    if (m_capacity > 0) m_notFull.notify_one();
+}
@@ -0,0 +1,92 @@
+#ifndef DATAQUEUE_H
+#define DATAQUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "dataInput.h"
+
+/**
+ * @brief What a bounded DataQueue does when it is full.
+ * 
+ * Block: the producer waits until a collector makes room (the input
+ * is dropped if the queue is closed while it waits).
+ * DropOldest: the oldest pending input is discarded.
+ * DropNewest: the incoming input is discarded.
+ * Decimate: above the high watermark (3/4 of the capacity) only one
+ * out of m_decimationFactor inputs of each channel is accepted (a
+ * factor of 0 is treated as 1, keeping every input), and
+ * the incoming input is discarded if the queue is completely full.
+ */
+
+enum class OverloadPolicy { Block, DropOldest, DropNewest, Decimate };
+
+/**
+ * @class DataQueue
+ * 
+ * @brief Ingest buffer between the data generator and the collectors.
+ * 
+ * FIFO of DataInputs with its own mutex and condition variables. It
+ * can be bounded (m_capacity > 0), in which case the selected overload
+ * policy keeps memory flat under sustained overload, and the counters
+ * report how many inputs were dropped, decimated or had to wait. A
+ * capacity of 0 means unbounded (the original behaviour). Producers
+ * close() the queue when they are done, and pop() / popBatch() return
+ * false once the queue is closed and empty.
+ * 
+ * The deque nodes come from the queue's pool (m_pool), so once it has
+ * grown to the peak size pushing and popping doesn't allocate. Batches
+ * created with makeBatch() share the pool and are exchanged with the
+ * queue in O(1) by popBatch().
+ * 
+ */
+
+class DataQueue {
+
+    public:
+        using Batch = std::pmr::deque<DataInput>;
+
+        size_t m_capacity;
+        OverloadPolicy m_policy;
+        uint32_t m_decimationFactor = 10;
+
+        std::atomic<uint64_t> m_dropped{0};
+        std::atomic<uint64_t> m_decimated{0};
+        std::atomic<uint64_t> m_blocked{0};
+        std::atomic<size_t> m_highWater{0};
+
+        std::pmr::synchronized_pool_resource m_pool;
+        std::pmr::deque<DataInput> m_queue{&m_pool};
+        std::vector<uint32_t> m_decimationCounters;
+        bool m_closed = false;
+        mutable std::mutex m_mtx;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+
+        DataQueue(size_t capacity = 0, OverloadPolicy policy = OverloadPolicy::Block);
+
+        void push(DataInput&& input);
+        void pushBatch(std::vector<DataInput>& batch);
+        bool pop(DataInput& out);
+        bool popBatch(Batch& out, size_t maxBatch = 0);
+        bool popBatch(std::deque<DataInput>& out, size_t maxBatch = 0);
+        Batch makeBatch();
+        void close();
+        bool closed() const;
+
+        // std::queue-like accessors (not synchronised with the producers)
+        size_t size() const;
+        bool empty() const;
+        DataInput& front();
+        DataInput& back();
+        void pop();
+
+        void pushLocked(std::unique_lock<std::mutex>& lock, DataInput&& input);
+};
+
+#endif // DATAQUEUE_H
@@ -0,0 +1,123 @@
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <thread>
+#include <utility>
+
+#include "deadlineScheduler.h"
+
+/**
+ * @brief Scheduler of the channels [startIndex, endIndex) of a generator config.
+ *
+ * @details Every channel gets its rate from GeneratorConfig::channelRate.
+ */
+
+DeadlineScheduler::DeadlineScheduler(const GeneratorConfig& config, uint16_t startIndex, uint16_t endIndex)
+    : m_paced(config.m_paced)
+{
+    for (uint16_t channel = startIndex; channel < endIndex; channel++) addChannel(channel, config.channelRate(channel));
+}
+
+/**
+ * @brief Adds a channel sampled at rate hz (to the stream of that rate).
+ */
+
+void DeadlineScheduler::addChannel(uint16_t channelId, double rate) {
+    if (!(rate > 0.0)) return;
+    for (Stream& stream : m_streams) {
+        if (stream.m_rate == rate) {
+            stream.m_channels.push_back(channelId);
+            return;
+        }
+    }
+    Stream stream;
+    stream.m_rate = rate;
+    stream.m_channels.push_back(channelId);
+    m_streams.push_back(std::move(stream));
+}
+
+/**
+ * @brief Nominal time of sample k of a stream, from the start (ns).
+ */
+
+Timestamp DeadlineScheduler::deadline(double rate, uint64_t sample) {
+    return static_cast<Timestamp>(std::llround(static_cast<double>(sample) * 1e9 / rate));
+}
+
+/**
+ * @brief Runs the schedule for a duration.
+ *
+ * @param duration in ns; samples due at or after it are not taken
+ * @param tick called once per deadline with the deadline and the ids
+ * of every channel due at it
+ * @return uint64_t number of samples (channel datapoints) scheduled
+ */
+
+uint64_t DeadlineScheduler::run(Timestamp duration, const TickFunction& tick) {
+    using Due = std::pair<Timestamp, size_t>; // (deadline, stream)
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> heap;
+    for (size_t s = 0; s < m_streams.size(); s++) heap.emplace(deadline(m_streams[s].m_rate, m_streams[s].m_samples), s);
+
+    std::vector<uint16_t> due;
+    uint64_t samples = 0;
+    const Clock::time_point start = Clock::now();
+    while (!heap.empty() && heap.top().first < duration) {
+        const Timestamp now = heap.top().first;
+        Clock::time_point wake;
+        if (m_paced) {
+            Clock::time_point target = start + std::chrono::nanoseconds(now);
+            std::this_thread::sleep_until(target);
+            wake = Clock::now();
+            m_wakeLateness.record(std::chrono::duration_cast<std::chrono::nanoseconds>(wake - target).count());
+        }
+
+        due.clear();
+        while (!heap.empty() && heap.top().first == now) {
+            size_t s = heap.top().second;
+            heap.pop();
+            Stream& stream = m_streams[s];
+            if (m_paced && stream.m_samples > 0) {
+                Timestamp actual = std::chrono::duration_cast<std::chrono::nanoseconds>(wake - stream.m_lastWake).count();
+                Timestamp nominal = now - deadline(stream.m_rate, stream.m_samples - 1);
+                stream.m_periodJitter.record(actual - nominal);
+            }
+            stream.m_lastWake = wake;
+            stream.m_samples++;
+            due.insert(due.end(), stream.m_channels.begin(), stream.m_channels.end());
+            heap.emplace(deadline(stream.m_rate, stream.m_samples), s);
+        }
+
+        samples += due.size();
+        m_ticks++;
+        tick(now, due);
+    }
+    return samples;
+}
+
+/**
+ * @brief Period jitter of all the streams.
+ */
+
+JitterHistogram DeadlineScheduler::periodJitter() const {
+    JitterHistogram all;
+    for (const Stream& stream : m_streams) all.merge(stream.m_periodJitter);
+    return all;
+}
+
+/**
+ * @brief Print the achieved samples, wake-up lateness and period jitter of a run.
+ */
+
+void printSchedulerReport(const std::string& name, const DeadlineScheduler& scheduler) {
+    std::cout << name << ": " << scheduler.m_ticks << " ticks" << std::endl;
+    for (const DeadlineScheduler::Stream& stream : scheduler.m_streams) {
+        const JitterHistogram& jitter = stream.m_periodJitter;
+        std::cout << "  " << stream.m_rate << " hz x " << stream.m_channels.size() << " channels: ";
+        std::cout << stream.m_samples << " samples, period jitter mean " << jitter.mean() / kNanosPerMicro;
+        std::cout << " us, p99 < " << jitter.percentile(99.0) / kNanosPerMicro << " us, max ";
+        std::cout << jitter.m_max / kNanosPerMicro << " us" << std::endl;
+    }
+    std::cout << "  Wake-up lateness histogram:" << std::endl;
+    std::cout << scheduler.m_wakeLateness.toString();
+}
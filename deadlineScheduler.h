@@ -0,0 +1,68 @@
+#ifndef DEADLINESCHEDULER_H
+#define DEADLINESCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "generatorConfig.h"
+#include "jitterHistogram.h"
+#include "timestamp.h"
+
+/**
+ * @class DeadlineScheduler
+ *
+ * @brief Acquisition scheduler driven by absolute deadlines.
+ *
+ * Channels are added with their own rate (any rate in hz) and grouped
+ * in streams of equal rate. Sample k of a stream is due at the
+ * absolute deadline start + round(k * 1e9 / rate) ns, computed from k
+ * rather than accumulated, and the thread sleeps with sleep_until on
+ * the steady clock: time spent generating, queueing or waking up late
+ * delays one sample, never the following ones, so rates don't drift.
+ * The next deadline of every stream is kept in a min-heap; streams due
+ * at the same deadline are batched in a single tick (the channel ids
+ * of all of them, in one call).
+ *
+ * Datapoints are stamped with their nominal deadline. How late each
+ * tick woke up is recorded in m_wakeLateness, and the error of every
+ * period (time between 2 consecutive samples of a stream against its
+ * nominal period) in the stream's m_periodJitter histogram.
+ * Unpaced runs never sleep and record no jitter.
+ *
+ */
+
+class DeadlineScheduler {
+
+    public:
+        using Clock = std::chrono::steady_clock;
+        using TickFunction = std::function<void(Timestamp, const std::vector<uint16_t>&)>;
+
+        struct Stream {
+            double m_rate;
+            std::vector<uint16_t> m_channels;
+            uint64_t m_samples = 0;
+            Clock::time_point m_lastWake;
+            JitterHistogram m_periodJitter;
+        };
+
+        std::vector<Stream> m_streams;
+        JitterHistogram m_wakeLateness;
+        uint64_t m_ticks = 0;
+        bool m_paced = true;
+
+        DeadlineScheduler() = default;
+        DeadlineScheduler(const GeneratorConfig& config, uint16_t startIndex, uint16_t endIndex);
+
+        void addChannel(uint16_t channelId, double rate);
+        uint64_t run(Timestamp duration, const TickFunction& tick);
+        JitterHistogram periodJitter() const;
+
+        static Timestamp deadline(double rate, uint64_t sample);
+};
+
+void printSchedulerReport(const std::string& name, const DeadlineScheduler& scheduler);
+
+#endif // DEADLINESCHEDULER_H
@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include "executor.h"
+
+Executor::Executor(unsigned numThreads) {
+    for (unsigned i = 0; i < std::max(1u, numThreads); i++) {
+        m_threads.emplace_back([this] { workerLoop(); });
+    }
+}
+
+Executor::~Executor() {
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_idle.wait(lock, [this] { return m_outstanding == 0; });
+    }
+    shutdown();
+}
+
+/**
+ * @brief Queue a suspended coroutine to be resumed by a worker thread.
+ */
+
+void Executor::post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_ready.push_back(handle);
+    }
+    m_wake.notify_one();
+}
+
+Executor::ScheduleAwaiter Executor::schedule() {
+    return ScheduleAwaiter{*this};
+}
+
+Executor::SleepAwaiter Executor::sleepUntil(Clock::time_point deadline) {
+    return SleepAwaiter{*this, deadline};
+}
+
+void Executor::SleepAwaiter::await_suspend(std::coroutine_handle<> handle) const {
+    // The coroutine (and this awaiter) can be resumed as soon as the timer is queued
+    Executor& executor = m_executor;
+    {
+        std::lock_guard<std::mutex> lock(executor.m_mtx);
+        executor.m_timers.push(ScheduledResume{m_deadline, handle});
+    }
+    // A sleeping worker may be waiting for a later deadline
+    executor.m_wake.notify_one();
+}
+
+/**
+ * @brief Run a task on the pool; join() waits for it.
+ */
+
+void Executor::spawn(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_outstanding++;
+    }
+    runDetached(std::move(task));
+}
+
+DetachedTask Executor::runDetached(Task task) {
+    co_await schedule();
+    std::exception_ptr exception;
+    try {
+        co_await task;
+    } catch (...) {
+        exception = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (exception && !m_exception) m_exception = exception;
+    if (--m_outstanding == 0) m_idle.notify_all();
+}
+
+/**
+ * @brief Wait until every spawned task has completed.
+ */
+
+void Executor::join() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_idle.wait(lock, [this] { return m_outstanding == 0; });
+    if (m_exception) std::rethrow_exception(std::exchange(m_exception, nullptr));
+}
+
+void Executor::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+uint64_t Executor::resumed() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_resumed;
+}
+
+/**
+ * @brief Worker thread: fire due timers, resume ready coroutines, sleep until the next deadline.
+ */
+
+void Executor::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    while (true) {
+        auto now = Clock::now();
+        size_t fired = 0;
+        while (!m_timers.empty() && m_timers.top().m_deadline <= now) {
+            m_ready.push_back(m_timers.top().m_handle);
+            m_timers.pop();
+            fired++;
+        }
+        if (fired > 1) m_wake.notify_all();
+
+        if (!m_ready.empty()) {
+            std::coroutine_handle<> handle = m_ready.front();
+            m_ready.pop_front();
+            m_resumed++;
+            lock.unlock();
+            handle.resume();
+            lock.lock();
+            continue;
+        }
+        if (m_stopping) break;
+        if (m_timers.empty()) m_wake.wait(lock);
+        else m_wake.wait_until(lock, m_timers.top().m_deadline);
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "task.h"
+
+/**
+ * @class Executor
+ * 
+ * @brief Small thread pool resuming coroutines.
+ * 
+ * Coroutines get onto the pool with co_await schedule(), or wait on
+ * it with co_await sleepUntil(deadline) (timers are kept in a min-heap
+ * and fired by the worker threads, so pacing doesn't block a thread).
+ * Awaitables like AsyncQueue resume their waiters with post().
+ * spawn() starts a Task on the pool, join() waits until every spawned
+ * task has completed (rethrowing the first exception), and shutdown()
+ * stops the threads; the destructor does both.
+ * 
+ */
+
+class Executor {
+
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct ScheduledResume {
+            Clock::time_point m_deadline;
+            std::coroutine_handle<> m_handle;
+
+            bool operator>(const ScheduledResume& other) const { return m_deadline > other.m_deadline; }
+        };
+
+        struct ScheduleAwaiter {
+            Executor& m_executor;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) const { m_executor.post(handle); }
+            void await_resume() const noexcept {}
+        };
+
+        struct SleepAwaiter {
+            Executor& m_executor;
+            Clock::time_point m_deadline;
+
+            bool await_ready() const noexcept { return Clock::now() >= m_deadline; }
+            void await_suspend(std::coroutine_handle<> handle) const;
+            void await_resume() const noexcept {}
+        };
+
+        std::vector<std::thread> m_threads;
+        std::deque<std::coroutine_handle<>> m_ready;
+        std::priority_queue<ScheduledResume, std::vector<ScheduledResume>, std::greater<ScheduledResume>> m_timers;
+        size_t m_outstanding = 0;
+        bool m_stopping = false;
+        uint64_t m_resumed = 0;
+        std::exception_ptr m_exception;
+        std::mutex m_mtx;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+
+        explicit Executor(unsigned numThreads = 2);
+        ~Executor();
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        void post(std::coroutine_handle<> handle);
+        ScheduleAwaiter schedule();
+        SleepAwaiter sleepUntil(Clock::time_point deadline);
+        void spawn(Task task);
+        void join();
+        void shutdown();
+        uint64_t resumed();
+
+    private:
+        void workerLoop();
+        DetachedTask runDetached(Task task);
+};
+
+#endif // EXECUTOR_H
@@ -0,0 +1,142 @@
+#include <cmath>
+#include <limits>
+
+#include "exprEvaluator.h"
+
+ExprEvaluator::ExprEvaluator(
+    std::unordered_map<uint16_t, DataChannel>& channels, 
+    const ChannelExpr& expr, 
+    uint16_t referenceId)
+    : m_expr(expr) 
+    {
+        if (expr.m_op == ExprOp::Channel) {
+            m_channel = &channels[expr.m_channelId];
+            m_reference = expr.m_channelId == referenceId;
+        }
+        m_operands.reserve(expr.m_operands.size());
+        for (const ChannelExpr& operand : expr.m_operands) m_operands.emplace_back(channels, operand, referenceId);
+    }
+
+/**
+ * @brief Arithmetic kernels: plain loops over restrict pointers, vectorized by the compiler.
+ */
+
+template <ExprOp op>
+static void applyKernel(double* __restrict out, const double* __restrict right, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if constexpr (op == ExprOp::Add) out[i] = out[i] + right[i];
+        else if constexpr (op == ExprOp::Subtract) out[i] = out[i] - right[i];
+        else if constexpr (op == ExprOp::Multiply) out[i] = out[i] * right[i];
+        else out[i] = out[i] / right[i];
+    }
+}
+
+template <ExprOp op>
+static void applyScalarKernel(double* __restrict out, double right, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if constexpr (op == ExprOp::Add) out[i] = out[i] + right;
+        else if constexpr (op == ExprOp::Subtract) out[i] = out[i] - right;
+        else if constexpr (op == ExprOp::Multiply) out[i] = out[i] * right;
+        else out[i] = out[i] / right;
+    }
+}
+
+template <ExprOp op>
+static void applyBinary(double* out, ExprEvaluator& right, const Timestamp* timestamps, 
+    size_t referenceIndex, size_t count, std::vector<double>& scratch) 
+{
+    // A constant right operand doesn't need a buffer
+    if (right.m_expr.m_op == ExprOp::Constant) {
+        applyScalarKernel<op>(out, right.m_expr.m_constant, count);
+        return;
+    }
+    scratch.resize(count);
+    right.evaluate(timestamps, referenceIndex, count, scratch.data());
+    applyKernel<op>(out, scratch.data(), count);
+}
+
+/**
+ * @brief Values of the expression at the given timestamps.
+ * 
+ * @param timestamps timestamps of the block (of the reference channel)
+ * @param referenceIndex index of timestamps[0] in the reference channel
+ * @param count 
+ * @param out 
+ */
+
+void ExprEvaluator::evaluate(const Timestamp* timestamps, size_t referenceIndex, size_t count, double* out) {
+    switch (m_expr.m_op) {
+        case ExprOp::Constant:
+            std::fill(out, out + count, m_expr.m_constant);
+            return;
+        case ExprOp::Channel:
+            if (m_reference) m_channel->m_values.decode(referenceIndex, referenceIndex + count, out);
+            else sampleAndHold(timestamps, count, out);
+            return;
+        case ExprOp::MovingAverage:
+            m_operands[0].evaluate(timestamps, referenceIndex, count, out);
+            movingAverage(timestamps, count, out);
+            return;
+        default:
+            break;
+    }
+
+    m_operands[0].evaluate(timestamps, referenceIndex, count, out);
+    switch (m_expr.m_op) {
+        case ExprOp::Add: applyBinary<ExprOp::Add>(out, m_operands[1], timestamps, referenceIndex, count, m_scratch); break;
+        case ExprOp::Subtract: applyBinary<ExprOp::Subtract>(out, m_operands[1], timestamps, referenceIndex, count, m_scratch); break;
+        case ExprOp::Multiply: applyBinary<ExprOp::Multiply>(out, m_operands[1], timestamps, referenceIndex, count, m_scratch); break;
+        case ExprOp::Divide: applyBinary<ExprOp::Divide>(out, m_operands[1], timestamps, referenceIndex, count, m_scratch); break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Values of a (non reference) channel held at the given timestamps.
+ * 
+ * @details Only the channel's datapoints covering the block are
+ * decoded (from the last one <= timestamps[0]), then both sorted
+ * sequences are walked together.
+ */
+
+void ExprEvaluator::sampleAndHold(const Timestamp* timestamps, size_t count, double* out) {
+    if (count == 0) return;
+    size_t first = m_channel->upperBound(timestamps[0]);
+    size_t last = m_channel->upperBound(timestamps[count - 1]);
+    size_t from = first > 0 ? first - 1 : 0;
+    m_sourceTimestamps.resize(last - from);
+    m_sourceValues.resize(last - from);
+    m_channel->m_timestamps.decode(from, last, m_sourceTimestamps.data());
+    m_channel->m_values.decode(from, last, m_sourceValues.data());
+
+    double held = std::numeric_limits<double>::quiet_NaN();
+    size_t position = 0;
+    for (size_t i = 0; i < count; i++) {
+        while (position < m_sourceTimestamps.size() && m_sourceTimestamps[position] <= timestamps[i]) {
+            held = m_sourceValues[position++];
+        }
+        out[i] = held;
+    }
+}
+
+/**
+ * @brief Replace the operand's values by their moving average (in place).
+ * 
+ * @details Keeps the (timestamp, value) pairs of the window and their
+ * running sum across blocks, so every value is added and removed once.
+ */
+
+void ExprEvaluator::movingAverage(const Timestamp* timestamps, size_t count, double* out) {
+    for (size_t i = 0; i < count; i++) {
+        if (!std::isnan(out[i])) {
+            m_window.emplace_back(timestamps[i], out[i]);
+            m_windowSum += out[i];
+        }
+        while (!m_window.empty() && m_window.front().first <= timestamps[i] - m_expr.m_window) {
+            m_windowSum -= m_window.front().second;
+            m_window.pop_front();
+        }
+        if (m_window.empty()) m_windowSum = 0.0; // drop the accumulated rounding error
+        out[i] = m_window.empty() ? std::numeric_limits<double>::quiet_NaN() : m_windowSum / m_window.size();
+    }
+}
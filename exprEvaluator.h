@@ -0,0 +1,50 @@
+#ifndef EXPREVALUATOR_H
+#define EXPREVALUATOR_H
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "channelExpr.h"
+#include "dataChannel.h"
+#include "timestamp.h"
+
+/**
+ * @class ExprEvaluator
+ * 
+ * @brief Evaluates a ChannelExpr one block of timestamps at a time.
+ * 
+ * Mirrors the expression tree (one evaluator per node) and keeps the
+ * state needed between blocks: the window of the moving averages and
+ * the scratch buffers of the binary nodes, sized to one block. Blocks
+ * must be evaluated in increasing time order. Channels other than the
+ * reference one are aligned by sample-and-hold: the value at t is the
+ * last one with timestamp <= t (NaN before the first datapoint).
+ * 
+ */
+
+class ExprEvaluator {
+
+    public:
+        const ChannelExpr& m_expr;
+        const DataChannel* m_channel = nullptr;
+        bool m_reference = false;
+        std::vector<ExprEvaluator> m_operands;
+        std::vector<double> m_scratch;
+        std::vector<Timestamp> m_sourceTimestamps;
+        std::vector<double> m_sourceValues;
+        std::deque<std::pair<Timestamp, double>> m_window;
+        double m_windowSum = 0.0;
+
+        ExprEvaluator(std::unordered_map<uint16_t, DataChannel>& channels, const ChannelExpr& expr, uint16_t referenceId);
+
+        void evaluate(const Timestamp* timestamps, size_t referenceIndex, size_t count, double* out);
+
+    private:
+        void sampleAndHold(const Timestamp* timestamps, size_t count, double* out);
+        void movingAverage(const Timestamp* timestamps, size_t count, double* out);
+};
+
+#endif // EXPREVALUATOR_H
@@ -1,3 +1,5 @@
+#include <bit>
+
 #include "dataChannel.h"
 #include "extractedSubChannel.h"
 
@@ -10,10 +12,80 @@ ExtractedSubChannel::ExtractedSubChannel(const DataChannel& dataChannel, const i
         m_values.reserve(size);
     }
 
+ExtractedSubChannel::ExtractedSubChannel(const DataChannel& dataChannel, std::pmr::memory_resource* resource)
+    : m_id(dataChannel.m_id),
+      m_name(dataChannel.m_name),
+      m_unit(dataChannel.m_unit),
+      m_timestamps(resource),
+      m_values(resource),
+      m_nanMask(resource) {}
+
 ExtractedSubChannel::ExtractedSubChannel(ExtractedSubChannel&& other) noexcept
     : m_id(other.m_id),
       m_name(std::move(other.m_name)),
       m_unit(std::move(other.m_unit)),
       m_timestamps(std::move(other.m_timestamps)),
       m_values(std::move(other.m_values)),
-      m_nan_dps(std::move(other.m_nan_dps)) {}
\ No newline at end of file
+      m_nanMask(std::move(other.m_nanMask)),
+      m_rangeStart(other.m_rangeStart),
+      m_rangeSize(other.m_rangeSize),
+      m_lateStart(other.m_lateStart),
+      m_lateSize(other.m_lateSize),
+      m_nanCount(other.m_nanCount) {}
+
+/**
+ * @brief Positions (within the extracted range) of the NaN datapoints.
+ * 
+ * @details Scans the NaN bitmap one word at a time, so ranges
+ * without NaN values cost one comparison per 64 datapoints.
+ */
+
+std::vector<size_t> ExtractedSubChannel::nanPositions() const {
+    std::vector<size_t> positions;
+    positions.reserve(m_nanCount);
+    for (size_t word = 0; word < m_nanMask.size(); word++) {
+        uint64_t bits = m_nanMask[word];
+        while (bits != 0) {
+            positions.push_back(word * 64 + std::countr_zero(bits));
+            bits &= bits - 1;
+        }
+    }
+    return positions;
+}
+
+/**
+ * @brief Materialize the NaN datapoints of the range.
+ * 
+ * @param dataChannel the channel the subset was extracted from
+ * 
+ * @details Only valid while the channel's datapoints in the
+ * extracted range (and its side buffer) are unchanged.
+ */
+
+std::vector<DataPoint> ExtractedSubChannel::nanDatapoints(const DataChannel& dataChannel) const {
+    std::vector<DataPoint> datapoints;
+    datapoints.reserve(m_nanCount);
+    if (m_lateSize == 0) {
+        for (size_t position : nanPositions()) datapoints.push_back(dataChannel.at(m_rangeStart + position));
+        return datapoints;
+    }
+
+    // Walk the range in the merged order of the columns and the side buffer
+    size_t column = m_rangeStart;
+    size_t columnEnd = m_rangeStart + m_rangeSize - m_lateSize;
+    size_t late = m_lateStart;
+    size_t lateEnd = m_lateStart + m_lateSize;
+    std::vector<size_t> positions = nanPositions();
+    size_t next = 0;
+    for (size_t position = 0; next < positions.size(); position++) {
+        bool fromLate = late < lateEnd
+            && (column == columnEnd || dataChannel.m_late[late].m_timestamp < dataChannel.timestampAt(column));
+        if (position == positions[next]) {
+            datapoints.push_back(fromLate ? dataChannel.m_late[late] : dataChannel.at(column));
+            next++;
+        }
+        if (fromLate) late++;
+        else column++;
+    }
+    return datapoints;
+}
@@ -1,11 +1,15 @@
 #ifndef EXTRACTEDSUBCHANNEL_H
 #define EXTRACTEDSUBCHANNEL_H
 
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "dataChannel.h"
 #include "dataPoint.h"
+#include "timestamp.h"
 
 /**
  * @class ExtractedSubChannel
@@ -18,8 +22,18 @@
  * The reason behind this choice was to easily access a vector
  * with all the values for faster operations to the subset, and
  * leverage other functions which perform calculations on vectors
- * more efficiently. It also contains the NaN datapoints (separately
- * from the valuable data, allowing them to be analysed on their own).
+ * more efficiently. NaN datapoints are left out of the vectors and
+ * described by a bitmap over the extracted range (bit j set when
+ * the j-th datapoint of the range, m_rangeStart + j in the channel,
+ * is NaN), so they can be analysed on their own without being copied
+ * unless nanDatapoints() is called. Late datapoints still in the
+ * channel's side buffer (m_late[m_lateStart, m_lateStart +
+ * m_lateSize)) are interleaved in the range in timestamp order, after
+ * the column datapoints with the same timestamp (as mergeLate would
+ * place them), so the range has m_rangeSize - m_lateSize datapoints
+ * from the columns. The vectors allocate from the
+ * memory resource given at construction (the default one otherwise),
+ * so queries can extract into caller-supplied memory (SubChannelMap).
  * 
  */
 
@@ -29,13 +43,24 @@ class ExtractedSubChannel {
         uint16_t m_id;
         std::string m_name;
         std::string m_unit;
-        std::vector<double> m_timestamps;
-        std::vector<double> m_values;
-        std::vector<DataPoint> m_nan_dps;
+        std::pmr::vector<Timestamp> m_timestamps;
+        std::pmr::vector<double> m_values;
+        std::pmr::vector<uint64_t> m_nanMask;
+        size_t m_rangeStart = 0;
+        size_t m_rangeSize = 0;
+        size_t m_lateStart = 0;
+        size_t m_lateSize = 0;
+        size_t m_nanCount = 0;
 
         ExtractedSubChannel() = default;
         ExtractedSubChannel(const DataChannel& dataChannel, const int size);
+        ExtractedSubChannel(const DataChannel& dataChannel, std::pmr::memory_resource* resource);
         ExtractedSubChannel(ExtractedSubChannel&& other) noexcept;
+
+        std::vector<size_t> nanPositions() const;
+        std::vector<DataPoint> nanDatapoints(const DataChannel& dataChannel) const;
 };
 
-#endif // EXTRACTEDSUBCHANNEL_H
\ No newline at end of file
+using SubChannelMap = std::pmr::unordered_map<uint16_t, ExtractedSubChannel>;
+
+#endif // EXTRACTEDSUBCHANNEL_H
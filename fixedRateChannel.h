@@ -0,0 +1,166 @@
+#ifndef FIXEDRATECHANNEL_H
+#define FIXEDRATECHANNEL_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "dataPoint.h"
+#include "timestamp.h"
+
+/**
+ * @class FixedRateChannel
+ *
+ * @brief Channel sampled at a fixed rate, with implicit timestamps.
+ *
+ * Specialization of DataChannel for channels with a known period
+ * (PeriodNs, a compile-time constant): only the timestamp of the first
+ * sample is stored, sample i is at m_start + i * PeriodNs, so the
+ * timestamp column disappears and lowerBound / upperBound are O(1)
+ * index arithmetic instead of a binary search. Values are stored as
+ * ValueT (double or float).
+ *
+ * Inserted timestamps are snapped to the nearest slot of the grid.
+ * Missed samples leave a gap: the slot holds NaN and its bit in the
+ * gap marker bitmap m_present (bit i set when sample i was received)
+ * is clear, so queries omit gaps like NaN values, and a late sample
+ * can still fill its gap. Samples before the first one or for a slot
+ * that is already filled are rejected and counted in m_rejected.
+ *
+ */
+
+template <Timestamp PeriodNs, typename ValueT = double>
+class FixedRateChannel {
+
+    static_assert(PeriodNs > 0, "the period must be positive");
+    static_assert(std::is_floating_point_v<ValueT>, "gaps and NaN values need a floating point value type");
+
+    public:
+        static constexpr Timestamp kPeriod = PeriodNs;
+
+        uint16_t m_id = 0;
+        std::string m_name;
+        std::string m_unit;
+        Timestamp m_start = 0;
+        std::vector<ValueT> m_values;
+        std::vector<uint64_t> m_present;
+        size_t m_gapCount = 0;
+        uint64_t m_rejected = 0;
+
+        FixedRateChannel() = default;
+        FixedRateChannel(uint16_t id, const std::string& name, const std::string& unit)
+            : m_id(id), m_name(name), m_unit(unit) {}
+
+        size_t size() const { return m_values.size(); }
+        bool empty() const { return m_values.empty(); }
+        size_t gapCount() const { return m_gapCount; }
+        Timestamp timestampAt(size_t index) const { return m_start + static_cast<Timestamp>(index) * PeriodNs; }
+        double valueAt(size_t index) const { return static_cast<double>(m_values[index]); }
+        DataPoint at(size_t index) const { return DataPoint(timestampAt(index), valueAt(index)); }
+        bool isPresent(size_t index) const { return (m_present[index / 64] >> (index % 64)) & 1; }
+
+        size_t lowerBound(Timestamp timestamp) const;
+        size_t upperBound(Timestamp timestamp) const;
+
+        void reserve(size_t size);
+        bool insert(const DataPoint& dp);
+        size_t memoryBytes() const;
+
+    private:
+        void appendSlot(ValueT value, bool present);
+};
+
+/**
+ * @brief Index of the first sample at or after the timestamp (O(1)).
+ */
+
+template <Timestamp PeriodNs, typename ValueT>
+size_t FixedRateChannel<PeriodNs, ValueT>::lowerBound(Timestamp timestamp) const {
+    if (empty() || timestamp <= m_start) return 0;
+    Timestamp index = (timestamp - m_start + PeriodNs - 1) / PeriodNs;
+    return index < static_cast<Timestamp>(size()) ? static_cast<size_t>(index) : size();
+}
+
+/**
+ * @brief Index of the first sample after the timestamp (O(1)).
+ */
+
+template <Timestamp PeriodNs, typename ValueT>
+size_t FixedRateChannel<PeriodNs, ValueT>::upperBound(Timestamp timestamp) const {
+    if (empty() || timestamp < m_start) return 0;
+    Timestamp index = (timestamp - m_start) / PeriodNs + 1;
+    return index < static_cast<Timestamp>(size()) ? static_cast<size_t>(index) : size();
+}
+
+template <Timestamp PeriodNs, typename ValueT>
+void FixedRateChannel<PeriodNs, ValueT>::reserve(size_t size) {
+    m_values.reserve(size);
+    m_present.reserve((size + 63) / 64);
+}
+
+/**
+ * @brief Stores a sample in its slot of the grid.
+ *
+ * @param dp
+ * @return true if stored (appended, or filling a gap)
+ * @return false if rejected (before the first sample, or slot already filled)
+ *
+ * @details The first sample sets m_start. Slots skipped between the
+ * last sample and this one are marked as gaps.
+ */
+
+template <Timestamp PeriodNs, typename ValueT>
+bool FixedRateChannel<PeriodNs, ValueT>::insert(const DataPoint& dp) {
+    if (empty()) m_start = dp.m_timestamp;
+    if (dp.m_timestamp < m_start - PeriodNs / 2) {
+        m_rejected++;
+        return false;
+    }
+
+    size_t slot = static_cast<size_t>((dp.m_timestamp - m_start + PeriodNs / 2) / PeriodNs);
+    ValueT value = static_cast<ValueT>(dp.m_value);
+    if (slot < size()) {
+        if (isPresent(slot)) {
+            m_rejected++;
+            return false;
+        }
+        m_values[slot] = value;
+        m_present[slot / 64] |= uint64_t(1) << (slot % 64);
+        m_gapCount--;
+        return true;
+    }
+
+    while (size() < slot) {
+        appendSlot(std::numeric_limits<ValueT>::quiet_NaN(), false);
+        m_gapCount++;
+    }
+    appendSlot(value, true);
+    return true;
+}
+
+template <Timestamp PeriodNs, typename ValueT>
+void FixedRateChannel<PeriodNs, ValueT>::appendSlot(ValueT value, bool present) {
+    size_t index = size();
+    if (index % 64 == 0) m_present.push_back(0);
+    m_present.back() |= uint64_t(present) << (index % 64);
+    m_values.push_back(value);
+}
+
+/**
+ * @brief Approximate memory used by the samples, in bytes.
+ */
+
+template <Timestamp PeriodNs, typename ValueT>
+size_t FixedRateChannel<PeriodNs, ValueT>::memoryBytes() const {
+    return m_values.capacity() * sizeof(ValueT) + m_present.capacity() * sizeof(uint64_t);
+}
+
+// Channel types of the generator's sample rate groups
+using FixedRate100Hz = FixedRateChannel<10 * kNanosPerMilli>;
+using FixedRate50Hz = FixedRateChannel<20 * kNanosPerMilli>;
+using FixedRate25Hz = FixedRateChannel<40 * kNanosPerMilli>;
+using FixedRate10Hz = FixedRateChannel<100 * kNanosPerMilli>;
+
+#endif // FIXEDRATECHANNEL_H
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "flatBufferWriter.h"
+
+FlatBufferWriter::FlatBufferWriter() 
+    : m_buffer(4, 0) {}
+
+void FlatBufferWriter::beginTable() {
+    m_fieldIndices.clear();
+    m_fieldSizes.clear();
+    m_fieldValues.clear();
+}
+
+/**
+ * @brief Scalar field (bool / enum / integer) of size 1, 2, 4 or 8 bytes.
+ */
+
+void FlatBufferWriter::addScalar(int index, uint64_t value, size_t size) {
+    m_fieldIndices.push_back(index);
+    m_fieldSizes.push_back(size);
+    m_fieldValues.push_back(value);
+}
+
+/**
+ * @brief Offset field (table, string, vector), linked later with patchOffset().
+ */
+
+void FlatBufferWriter::addOffset(int index) {
+    addScalar(index, 0, 4);
+}
+
+/**
+ * @brief Write the vtable and the table. Returns the table position.
+ * 
+ * @details Fields are laid out by decreasing size so that they are
+ * aligned without padding. fieldPosition() then gives where each one
+ * was written.
+ */
+
+size_t FlatBufferWriter::endTable() {
+    std::vector<size_t> order(m_fieldIndices.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return m_fieldSizes[a] > m_fieldSizes[b]; });
+
+    // Table layout, relative to its (8 byte aligned) start: soffset to the vtable, then the fields
+    std::vector<size_t> relative(m_fieldIndices.size());
+    size_t inlineSize = 4;
+    for (size_t i : order) {
+        inlineSize = (inlineSize + m_fieldSizes[i] - 1) / m_fieldSizes[i] * m_fieldSizes[i];
+        relative[i] = inlineSize;
+        inlineSize += m_fieldSizes[i];
+    }
+    int slots = m_fieldIndices.empty() ? 0 : *std::max_element(m_fieldIndices.begin(), m_fieldIndices.end()) + 1;
+
+    align(2);
+    size_t vtable = m_buffer.size();
+    std::vector<uint16_t> entries(2 + slots, 0);
+    entries[0] = static_cast<uint16_t>(4 + 2 * slots);
+    entries[1] = static_cast<uint16_t>(inlineSize);
+    for (size_t i = 0; i < m_fieldIndices.size(); i++) entries[2 + m_fieldIndices[i]] = static_cast<uint16_t>(relative[i]);
+    m_buffer.resize(vtable + entries.size() * 2);
+    write(vtable, entries.data(), entries.size() * 2);
+
+    align(8);
+    size_t table = m_buffer.size();
+    m_buffer.resize(table + inlineSize, 0);
+    int32_t soffset = static_cast<int32_t>(table - vtable);
+    write(table, &soffset, 4);
+
+    m_fieldPositions.assign(slots, 0);
+    for (size_t i = 0; i < m_fieldIndices.size(); i++) {
+        write(table + relative[i], &m_fieldValues[i], m_fieldSizes[i]); // little endian
+        m_fieldPositions[m_fieldIndices[i]] = table + relative[i];
+    }
+    return table;
+}
+
+size_t FlatBufferWriter::fieldPosition(int index) const {
+    return m_fieldPositions[index];
+}
+
+size_t FlatBufferWriter::addString(const std::string& value) {
+    align(4);
+    size_t position = m_buffer.size();
+    uint32_t length = static_cast<uint32_t>(value.size());
+    m_buffer.resize(position + 4 + value.size() + 1, 0);
+    write(position, &length, 4);
+    write(position + 4, value.data(), value.size());
+    return position;
+}
+
+/**
+ * @brief Vector of scalars or structs (elements aligned to alignment).
+ */
+
+size_t FlatBufferWriter::addVector(const void* data, size_t count, size_t elementSize, size_t alignment) {
+    alignment = std::max<size_t>(alignment, 4);
+    size_t position = m_buffer.size();
+    while ((position + 4) % alignment != 0) position++;
+    m_buffer.resize(position + 4 + count * elementSize, 0);
+    uint32_t length = static_cast<uint32_t>(count);
+    write(position, &length, 4);
+    if (count > 0) write(position + 4, data, count * elementSize);
+    return position;
+}
+
+/**
+ * @brief Vector of offsets; element i (at position + 4 + 4 * i) is linked with patchOffset().
+ */
+
+size_t FlatBufferWriter::addOffsetVector(size_t count) {
+    std::vector<uint32_t> placeholders(count, 0);
+    return addVector(placeholders.data(), count, 4, 4);
+}
+
+void FlatBufferWriter::patchOffset(size_t at, size_t target) {
+    uint32_t offset = static_cast<uint32_t>(target - at);
+    write(at, &offset, 4);
+}
+
+/**
+ * @brief Link the root table and pad the buffer to 8 bytes.
+ */
+
+void FlatBufferWriter::finish(size_t root) {
+    patchOffset(0, root);
+    align(8);
+}
+
+void FlatBufferWriter::align(size_t alignment) {
+    m_buffer.resize((m_buffer.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+void FlatBufferWriter::write(size_t position, const void* data, size_t size) {
+    std::memcpy(m_buffer.data() + position, data, size);
+}
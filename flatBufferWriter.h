@@ -0,0 +1,54 @@
+#ifndef FLATBUFFERWRITER_H
+#define FLATBUFFERWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class FlatBufferWriter
+ * 
+ * @brief Minimal FlatBuffers serializer (enough for the Arrow IPC metadata).
+ * 
+ * Unlike the official builder it writes front to back: a table is
+ * written with placeholders for its offset fields, and the objects they
+ * point to (tables, strings, vectors) are appended afterwards and linked
+ * with patchOffset(), so offsets always point forward as the format
+ * requires. Each table gets its own vtable, written right before it.
+ * Scalars are aligned to their size and structs / tables to 8 bytes
+ * from the start of the buffer, which starts with the root offset.
+ * 
+ */
+
+class FlatBufferWriter {
+
+    public:
+        std::vector<uint8_t> m_buffer;
+
+        // Fields of the table being built (index in the schema, size, value), and where endTable() wrote them
+        std::vector<int> m_fieldIndices;
+        std::vector<size_t> m_fieldSizes;
+        std::vector<uint64_t> m_fieldValues;
+        std::vector<size_t> m_fieldPositions;
+
+        FlatBufferWriter();
+
+        void beginTable();
+        void addScalar(int index, uint64_t value, size_t size);
+        void addOffset(int index);
+        size_t endTable();
+        size_t fieldPosition(int index) const;
+
+        size_t addString(const std::string& value);
+        size_t addVector(const void* data, size_t count, size_t elementSize, size_t alignment);
+        size_t addOffsetVector(size_t count);
+        void patchOffset(size_t at, size_t target);
+        void finish(size_t root);
+
+    private:
+        void align(size_t alignment);
+        void write(size_t position, const void* data, size_t size);
+};
+
+#endif // FLATBUFFERWRITER_H
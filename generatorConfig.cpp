@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cmath>
+
+#include "generatorConfig.h"
+
+/**
+ * @brief Whether the config can be run: at least one group, and every rate finite and positive.
+ */
+
+bool GeneratorConfig::valid() const {
+    auto positive = [](double rate) { return std::isfinite(rate) && rate > 0.0; };
+    return !m_groupRates.empty()
+        && std::all_of(m_groupRates.begin(), m_groupRates.end(), positive)
+        && std::all_of(m_channelRates.begin(), m_channelRates.end(), positive);
+}
+
+/**
+ * @brief Highest group or channel rate (0 without any rate, see valid()).
+ */
+
+double GeneratorConfig::maxRate() const {
+    double rate = 0.0;
+    for (double groupRate : m_groupRates) rate = std::max(rate, groupRate);
+    for (double channelRate : m_channelRates) rate = std::max(rate, channelRate);
+    return rate;
+}
+
+double GeneratorConfig::basePeriod() const {
+    return 1000.0 / maxRate();
+}
+
+uint16_t GeneratorConfig::groupStart(size_t group) const {
+    return static_cast<uint16_t>(group * (m_numChannels / m_groupRates.size()));
+}
+
+uint16_t GeneratorConfig::groupEnd(size_t group) const {
+    if (group + 1 == m_groupRates.size()) return m_numChannels;
+    return groupStart(group + 1);
+}
+
+/**
+ * @brief Whether a group has to be sampled in the given tick.
+ * 
+ * @details Ticks run at the maximum rate (starting at 1). A group
+ * with rate r is due whenever floor(tick * r / maxRate) increases,
+ * which also handles rates that don't divide the maximum rate.
+ * maxRate is maxRate(), computed once per tick by the caller.
+ */
+
+bool GeneratorConfig::groupDue(size_t group, uint64_t tick, double maxRate) const {
+    double rate = m_groupRates[group];
+    return std::floor(tick * rate / maxRate) != std::floor((tick - 1) * rate / maxRate);
+}
+
+/**
+ * @brief Sample rate of a channel (its own, or its group's; 0 without groups).
+ */
+
+double GeneratorConfig::channelRate(uint16_t channel) const {
+    if (channel < m_channelRates.size()) return m_channelRates[channel];
+    for (size_t group = 0; group < m_groupRates.size(); group++) {
+        if (channel < groupEnd(group)) return m_groupRates[group];
+    }
+    return m_groupRates.empty() ? 0.0 : m_groupRates.back();
+}
+
+/**
+ * @brief Whether a channel has to be sampled in the given tick (see groupDue).
+ */
+
+bool GeneratorConfig::channelDue(uint16_t channel, uint64_t tick, double maxRate) const {
+    double rate = channelRate(channel);
+    return std::floor(tick * rate / maxRate) != std::floor((tick - 1) * rate / maxRate);
+}
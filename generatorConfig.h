@@ -0,0 +1,52 @@
+#ifndef GENERATORCONFIG_H
+#define GENERATORCONFIG_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class GeneratorConfig
+ * 
+ * @brief Configuration of the synthetic load generator.
+ * 
+ * Describes how many channels are generated, the sample rate
+ * of each group of channels (channels are split evenly between
+ * the groups, the last one taking the remainder), for how long,
+ * the ratio of NaN values, the seed and the number of producer
+ * threads. In unpaced mode the generator does not sleep between
+ * ticks and uses simulated timestamps (tick * base period), which
+ * makes runs deterministic for a given seed and as fast as possible.
+ * m_channelRates, when set, gives every channel its own rate instead
+ * (any rate, channels past its end use their group's). Paced mode is
+ * driven by a DeadlineScheduler (absolute deadlines per rate).
+ * The defaults reproduce the original hardcoded generator. A config
+ * is only run if valid(): at least one group, every rate finite and
+ * positive.
+ * 
+ */
+
+class GeneratorConfig {
+
+    public:
+        uint16_t m_numChannels = 101;
+        std::vector<double> m_groupRates = {100.0, 50.0, 25.0, 10.0}; // in hz
+        std::vector<double> m_channelRates; // in hz, per channel (empty -> group rates)
+        double m_duration = 30000.0; // in milliseconds
+        double m_nanProbability = 0.005;
+        uint32_t m_seed = 0; // 0 -> seeded from std::random_device
+        unsigned m_producerThreads = 1;
+        bool m_paced = true;
+
+        GeneratorConfig() = default;
+
+        bool valid() const;
+        double maxRate() const;
+        double basePeriod() const;
+        uint16_t groupStart(size_t group) const;
+        uint16_t groupEnd(size_t group) const;
+        bool groupDue(size_t group, uint64_t tick, double maxRate) const;
+        double channelRate(uint16_t channel) const;
+        bool channelDue(uint16_t channel, uint64_t tick, double maxRate) const;
+};
+
+#endif // GENERATORCONFIG_H
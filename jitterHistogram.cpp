@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "jitterHistogram.h"
+
+void JitterHistogram::record(Timestamp error) {
+    Timestamp magnitude = error < 0 ? -error : error;
+    uint64_t micros = static_cast<uint64_t>(magnitude / kNanosPerMicro);
+    size_t bucket = std::min<size_t>(std::bit_width(micros), kBuckets - 1);
+    m_counts[bucket]++;
+    m_count++;
+    m_sum += static_cast<double>(magnitude);
+    m_max = std::max(m_max, magnitude);
+}
+
+void JitterHistogram::merge(const JitterHistogram& other) {
+    for (size_t b = 0; b < kBuckets; b++) m_counts[b] += other.m_counts[b];
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_max = std::max(m_max, other.m_max);
+}
+
+/**
+ * @brief Mean absolute error in ns (NaN when empty).
+ */
+
+double JitterHistogram::mean() const {
+    return m_count > 0 ? m_sum / m_count : std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ * @brief Upper edge (ns) of the bucket holding the p-th percentile.
+ *
+ * @details Capped by the maximum recorded error; 0 when empty.
+ */
+
+Timestamp JitterHistogram::percentile(double p) const {
+    if (m_count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * m_count));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; b++) {
+        seen += m_counts[b];
+        if (seen >= std::max<uint64_t>(rank, 1)) return std::min(bucketUpper(b), m_max);
+    }
+    return m_max;
+}
+
+Timestamp JitterHistogram::bucketUpper(size_t bucket) {
+    if (bucket + 1 >= kBuckets) return std::numeric_limits<Timestamp>::max();
+    return (Timestamp(1) << bucket) * kNanosPerMicro;
+}
+
+/**
+ * @brief One line per non-empty bucket ("< 64 us: 1234").
+ */
+
+std::string JitterHistogram::toString() const {
+    std::ostringstream out;
+    for (size_t b = 0; b < kBuckets; b++) {
+        if (m_counts[b] == 0) continue;
+        if (b + 1 < kBuckets) out << "    < " << bucketUpper(b) / kNanosPerMicro << " us: " << m_counts[b] << "\n";
+        else out << "    >= " << bucketUpper(b - 1) / kNanosPerMicro << " us: " << m_counts[b] << "\n";
+    }
+    return out.str();
+}
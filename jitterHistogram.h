@@ -0,0 +1,44 @@
+#ifndef JITTERHISTOGRAM_H
+#define JITTERHISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "timestamp.h"
+
+/**
+ * @class JitterHistogram
+ *
+ * @brief Log2 histogram of timing errors, in microseconds.
+ *
+ * Records the absolute error (ns) of a wake-up or of a period against
+ * its nominal value. Bucket 0 counts errors under 1 us, bucket b
+ * errors in [2^(b-1), 2^b) us, the last one everything above. Also
+ * keeps the count, the mean and the maximum. Percentiles are resolved
+ * to the upper edge of their bucket.
+ *
+ */
+
+class JitterHistogram {
+
+    public:
+        static constexpr size_t kBuckets = 24;
+
+        std::array<uint64_t, kBuckets> m_counts{};
+        uint64_t m_count = 0;
+        double m_sum = 0.0;
+        Timestamp m_max = 0;
+
+        JitterHistogram() = default;
+
+        void record(Timestamp error);
+        void merge(const JitterHistogram& other);
+        double mean() const;
+        Timestamp percentile(double p) const;
+        std::string toString() const;
+
+        static Timestamp bucketUpper(size_t bucket);
+};
+
+#endif // JITTERHISTOGRAM_H
@@ -1,83 +1,184 @@
+#include <filesystem>
+#include <iterator>
+#include <sstream>
+
 #include "jsonFunctions.h"
 
+static const std::string kSegmentDirectory = "../storage/segments";
+
+/**
+ * @brief Channel fields and datapoints [first, last) as a JSON object.
+ */
+
+static Json::Value channelToJson(const DataChannel& channel, size_t first, size_t last) {
+    Json::Value dataChannel;
+    dataChannel["id"] = channel.m_id;
+    dataChannel["name"] = channel.m_name;
+    dataChannel["unit"] = channel.m_unit;
+    dataChannel["codec"] = channel.m_values.m_encoding.codecName();
+    dataChannel["scale"] = channel.m_values.m_encoding.m_scale;
+    dataChannel["offset"] = channel.m_values.m_encoding.m_offset;
+
+    Json::Value dataVector(Json::arrayValue);
+    for (size_t i = first; i < last; i++) {
+        DataPoint elem = channel.at(i);
+        Json::Value dataPoint;
+        dataPoint["timestamp_ns"] = Json::Int64(elem.m_timestamp);
+        dataPoint["value"] = elem.m_value;
+        dataVector.append(dataPoint);
+    }
+    dataChannel["data"] = dataVector;
+    return dataChannel;
+}
+
+static std::string segmentLine(const Json::Value& segment) {
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    return Json::writeString(writer, segment);
+}
+
 /**
  * @brief JSON - Persistence storage
  * 
- * @details Saving all data channels into a human readable
- * and easily accessible JSON file.
+ * @details Saving all data channels into human readable
+ * and easily accessible JSON segment files, appending only
+ * the datapoints collected since the last save.
  */
 
-void saveJson(const std::unordered_map<uint16_t, DataChannel>& channels) {
+void saveJson(std::unordered_map<uint16_t, DataChannel>& channels) {
 
-    Json::Value output;
-    
-    for (const auto& pair : channels) {
+    std::filesystem::create_directories(kSegmentDirectory);
+    size_t written = 0;
+    Json::Value ids(Json::arrayValue);
+    for (auto& pair : channels) {
+        written += saveSegment(pair.second);
+        ids.append(pair.first);
+    }
 
-        Json::Value dataChannel;
-        dataChannel["id"] = pair.second.m_id;
-        dataChannel["name"] = pair.second.m_name;
-        dataChannel["unit"] = pair.second.m_unit;
+    std::ofstream outputFile(kSegmentDirectory + "/channels.json");
+    outputFile << segmentLine(ids) << std::endl;
+    outputFile.close();
 
-        Json::Value dataVector(Json::arrayValue);
-        for (const auto& elem : pair.second.m_data) {
-            Json::Value dataPoint;
-            dataPoint["timestamp"] = elem.m_timestamp;
-            dataPoint["value"] = elem.m_value;
-            dataVector.append(dataPoint);
-        }
+    std::cout << "All Channels saved (" << written << " new datapoints)" << std::endl;
 
-        dataChannel["data"] = dataVector; 
-        output[pair.first] = dataChannel;
-    }
+}
 
-    std::ofstream outputFile("../storage/channels.json");
 
-    Json::StreamWriterBuilder writer;
-    Json::StreamWriter *jsonWriter = writer.newStreamWriter();
-    jsonWriter->write(output, &outputFile);
+/**
+ * @brief JSON - Persistence storage
+ * 
+ * @details Saving a specific data channel into a human readable
+ * and easily accessible JSON segment file, appending only the
+ * datapoints collected since the last save.
+ */
 
-    delete jsonWriter;
-    outputFile.close();
+void saveChannel(DataChannel& channel) {
 
-    std::cout << "All Channels saved" << std::endl;
+    size_t written = saveSegment(channel);
+    std::cout << "Channel Saved (" << written << " new datapoints)" << std::endl;
 
 }
 
+std::string segmentPath(uint16_t channelId) {
+    return kSegmentDirectory + "/channel_" + std::to_string(channelId) + ".jsonl";
+}
 
 /**
  * @brief JSON - Persistence storage
  * 
- * @details Saving a specific data channel into a human readable
- * and easily accessible JSON file.
+ * @details Appends the datapoints after the channel's persisted
+ * watermark to its segment file as one segment, and moves the
+ * watermark. Late datapoints are merged first; when that (or a
+ * new encoding) changed persisted datapoints, the watermark was
+ * moved back and the segment starts there. A segment starting at
+ * 0 replaces the file. Returns the number of datapoints written.
  */
 
-void saveChannel(const DataChannel& channel) {
+size_t saveSegment(DataChannel& channel) {
+    channel.mergeLate();
+    size_t first = std::min(channel.m_persisted, channel.size());
+    if (first == channel.size() && first > 0) return 0;
+
+    std::filesystem::create_directories(kSegmentDirectory);
+    Json::Value segment = channelToJson(channel, first, channel.size());
+    segment["from"] = Json::UInt64(first);
+    if (!segmentCompactor().write(segmentPath(channel.m_id), segmentLine(segment), first == 0)) {
+        std::cerr << "Error writing segment file: " << segmentPath(channel.m_id) << std::endl;
+        return 0;
+    }
+    channel.m_persisted = channel.size();
+    return channel.size() - first;
+}
 
-    Json::Value dataChannel;
+/**
+ * @brief Appends JSON datapoints to a channel.
+ */
 
-    dataChannel["id"] = channel.m_id;
-    dataChannel["name"] = channel.m_name;
-    dataChannel["unit"] = channel.m_unit;
+static void appendJsonData(DataChannel& channel, const Json::Value& data) {
+    channel.reserve(channel.size() + data.size());
+    for (const Json::Value& elem : data) {
+        DataPoint dp;
+        // Files saved before integer timestamps have "timestamp" in milliseconds
+        if (elem.isMember("timestamp_ns")) dp.m_timestamp = elem["timestamp_ns"].asInt64();
+        else dp.m_timestamp = fromMilliseconds(elem["timestamp"].asDouble());
+        if (elem["value"].isNull()) dp.m_value = std::numeric_limits<double>::quiet_NaN();
+        else dp.m_value = elem["value"].asDouble();
+        channel.append(dp);
+    }
+}
 
-    Json::Value dataVector(Json::arrayValue);
-    for (const auto& elem : channel.m_data) {
-        Json::Value dataPoint;
-        dataPoint["timestamp"] = elem.m_timestamp;
-        dataPoint["value"] = elem.m_value;
-        dataVector.append(dataPoint);
+/**
+ * @brief Rebuilds a channel from its segments (one per line).
+ * 
+ * @details A segment starting at 0 replaces the channel (header
+ * included), any other one truncates it to its start first.
+ * Returns false if a segment can't be parsed or there is none.
+ */
+
+static bool applySegments(std::istream& input, DataChannel& channel) {
+    Json::CharReaderBuilder readerBuilder;
+    bool loaded = false;
+    for (std::string line; std::getline(input, line); ) {
+        if (line.empty()) continue;
+        Json::Value segment;
+        std::string errs;
+        std::istringstream lineStream(line);
+        if (!Json::parseFromStream(readerBuilder, lineStream, &segment, &errs)) return false;
+        size_t from = segment.get("from", 0).asUInt64();
+        if (!loaded || from == 0) {
+            loadChannel(channel, segment);
+        } else {
+            channel.truncate(from);
+            appendJsonData(channel, segment["data"]);
+        }
+        loaded = true;
     }
-    dataChannel["data"] = dataVector;
-    
-    std::ofstream outputFile("../storage/channel_" + std::to_string(channel.m_id) + ".json");
-    Json::StreamWriterBuilder writer;
-    Json::StreamWriter *jsonWriter = writer.newStreamWriter();
-    jsonWriter->write(dataChannel, &outputFile);
+    return loaded;
+}
 
-    delete jsonWriter;
-    outputFile.close();
+/**
+ * @brief Segment file content rewritten as a single segment.
+ * 
+ * @details Used by the background compaction. Returns an empty
+ * string if the content can't be parsed.
+ */
 
-    std::cout << "Channel Saved" << std::endl;
+std::string compactSegments(const std::string& content) {
+    std::istringstream input(content);
+    DataChannel channel;
+    if (!applySegments(input, channel)) return "";
+    Json::Value segment = channelToJson(channel, 0, channel.size());
+    segment["from"] = Json::UInt64(0);
+    return segmentLine(segment);
+}
+
+/**
+ * @brief Background compactor of the segment files.
+ */
 
+SegmentCompactor& segmentCompactor() {
+    static SegmentCompactor compactor(compactSegments);
+    return compactor;
 }
 
 /**
@@ -88,22 +189,18 @@ void saveChannel(const DataChannel& channel) {
  */
 
 void loadChannel(DataChannel& channelLoaded, const Json::Value& obj) {
-    DataChannel dc;
-    dc.m_id = (uint16_t) obj["id"].asInt();
-    dc.m_name = obj["name"].asString();
-    dc.m_unit = obj["unit"].asString();
-
-    std::vector<DataPoint> dpVec;
-    const Json::Value& data = obj["data"];
-    for (const Json::Value& elem : data) {
-        DataPoint dp;
-        dp.m_timestamp = elem["timestamp"].asDouble();
-        if (elem["value"].isNull()) dp.m_value = std::numeric_limits<double>::quiet_NaN();
-        else dp.m_value = elem["value"].asDouble();
-        dpVec.push_back(std::move(dp));
+    DataChannel dc((uint16_t) obj["id"].asInt(), obj["name"].asString(), obj["unit"].asString());
+
+    // Files saved before codecs existed have no "codec" and keep the unit's encoding
+    if (obj.isMember("codec")) {
+        dc.setEncoding(ValueEncoding(
+            ValueEncoding::codecFromName(obj["codec"].asString()),
+            obj["scale"].asDouble(),
+            obj["offset"].asDouble()));
     }
 
-    dc.m_data = std::move(dpVec);
+    appendJsonData(dc, obj["data"]);
+
     channelLoaded = std::move(dc);
 
     return;
@@ -112,11 +209,58 @@ void loadChannel(DataChannel& channelLoaded, const Json::Value& obj) {
 /**
  * @brief JSON - Persistence storage
  * 
- * @details Load all channels into a single JSON file.
+ * @details Loads a channel from its segment file. The loaded
+ * datapoints are already persisted, so the channel's watermark
+ * is set to its size and the next save only appends.
+ */
+
+bool loadSegments(DataChannel& channelLoaded, const std::string& path) {
+    std::string content;
+    {
+        // Only the read holds the file lock: saves are not blocked by the parsing
+        std::lock_guard<std::mutex> lock(segmentCompactor().m_fileMtx);
+        std::ifstream inputFile(path, std::ios::binary);
+        if (!inputFile.is_open()) return false;
+        content.assign(std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>());
+    }
+
+    std::istringstream input(content);
+    DataChannel dc;
+    if (!applySegments(input, dc)) {
+        std::cerr << "Error parsing segment file: " << path << std::endl;
+        return false;
+    }
+    dc.m_persisted = dc.size();
+    channelLoaded = std::move(dc);
+    return true;
+}
+
+/**
+ * @brief JSON - Persistence storage
+ * 
+ * @details Load all channels saved by saveJson (from their segment
+ * files, or from the single JSON file saved before segments).
  */
 
 void loadJson(std::unordered_map<uint16_t, DataChannel>& channelsLoaded) {
 
+    // Channels listed by the last saveJson, each one from its segment file
+    std::ifstream indexFile(kSegmentDirectory + "/channels.json");
+    if (indexFile.is_open()) {
+        Json::CharReaderBuilder readerBuilder;
+        Json::Value ids;
+        std::string errs;
+        if (!Json::parseFromStream(readerBuilder, indexFile, &ids, &errs)) {
+            std::cerr << "Error parsing JSON: " << errs << std::endl;
+            return;
+        }
+        for (const Json::Value& id : ids) {
+            uint16_t channelId = static_cast<uint16_t>(id.asUInt());
+            loadSegments(channelsLoaded[channelId], segmentPath(channelId));
+        }
+        return;
+    }
+
     std::string filename = "../storage/channels.json";
     std::ifstream inputFile(filename);
 
@@ -146,14 +290,20 @@ void loadJson(std::unordered_map<uint16_t, DataChannel>& channelsLoaded) {
  * @brief JSON - Persistence storage
  * 
  * @details Loading a specific data channel from a 
- * JSON file. First checks if the channel has been saved
- * separately, in order to extract it from there. If not,
+ * JSON file. First checks if the channel has a segment file,
+ * then if it has been saved separately (before segments),
+ * in order to extract it from there. If not,
  * it searches for it in channels.json and extracts it
  * from there.
  */
 
 void loadJsonChannel(DataChannel& channelLoaded, uint16_t targetId) {
 
+    if (loadSegments(channelLoaded, segmentPath(targetId))) {
+        std::cout << "Found segment file" << std::endl;
+        return;
+    }
+
     std::string filename = "../storage/channel_" + std::to_string(targetId) + ".json";
     std::ifstream inputFile(filename);
 
@@ -3,6 +3,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <string>
+#include <unordered_map>
 
 #include <json/json.h>
 
@@ -10,6 +12,7 @@
 #include "dataInput.h"
 #include "dataPoint.h"
 #include "extractedSubChannel.h"
+#include "segmentCompactor.h"
 #include "timer.h"
 
 /**
@@ -20,11 +23,29 @@
  * file respectively. They will also help us save one or
  * all channels to a general or specific JSON file, 
  * respectively.
+ * 
+ * Saves are incremental: every channel has a segment file
+ * (../storage/segments/channel_<id>.jsonl) holding one JSON segment
+ * per line (the channel's header, the index of its first datapoint
+ * "from" and its datapoints), and a save only appends the datapoints
+ * after the channel's persisted watermark (DataChannel::m_persisted),
+ * so its cost is proportional to the new data. Loading truncates the
+ * channel to each segment's "from" before appending its datapoints.
+ * Files with too many segments are compacted into one in the
+ * background (segmentCompactor()). saveJson also lists the saved ids
+ * in ../storage/segments/channels.json, which loadJson reads. Files
+ * saved before segments existed (channels.json, channel_<id>.json)
+ * are still loaded when there is no segment file.
  */
 
-void saveJson(const std::unordered_map<uint16_t, DataChannel>& channels);
-void saveChannel(const DataChannel& channel);
+void saveJson(std::unordered_map<uint16_t, DataChannel>& channels);
+void saveChannel(DataChannel& channel);
+size_t saveSegment(DataChannel& channel);
+std::string segmentPath(uint16_t channelId);
+std::string compactSegments(const std::string& content);
+SegmentCompactor& segmentCompactor();
 void loadChannel(DataChannel& channelLoaded, const Json::Value& obj);
+bool loadSegments(DataChannel& channelLoaded, const std::string& path);
 void loadJson(std::unordered_map<uint16_t, DataChannel>& channelsLoaded);
 void loadJsonChannel(DataChannel& channelLoaded, uint16_t targetId);
 
@@ -0,0 +1,66 @@
+#include <bit>
+#include <limits>
+
+#include "latestValueTable.h"
+
+LatestValueTable::LatestValueTable(size_t capacity)
+    : m_capacity(capacity), m_slots(std::make_unique<Slot[]>(capacity)) {}
+
+/**
+ * @brief Publish a datapoint as the channel's latest one.
+ * 
+ * @return true if the slot was updated
+ * @return false if the id is out of the table or the datapoint is older
+ */
+
+bool LatestValueTable::update(uint16_t channelId, const DataPoint& dp) {
+    if (channelId >= m_capacity) return false;
+    Slot& slot = m_slots[channelId];
+    uint64_t sequence = slot.m_sequence.load(std::memory_order_relaxed);
+    if (sequence != 0 && dp.m_timestamp < slot.m_timestamp.load(std::memory_order_relaxed)) return false;
+
+    slot.m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.m_timestamp.store(dp.m_timestamp, std::memory_order_relaxed);
+    slot.m_valueBits.store(std::bit_cast<uint64_t>(dp.m_value), std::memory_order_relaxed);
+    slot.m_sequence.store(sequence + 2, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Latest datapoint of a channel (nullopt if it has none).
+ */
+
+std::optional<DataPoint> LatestValueTable::latest(uint16_t channelId) const {
+    if (channelId >= m_capacity) return std::nullopt;
+    const Slot& slot = m_slots[channelId];
+    while (true) {
+        uint64_t before = slot.m_sequence.load(std::memory_order_acquire);
+        if (before == 0) return std::nullopt;
+        if (before % 2 != 0) continue;
+        Timestamp timestamp = slot.m_timestamp.load(std::memory_order_relaxed);
+        uint64_t valueBits = slot.m_valueBits.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.m_sequence.load(std::memory_order_relaxed) == before) {
+            return DataPoint(timestamp, std::bit_cast<double>(valueBits));
+        }
+    }
+}
+
+/**
+ * @brief Latest datapoints of several channels (dashboard read).
+ * 
+ * @param channelIds 
+ * @param out one datapoint per id (NaN value, timestamp 0 when the channel has none)
+ * @return size_t number of channels with a datapoint
+ */
+
+size_t LatestValueTable::latest(std::span<const uint16_t> channelIds, std::span<DataPoint> out) const {
+    size_t found = 0;
+    for (size_t i = 0; i < channelIds.size() && i < out.size(); i++) {
+        std::optional<DataPoint> dp = latest(channelIds[i]);
+        out[i] = dp.value_or(DataPoint(0, std::numeric_limits<double>::quiet_NaN()));
+        found += dp.has_value();
+    }
+    return found;
+}
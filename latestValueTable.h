@@ -0,0 +1,53 @@
+#ifndef LATESTVALUETABLE_H
+#define LATESTVALUETABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+#include "dataPoint.h"
+#include "timestamp.h"
+
+/**
+ * @class LatestValueTable
+ * 
+ * @brief Lock-free table of the latest datapoint of every channel.
+ * 
+ * One slot per channel id (below the capacity), on its own cache line,
+ * updated by the collector after it stores datapoints and read by any
+ * number of threads without locking the channels. Every slot is a
+ * seqlock: the writer makes the sequence odd, stores the timestamp and
+ * the value, and makes it even again; a reader retries while the
+ * sequence is odd or changed during its read, so it never sees a
+ * timestamp and a value from different updates. Readers never block
+ * the writer. Updates older than the slot's datapoint are ignored, so
+ * late datapoints don't replace the latest one. A slot has a single
+ * writer at a time (the collectors update it while holding the lock of
+ * the channel map, or own the channel).
+ * 
+ */
+
+class LatestValueTable {
+
+    public:
+        static constexpr size_t kDefaultCapacity = 1024;
+
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> m_sequence{0};
+            std::atomic<Timestamp> m_timestamp{0};
+            std::atomic<uint64_t> m_valueBits{0};
+        };
+
+        size_t m_capacity;
+        std::unique_ptr<Slot[]> m_slots;
+
+        explicit LatestValueTable(size_t capacity = kDefaultCapacity);
+
+        bool update(uint16_t channelId, const DataPoint& dp);
+        std::optional<DataPoint> latest(uint16_t channelId) const;
+        size_t latest(std::span<const uint16_t> channelIds, std::span<DataPoint> out) const;
+};
+
+#endif // LATESTVALUETABLE_H
@@ -1,7 +1,10 @@
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <mutex>
 #include <numeric>
 #include <queue>
@@ -11,13 +14,29 @@
 #include <thread>
 #include <vector>
 
+#include "arrowFunctions.h"
+#include "asyncPipeline.h"
+#include "channelLog.h"
+#include "channelQuery.h"
 #include "dataChannel.h"
 #include "dataCollector.h"
 #include "dataInput.h"
 #include "dataPoint.h"
+#include "dataQueue.h"
+#include "deadlineScheduler.h"
 #include "extractedSubChannel.h"
+#include "fixedRateChannel.h"
+#include "generatorConfig.h"
 #include "jsonFunctions.h"
+#include "latestValueTable.h"
+#include "partitionRouter.h"
+#include "pipeline.h"
+#include "pipelineConfig.h"
+#include "queryCache.h"
+#include "recoveredStore.h"
 #include "timer.h"
+#include "timestamp.h"
+#include "timestampColumn.h"
 
 /**
  * @brief Macro definition. Use of a 
@@ -49,22 +68,36 @@ int main() {
     std::cout << std::endl;
 
     std::unordered_map<uint16_t, DataChannel> channels;
-    std::queue<DataInput> dataQueue;
-
-    std::thread genThread(dataGenerator, std::ref(dataQueue));
+    // Bounded ingest buffer: under overload the generator waits for
+    // the collectors instead of growing the queue without limit.
+    DataQueue dataQueue(1 << 20, OverloadPolicy::Block);
+
+    // Everything the collector stores is logged, with a checkpoint (binary
+    // snapshot + log rotation) every megabyte of log, for the fast restart.
+    const std::string durableDirectory = "../storage/durable";
+    std::filesystem::remove_all(durableDirectory);
+    ChannelLog durableLog;
+    durableLog.m_checkpointBytes = 1 << 20;
+    durableLog.open(durableDirectory);
+
+    // Default configuration: 101 channels at 100/50/25/10 hz for 30 seconds.
+    // Set m_paced = false (and m_producerThreads) to stress the collector.
+    GeneratorConfig generatorConfig;
+    std::thread genThread(dataGenerator, std::ref(dataQueue), std::cref(generatorConfig));
 
     bool threadPool = false;
+    bool batchedCollection = true;
 
     if (threadPool) {
 
         std::this_thread::sleep_for(std::chrono::seconds(1));
-        const int numColThreads = std::thread::hardware_concurrency() - 2;
+        const int numColThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 2);
         std::cout << std::endl;
         std::cout << "Number of threads to participate in the thread pool: " << numColThreads << std::endl;
         std::cout << std::endl;
         std::vector<std::thread> colThreads;
         for (int i = 0; i < numColThreads; i++) {
-            colThreads.emplace_back(dataCollector, std::ref(dataQueue), std::ref(channels));
+            colThreads.emplace_back(dataCollector, std::ref(dataQueue), std::ref(channels), nullptr);
         }
         genThread.join();
         for (auto& thread : colThreads) thread.join();
@@ -75,14 +108,15 @@ int main() {
         else std::cout << "The datapoints from the channels are not ordered! (Due to thread pool race conditions)" << std::endl;
 
         {
-            Timer timer("sorting channels");
+            Timer timer("merging late datapoints");
+            uint64_t late = 0;
+            uint64_t tooLate = 0;
             for (auto& channel : channels) {
-                std::sort(
-                    channel.second.m_data.begin(),
-                    channel.second.m_data.end(),
-                    compareByTimestamp
-                );
+                channel.second.mergeLate();
+                late += channel.second.m_lateCount;
+                tooLate += channel.second.m_tooLateCount;
             }
+            std::cout << "Late datapoints: " << late << ", too late (dropped): " << tooLate << std::endl;
         }
 
         ordered = checkOrder(channels);
@@ -95,9 +129,13 @@ int main() {
         std::cout << std::endl;
         std::cout << "No thread pool, just 1 thread for data collection." << std::endl;
         std::cout << std::endl;
-        std::thread colThread(dataCollector, std::ref(dataQueue), std::ref(channels));
+        std::thread colThread;
+        if (batchedCollection) colThread = std::thread(dataCollectorBatched, std::ref(dataQueue), std::ref(channels), 0, nullptr, &durableLog, nullptr);
+        else colThread = std::thread(dataCollector, std::ref(dataQueue), std::ref(channels), nullptr);
         genThread.join();
         colThread.join();
+        durableLog.sync();
+        durableLog.waitCompaction();
 
         bool ordered = checkOrder(channels);
         std::cout << std::endl;
@@ -107,6 +145,8 @@ int main() {
 
     std::cout << std::endl;
     std::cout << "The data queue has " << dataQueue.size() << " elements after both functions are done!" << std::endl;
+    std::cout << "Queue high watermark: " << dataQueue.m_highWater << ", blocked: " << dataQueue.m_blocked;
+    std::cout << ", dropped: " << dataQueue.m_dropped << ", decimated: " << dataQueue.m_decimated << std::endl;
     std::cout << std::endl; 
 
     // Print length of some channels
@@ -117,7 +157,9 @@ int main() {
         std::cout << "Channel " << id << ": " << std::endl;
         std::cout << "Name: " << channels[id].m_name << std::endl;
         std::cout << "Unit: " << channels[id].m_unit << std::endl;
-        std::cout << "Datapoint vector size: " << channels[id].m_data.size() << std::endl;
+        std::cout << "Datapoint vector size: " << channels[id].size() << std::endl;
+        std::cout << "Timestamp column: " << channels[id].m_timestamps.memoryBytes() << " bytes (";
+        std::cout << channels[id].m_timestamps.m_bases.size() << " chunks)" << std::endl;
         std::cout << std::endl;
     }
 
@@ -132,9 +174,9 @@ int main() {
     }
     std::cout << *(std::prev(channelIds.end())) << "}" << std::endl << std::endl;
 
-    double lowerTs = 10000;
-    double upperTs = 20000;
-    std::cout << "Extract datapoints between " << lowerTs << " ms and " << upperTs << " ms." << std::endl;
+    Timestamp lowerTs = fromMilliseconds(10000);
+    Timestamp upperTs = fromMilliseconds(20000);
+    std::cout << "Extract datapoints between " << toMilliseconds(lowerTs) << " ms and " << toMilliseconds(upperTs) << " ms." << std::endl;
     std::cout << std::endl;
 
     std::unordered_map<uint16_t, ExtractedSubChannel> subsetChannels = retrieveChannelSubsets(channels, channelIds, lowerTs, upperTs);
@@ -151,16 +193,240 @@ int main() {
             subsetChannels[id].m_values.end(),
             0.0
         ) / subsetChannels[id].m_values.size() << std::endl;
-        std::cout << "Number of omitted datapoints (NaN values): " << subsetChannels[id].m_nan_dps.size() << "  ";
-        for (auto& dp : subsetChannels[id].m_nan_dps) std::cout << "(" << dp.m_timestamp << ", " << dp.m_value << "), ";
+        std::cout << "Number of omitted datapoints (NaN values): " << subsetChannels[id].m_nanCount << "  ";
+        for (auto& dp : subsetChannels[id].nanDatapoints(channels[id])) std::cout << "(" << toMilliseconds(dp.m_timestamp) << ", " << dp.m_value << "), ";
+        std::cout << std::endl << std::endl;
+    }
+
+    // Same query into an arena: the buffer is reused, no heap allocation per query
+    {
+        std::vector<std::byte> arenaBuffer(4 * 1024 * 1024);
+        std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+        const int repeats = 200;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++) {
+            arena.release();
+            SubChannelMap arenaSubsets(&arena);
+            retrieveChannelSubsets(channels, channelIds, lowerTs, upperTs, arenaSubsets);
+        }
+        double arenaMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Arena-backed subset retrieval: " << arenaMs / repeats << " ms per query (" << repeats << " queries)" << std::endl;
+        std::cout << std::endl;
+    }
+
+    std::cout << "----------------------- VALUE PREDICATE QUERY -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    double threshold = 0.99;
+    std::cout << "Times when the value exceeded " << threshold << " between " << toMilliseconds(lowerTs) << " ms and " << toMilliseconds(upperTs) << " ms." << std::endl;
+    std::cout << std::endl;
+
+    std::unordered_map<uint16_t, ExtractedSubChannel> matchChannels = retrieveChannelMatches(
+        channels, channelIds, lowerTs, upperTs, Comparison::Greater, threshold);
+
+    std::cout << std::endl;
+    for (uint16_t id : channelIds) {
+        std::cout << "Channel " << id << ": " << matchChannels[id].m_timestamps.size() << " matches";
+        if (!matchChannels[id].m_timestamps.empty()) {
+            std::cout << " (first at " << toMilliseconds(matchChannels[id].m_timestamps.front()) << " ms)";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "----------------------- PERCENTILES -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // All channels over the whole run: sketches of the sealed blocks vs extracting and sorting
+    std::vector<uint16_t> allChannelIds;
+    for (const auto& channel : channels) allChannelIds.push_back(channel.first);
+    Timestamp lastTs = fromMilliseconds(generatorConfig.m_duration);
+
+    double sketchMs;
+    std::unordered_map<uint16_t, PercentileSummary> percentiles;
+    {
+        Timer timer("sketch percentiles");
+        percentiles = retrieveChannelPercentiles(channels, allChannelIds, 0, lastTs);
+        for (auto& summary : percentiles) {
+            summary.second.percentile(50.0);
+            summary.second.percentile(95.0);
+            summary.second.percentile(99.0);
+        }
+        sketchMs = timer.elapsed();
+    }
+
+    double sortMs;
+    std::unordered_map<uint16_t, std::vector<double>> exactPercentiles;
+    {
+        Timer timer("exact percentiles (extract + sort)");
+        auto subsets = retrieveChannelSubsets(channels, allChannelIds, 0, lastTs);
+        for (auto& subset : subsets) {
+            std::pmr::vector<double>& values = subset.second.m_values;
+            std::sort(values.begin(), values.end());
+            for (double p : {50.0, 95.0, 99.0}) {
+                size_t rank = static_cast<size_t>(std::max(1.0, std::ceil(p / 100.0 * values.size())));
+                exactPercentiles[subset.first].push_back(values.empty() ? 0.0 : values[rank - 1]);
+            }
+        }
+        sortMs = timer.elapsed();
+    }
+
+    std::cout << std::endl;
+    for (uint16_t id : channelIds) {
+        PercentileSummary& summary = percentiles[id];
+        std::cout << "Channel " << id << ": p50 " << summary.percentile(50.0) << " (exact " << exactPercentiles[id][0] << ")";
+        std::cout << ", p95 " << summary.percentile(95.0) << " (exact " << exactPercentiles[id][1] << ")";
+        std::cout << ", p99 " << summary.percentile(99.0) << " (exact " << exactPercentiles[id][2] << ")";
+        std::cout << ", rank error <= " << summary.relativeError() * 100 << "%" << std::endl;
+    }
+    std::cout << "Speedup vs exact sort: " << (sketchMs > 0 ? sortMs / sketchMs : 0.0) << "x" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "----------------------- DERIVED CHANNELS -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    std::vector<ChannelExpr> expressions = {
+        ChannelExpr::channel(3) - ChannelExpr::channel(16),
+        ChannelExpr::movingAverage(ChannelExpr::channel(45), fromMilliseconds(500)),
+        ChannelExpr::channel(60) * ChannelExpr::constant(2.5)
+    };
+    for (const ChannelExpr& expr : expressions) {
+        ExtractedSubChannel derived = retrieveDerivedChannel(channels, expr, lowerTs, upperTs);
+        std::cout << derived.m_name << ": " << derived.m_values.size() << " values, " << derived.m_nanCount << " NaN";
+        if (!derived.m_values.empty()) {
+            std::cout << ", average " << std::accumulate(derived.m_values.begin(), derived.m_values.end(), 0.0) / derived.m_values.size();
+        }
         std::cout << std::endl << std::endl;
     }
 
+    std::cout << "----------------------- VALUE CODECS -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // The generated values are in [0, 1]: float and scaled 16 bit integers are enough
+    std::vector<std::pair<uint16_t, ValueEncoding>> encodings = {
+        {60, ValueEncoding(ValueCodec::Float)},
+        {79, ValueEncoding::scaled16(0.0, 1.0)}
+    };
+    for (const auto& [id, encoding] : encodings) {
+        size_t bytesBefore = channels[id].m_values.memoryBytes();
+        channels[id].setEncoding(encoding);
+        std::cout << "Channel " << id << " re-encoded as " << encoding.codecName() << ": values ";
+        std::cout << bytesBefore << " -> " << channels[id].m_values.memoryBytes() << " bytes" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::unordered_map<uint16_t, ValueAggregate> aggregates = retrieveChannelAggregates(channels, channelIds, lowerTs, upperTs);
+
+    std::cout << std::endl;
+    for (uint16_t id : channelIds) {
+        std::cout << "Channel " << id << " (" << channels[id].m_values.m_encoding.codecName() << "): ";
+        std::cout << "count " << aggregates[id].m_count << ", mean " << aggregates[id].mean();
+        std::cout << ", min " << aggregates[id].m_min << ", max " << aggregates[id].m_max << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "----------------------- FIXED-RATE CHANNELS -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // 10 minutes of a 100 Hz channel (simulated timestamps), one sample in 1000 missed
+    {
+        GeneratorConfig fixedConfig;
+        fixedConfig.m_numChannels = 4;
+        fixedConfig.m_duration = 600000.0;
+        fixedConfig.m_paced = false;
+        fixedConfig.m_seed = 42;
+
+        FixedRate100Hz fixedChannel(0, "Sensor_0", "Unit_0");
+        DataChannel irregularChannel(0, "Sensor_0", "Unit_0");
+        uint64_t sample = 0;
+        generatorProducer(fixedConfig, 0, 1, fixedConfig.m_seed, [&](std::vector<DataInput>& batch) {
+            for (DataInput& input : batch) {
+                if (sample++ % 1000 == 999) continue;
+                fixedChannel.insert(input.m_dp);
+                irregularChannel.insert(input.m_dp);
+            }
+        });
+        std::cout << "Samples: " << fixedChannel.size() << " slots, " << fixedChannel.gapCount() << " gaps" << std::endl;
+        std::cout << "Memory: fixed-rate " << fixedChannel.memoryBytes() << " bytes, irregular ";
+        std::cout << irregularChannel.memoryBytes() << " bytes" << std::endl;
+
+        std::unordered_map<uint16_t, FixedRate100Hz> fixedChannels;
+        fixedChannels.emplace(0, std::move(fixedChannel));
+        std::unordered_map<uint16_t, DataChannel> irregularChannels;
+        irregularChannels.emplace(0, std::move(irregularChannel));
+
+        // Many short range queries: O(1) bounds against binary searches
+        const int queries = 20000;
+        std::mt19937 queryGen(7);
+        std::uniform_int_distribution<Timestamp> startDist(0, fromMilliseconds(fixedConfig.m_duration));
+        auto timeQueries = [&](auto& queryChannels) {
+            size_t found = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < queries; i++) {
+                Timestamp lower = startDist(queryGen);
+                auto& channel = queryChannels.at(0);
+                found += channel.upperBound(lower + fromMilliseconds(100)) - channel.lowerBound(lower);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return std::make_pair(ms, found);
+        };
+        auto [fixedMs, fixedFound] = timeQueries(fixedChannels);
+        auto [irregularMs, irregularFound] = timeQueries(irregularChannels);
+        std::cout << "Range lookups (" << queries << "): fixed-rate " << fixedMs << " ms (" << fixedFound << " slots), irregular ";
+        std::cout << irregularMs << " ms (" << irregularFound << " datapoints)" << std::endl;
+
+        // Both layouts behind the same query
+        auto fixedSubset = retrieveChannelSubsets(fixedChannels, {0}, fromMilliseconds(1000), fromMilliseconds(20000));
+        std::cout << "Subset of the fixed-rate channel: " << fixedSubset[0].m_values.size() << " values, ";
+        std::cout << fixedSubset[0].m_nanCount << " NaN / gaps omitted" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "----------------------- RANGE LOOKUP LATENCY -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // Interpolation search of the timestamp column against a binary search of plain timestamps
+    for (size_t length : {size_t(1) << 10, size_t(1) << 14, size_t(1) << 18, size_t(1) << 22}) {
+        std::mt19937 lookupGen(11);
+        std::uniform_int_distribution<Timestamp> jitter(-kNanosPerMilli, kNanosPerMilli);
+        TimestampColumn column;
+        std::vector<Timestamp> plain;
+        column.reserve(length);
+        plain.reserve(length);
+        for (size_t i = 0; i < length; i++) {
+            Timestamp timestamp = static_cast<Timestamp>(i) * 10 * kNanosPerMilli + jitter(lookupGen);
+            column.push_back(timestamp);
+            plain.push_back(timestamp);
+        }
+
+        const int lookups = 200000;
+        std::vector<Timestamp> probes(lookups);
+        std::uniform_int_distribution<Timestamp> probeDist(plain.front(), plain.back());
+        for (Timestamp& probe : probes) probe = probeDist(lookupGen);
+
+        size_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (Timestamp probe : probes) checksum += column.lowerBound(probe);
+        double interpolationNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+        start = std::chrono::steady_clock::now();
+        for (Timestamp probe : probes) checksum -= std::lower_bound(plain.begin(), plain.end(), probe) - plain.begin();
+        double binaryNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+
+        std::cout << "Length " << length << ": interpolation " << interpolationNs << " ns, binary search ";
+        std::cout << binaryNs << " ns per lookup" << (checksum == 0 ? "" : " (mismatch)") << std::endl;
+    }
+    std::cout << std::endl;
+
     std::cout << "----------------------- SAVING TO PERSISTENT STORAGE -------------------------" << std::endl;
     std::cout << std::endl;
 
     std::cout << "Saving all channels..." << std::endl;
-    saveJson(channels);
+    double fullSaveMs;
+    {
+        Timer timer("full save");
+        saveJson(channels);
+        fullSaveMs = timer.elapsed();
+    }
     std::cout << std::endl;
 
     uint16_t channelToSave = 32;
@@ -168,6 +434,18 @@ int main() {
     saveChannel(channels[channelToSave]);
     std::cout << std::endl;
 
+    std::cout << "Saving all channels as Arrow files..." << std::endl;
+    saveArrow(channels);
+    std::cout << std::endl;
+
+    std::cout << "Saving channel " << channelToSave << " subset as an Arrow file" << std::endl;
+    auto subsetToSave = retrieveChannelSubsets(channels, {channelToSave}, lowerTs, upperTs);
+    std::string subsetPath = "../storage/channel_" + std::to_string(channelToSave) + "_subset.arrow";
+    if (saveSubChannelArrow(subsetToSave[channelToSave], channels[channelToSave], subsetPath)) {
+        std::cout << "Subset saved to " << subsetPath << std::endl;
+    }
+    std::cout << std::endl;
+
     std::unordered_map<uint16_t, DataChannel> channelsLoaded;
 
     DataChannel channelLoaded;
@@ -180,7 +458,7 @@ int main() {
     std::cout << std::endl;
 
     DataChannel channelLoaded2;
-    std::cout << "Loading channel " << channelToSave << " (not in a specific file)" << std::endl;
+    std::cout << "Loading channel 65 (saved with all channels)" << std::endl;
     loadJsonChannel(channelLoaded2, 65);
     std::cout << std::endl;
 
@@ -188,36 +466,304 @@ int main() {
     std::cout << "ID: " << channelsLoaded[32].m_id << ", ";
     std::cout << "Name: " << channelsLoaded[32].m_name << ", ";
     std::cout << "Unit: " << channelsLoaded[32].m_unit << ", ";
-    std::cout << "Datapoints vector size: " << channelsLoaded[32].m_data.size() << ", ";
-    std::cout << "First datapoint: (" << channelsLoaded[32].m_data[0].m_timestamp << ", ";
-    std::cout << channelsLoaded[32].m_data[0].m_value << ")" << std::endl;
+    std::cout << "Datapoints vector size: " << channelsLoaded[32].size() << ", ";
+    std::cout << "First datapoint: (" << toMilliseconds(channelsLoaded[32].at(0).m_timestamp) << ", ";
+    std::cout << channelsLoaded[32].at(0).m_value << ")" << std::endl;
     std::cout << std::endl;
 
     std::cout << "Printing channel 32 (loaded from file)" << std::endl;
     std::cout << "ID: " << channelLoaded.m_id << ", ";
     std::cout << "Name: " << channelLoaded.m_name << ", ";
     std::cout << "Unit: " << channelLoaded.m_unit << ", ";
-    std::cout << "Datapoints vector size: " << channelLoaded.m_data.size() << ", ";
-    std::cout << "First datapoint: (" << channelLoaded.m_data[0].m_timestamp << ", ";
-    std::cout << channelLoaded.m_data[0].m_value << ")" << std::endl;
+    std::cout << "Datapoints vector size: " << channelLoaded.size() << ", ";
+    std::cout << "First datapoint: (" << toMilliseconds(channelLoaded.at(0).m_timestamp) << ", ";
+    std::cout << channelLoaded.at(0).m_value << ")" << std::endl;
     std::cout << std::endl;
 
     std::cout << "Printing channel 65 (loaded with all channels)" << std::endl;
     std::cout << "ID: " << channelsLoaded[65].m_id << ", ";
     std::cout << "Name: " << channelsLoaded[65].m_name << ", ";
     std::cout << "Unit: " << channelsLoaded[65].m_unit << ", ";
-    std::cout << "Datapoints vector size: " << channelsLoaded[65].m_data.size() << ", ";
-    std::cout << "First datapoint: (" << channelsLoaded[65].m_data[0].m_timestamp << ", ";
-    std::cout << channelsLoaded[65].m_data[0].m_value << ")" << std::endl;
+    std::cout << "Datapoints vector size: " << channelsLoaded[65].size() << ", ";
+    std::cout << "First datapoint: (" << toMilliseconds(channelsLoaded[65].at(0).m_timestamp) << ", ";
+    std::cout << channelsLoaded[65].at(0).m_value << ")" << std::endl;
     std::cout << std::endl;
 
     std::cout << "Printing channel 65 (not in a specific file, hence extracted from all channels)" << std::endl;
     std::cout << "ID: " << channelLoaded2.m_id << ", ";
     std::cout << "Name: " << channelLoaded2.m_name << ", ";
     std::cout << "Unit: " << channelLoaded2.m_unit << ", ";
-    std::cout << "Datapoints vector size: " << channelLoaded2.m_data.size() << ", ";
-    std::cout << "First datapoint: (" << channelLoaded2.m_data[0].m_timestamp << ", ";
-    std::cout << channelLoaded2.m_data[0].m_value << ")" << std::endl;
+    std::cout << "Datapoints vector size: " << channelLoaded2.size() << ", ";
+    std::cout << "First datapoint: (" << toMilliseconds(channelLoaded2.at(0).m_timestamp) << ", ";
+    std::cout << channelLoaded2.at(0).m_value << ")" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "----------------------- FAST RESTART -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // Restart from the collector's checkpoints + log: only the channel directory and
+    // the log tail are read, then the queried channel is paged in from the snapshots.
+    double jsonRestartMs;
+    {
+        Timer timer("restart from JSON (load everything + first query)");
+        std::unordered_map<uint16_t, DataChannel> jsonChannels;
+        loadJson(jsonChannels);
+        retrieveChannelSubsets(jsonChannels, {channelToSave}, lowerTs, upperTs);
+        jsonRestartMs = timer.elapsed();
+    }
+
+    RecoveredStore recovered;
+    double restartMs;
+    size_t firstQueryValues;
+    {
+        Timer timer("restart from snapshot + log (directory + first query)");
+        recovered.open(durableDirectory);
+        auto firstQuery = retrieveChannelSubsets(recovered.load({channelToSave}), {channelToSave}, lowerTs, upperTs);
+        firstQueryValues = firstQuery[channelToSave].m_values.size();
+        restartMs = timer.elapsed();
+    }
+
+    std::cout << std::endl;
+    std::cout << "Checkpoints taken: " << durableLog.m_checkpoints << " (" << durableLog.m_checkpointFailures << " failed, snapshots compacted " << durableLog.m_compactions;
+    std::cout << " times), channels recovered: " << recovered.ids().size();
+    std::cout << " (log sequence " << recovered.m_logSequence << ", " << recovered.m_replayed << " log records replayed)" << std::endl;
+    std::cout << "Directory + log tail loaded in " << recovered.m_openMs << " ms, first query (" << firstQueryValues;
+    std::cout << " values) answered " << restartMs << " ms after startup (JSON: " << jsonRestartMs << " ms)" << std::endl;
+    std::cout << "Channel " << channelToSave << " recovered: " << recovered.channel(channelToSave).size() << " datapoints (collected: ";
+    std::cout << channels[channelToSave].size() << "), channels paged in: " << recovered.m_pagedIn << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "----------------------- INCREMENTAL SAVES -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // A periodic save only appends what was collected since the previous one
+    std::cout << "Collecting one more second, then saving again..." << std::endl;
+    {
+        std::mt19937 saveGen(5);
+        std::uniform_real_distribution<double> valueDist(0.0, 1.0);
+        for (auto& pair : channels) {
+            if (pair.second.empty()) continue;
+            Timestamp last = pair.second.m_timestamps.back();
+            for (int i = 1; i <= 100; i++) pair.second.insert(DataPoint(last + i * 10 * kNanosPerMilli, valueDist(saveGen)));
+        }
+        Timer timer("incremental save");
+        saveJson(channels);
+        std::cout << "Incremental save: " << timer.elapsed() << " ms (full save: " << fullSaveMs << " ms)" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "----------------------- PIPELINE TOPOLOGY -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // Same unpaced load through the shared thread pool topology and through
+    // the pinned per-core pipeline (one queue + one channel subset per collector).
+    GeneratorConfig stressConfig;
+    stressConfig.m_duration = 120000.0;
+    stressConfig.m_paced = false;
+    stressConfig.m_producerThreads = 2;
+
+    PipelineConfig sharedTopology;
+    sharedTopology.m_numShards = 2;
+    sharedTopology.m_partitioned = false;
+    sharedTopology.m_pinned = false;
+
+    PipelineConfig pinnedTopology;
+    pinnedTopology.m_numShards = 2;
+
+    std::unordered_map<uint16_t, DataChannel> sharedChannels;
+    PipelineReport sharedReport = runPipeline(stressConfig, sharedTopology, sharedChannels);
+    std::unordered_map<uint16_t, DataChannel> pinnedChannels;
+    PipelineReport pinnedReport = runPipeline(stressConfig, pinnedTopology, pinnedChannels);
+
+    std::cout << std::endl;
+    printPipelineReport("Shared queue, shared channels", sharedReport);
+    printPipelineReport("Pinned, partitioned by channel", pinnedReport);
+    if (sharedReport.m_countersAvailable && pinnedReport.m_countersAvailable && sharedReport.missesPerSample() > 0) {
+        std::cout << "Total cache misses per datapoint reduced by " 
+                  << 100.0 * (1.0 - pinnedReport.missesPerSample() / sharedReport.missesPerSample()) << "%" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "----------------------- PARTITIONED DEPLOYMENT -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // Same unpaced load routed to 1, 2 and 4 collector processes over Unix domain sockets,
+    // then a scatter-gather subset query over every channel
+    std::vector<uint16_t> allIds;
+    for (uint16_t id = 0; id < stressConfig.m_numChannels; id++) allIds.push_back(id);
+    std::cout << "Cores available: " << std::thread::hardware_concurrency() << std::endl;
+    for (unsigned numPartitions : {1u, 2u, 4u}) {
+        PartitionRouter router;
+        if (!router.start(numPartitions, "../storage/partitions")) {
+            std::cout << "Could not start " << numPartitions << " partition processes" << std::endl;
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        uint64_t generated = generatorProducer(stressConfig, 0, stressConfig.m_numChannels, 42,
+            [&](std::vector<DataInput>& batch) { router.ingest(batch); });
+        uint64_t stored = router.sync();
+        double ingestSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        auto gathered = router.retrieveChannelSubsets(allIds, fromMilliseconds(10000), fromMilliseconds(110000));
+        double queryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        size_t gatheredValues = 0;
+        for (auto& subset : gathered) gatheredValues += subset.second.m_values.size();
+
+        std::cout << numPartitions << " partition(s): " << stored << " / " << generated << " datapoints stored, ";
+        std::cout << static_cast<uint64_t>(generated / ingestSeconds) << " datapoints/s, scatter-gather query ";
+        std::cout << queryMs << " ms (" << gathered.size() << " channels, " << gatheredValues << " values, ";
+        std::cout << router.m_failed.size() << " partition(s) failed)" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "----------------------- LATEST VALUES -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // A dashboard thread reads the latest value of every channel while ingest runs,
+    // without taking the channels lock, then an "as of" query over every channel
+    GeneratorConfig latestConfig = stressConfig;
+    latestConfig.m_duration = 20000.0;
+    latestConfig.m_producerThreads = 1;
+    DataQueue latestQueue;
+    std::unordered_map<uint16_t, DataChannel> latestChannels;
+    LatestValueTable latestTable;
+    std::atomic<bool> ingesting{true};
+    std::thread latestGenerator(dataGenerator, std::ref(latestQueue), std::cref(latestConfig));
+    std::thread latestCollector([&] {
+        dataCollectorBatched(latestQueue, latestChannels, 0, nullptr, nullptr, &latestTable);
+        ingesting = false;
+    });
+
+    std::vector<DataPoint> latestValues(allIds.size());
+    uint64_t dashboardReads = 0;
+    size_t channelsSeen = 0;
+    auto readStart = std::chrono::steady_clock::now();
+    while (ingesting) {
+        channelsSeen = latestTable.latest(allIds, latestValues);
+        dashboardReads++;
+    }
+    double readNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - readStart).count();
+    latestGenerator.join();
+    latestCollector.join();
+    std::cout << dashboardReads << " dashboard reads during ingest, " << readNs / std::max<uint64_t>(dashboardReads, 1);
+    std::cout << " ns per read of " << allIds.size() << " latest values (" << channelsSeen << " channels seen)" << std::endl;
+
+    Timestamp asOfTimestamp = fromMilliseconds(10000);
+    auto asOfStart = std::chrono::steady_clock::now();
+    size_t asOfFound = retrieveChannelsAsOf(latestChannels, allIds, asOfTimestamp, latestValues);
+    double asOfUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - asOfStart).count();
+    auto subsetStart = std::chrono::steady_clock::now();
+    size_t subsetFound = 0;
+    SubChannelMap latestSubsets;
+    for (uint16_t id : allIds) {
+        retrieveChannelSubsets(latestChannels, {id}, 0, asOfTimestamp, latestSubsets);
+        subsetFound += !latestSubsets.at(id).m_values.empty();
+    }
+    double subsetUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - subsetStart).count();
+    std::cout << "As-of query over " << allIds.size() << " channels: " << asOfUs << " us (" << asOfFound;
+    std::cout << " found), vs " << subsetUs << " us for " << allIds.size() << " subset queries (" << subsetFound << " found)" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "----------------------- QUERY CACHE -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // A dashboard refreshes 4 historical windows and the live tail of every channel
+    // while datapoints keep arriving, without and with the result cache
+    std::vector<std::pair<Timestamp, Timestamp>> windows;
+    for (double from : {0.0, 4000.0, 8000.0, 12000.0}) windows.emplace_back(fromMilliseconds(from), fromMilliseconds(from + 2000.0));
+    windows.emplace_back(fromMilliseconds(18000), fromMilliseconds(1000000));
+    const int refreshes = 30;
+    Timestamp liveTimestamp = fromMilliseconds(latestConfig.m_duration);
+    auto appendLive = [&] {
+        liveTimestamp += fromMilliseconds(10);
+        for (uint16_t id : allIds) latestChannels[id].insert(DataPoint(liveTimestamp, 1.0));
+    };
+
+    SubChannelMap dashboardSubsets;
+    size_t uncachedValues = 0;
+    auto uncachedStart = std::chrono::steady_clock::now();
+    for (int refresh = 0; refresh < refreshes; refresh++) {
+        appendLive();
+        for (auto& window : windows) {
+            retrieveChannelSubsets(latestChannels, allIds, window.first, window.second, dashboardSubsets);
+            for (auto& subset : dashboardSubsets) uncachedValues += subset.second.m_values.size();
+        }
+    }
+    double uncachedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uncachedStart).count();
+
+    QueryCache queryCache;
+    size_t cachedValues = 0;
+    auto cachedStart = std::chrono::steady_clock::now();
+    for (int refresh = 0; refresh < refreshes; refresh++) {
+        appendLive();
+        for (auto& window : windows) {
+            auto subsets = queryCache.retrieveChannelSubsets(latestChannels, allIds, window.first, window.second);
+            for (auto& subset : subsets) cachedValues += subset.second->m_values.size();
+        }
+    }
+    double cachedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cachedStart).count();
+
+    std::cout << refreshes << " dashboard refreshes of " << windows.size() << " windows x " << allIds.size() << " channels: ";
+    std::cout << uncachedMs << " ms uncached (" << uncachedValues << " values), " << cachedMs << " ms cached (";
+    std::cout << cachedValues << " values)" << std::endl;
+    std::cout << "Hit rate " << 100.0 * queryCache.hitRate() << "%, " << queryCache.m_invalidations << " tail invalidations, ";
+    std::cout << queryCache.size() << " entries, " << queryCache.memoryBytes() / 1024 << " KiB cached" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "----------------------- ACQUISITION SCHEDULER -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // 2 seconds at 100 hz: sleeping one period after the work (the previous pacing)
+    // drifts by the work and wake-up time of every tick, absolute deadlines don't
+    const double schedulerSeconds = 2.0;
+    GeneratorConfig rateConfig;
+    std::mt19937 rateGen(5);
+    std::vector<DataInput> rateBatch;
+    uint64_t relativeTicks = 0;
+    auto relativeStart = std::chrono::steady_clock::now();
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - relativeStart).count() < schedulerSeconds) {
+        rateBatch.clear();
+        generateTick(rateConfig, relativeTicks + 1, 0, rateBatch, 0, rateConfig.m_numChannels, rateGen);
+        relativeTicks++;
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(rateConfig.basePeriod()));
+    }
+    std::cout << "sleep_for pacing: " << relativeTicks << " ticks of the 100 hz group in " << schedulerSeconds;
+    std::cout << " s (expected " << static_cast<uint64_t>(schedulerSeconds * 100.0) << ")" << std::endl;
+
+    // Same 101 channels plus channels at arbitrary rates, on absolute deadlines
+    DeadlineScheduler scheduler(rateConfig, 0, rateConfig.m_numChannels);
+    scheduler.addChannel(rateConfig.m_numChannels, 1000.0);
+    scheduler.addChannel(rateConfig.m_numChannels + 1, 333.0);
+    scheduler.addChannel(rateConfig.m_numChannels + 2, 7.0);
+    uint64_t scheduled = scheduler.run(fromMilliseconds(schedulerSeconds * 1000.0), [&](Timestamp timestamp, const std::vector<uint16_t>& due) {
+        rateBatch.clear();
+        for (uint16_t channel : due) generateDataInputs(timestamp, rateBatch, channel, channel + 1, rateGen, rateConfig.m_nanProbability);
+    });
+    std::cout << scheduled << " samples scheduled" << std::endl;
+    printSchedulerReport("Absolute deadlines", scheduler);
+    std::cout << std::endl;
+
+    std::cout << "----------------------- ASYNC PIPELINE -------------------------" << std::endl;
+    std::cout << std::endl;
+
+    // Same unpaced load as coroutines on 2 executor threads, persisting every channel,
+    // then a short paced run: the 101 channels are driven by timers, not sleeping threads.
+    AsyncPipelineConfig asyncConfig;
+    asyncConfig.m_persistDirectory = "../storage/async";
+
+    std::unordered_map<uint16_t, DataChannel> asyncChannels;
+    AsyncPipelineReport asyncReport = runAsyncPipeline(stressConfig, asyncConfig, asyncChannels);
+
+    GeneratorConfig pacedConfig;
+    pacedConfig.m_duration = 2000.0;
+    AsyncPipelineConfig pacedAsyncConfig;
+    std::unordered_map<uint16_t, DataChannel> pacedChannels;
+    AsyncPipelineReport pacedReport = runAsyncPipeline(pacedConfig, pacedAsyncConfig, pacedChannels);
+
+    std::cout << std::endl;
+    printAsyncPipelineReport("Async pipeline (unpaced, persisted)", asyncReport);
+    printAsyncPipelineReport("Async pipeline (paced)", pacedReport);
     std::cout << std::endl;
 
     return 0;
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "partitionRouter.h"
+#include "partitionServer.h"
+#include "socketFunctions.h"
+
+PartitionRouter::~PartitionRouter() {
+    shutdown();
+}
+
+/**
+ * @brief Fork the partition processes and connect to them.
+ * 
+ * @param numPartitions 
+ * @param socketDirectory where the socket files are created
+ * @return true if every partition is connected
+ * 
+ * @details The listening socket is created before forking, so the
+ * connection is queued even if the child has not called accept yet.
+ * A child closes the connections of the partitions forked before it,
+ * so each partition sees its front-end go away. Fork before starting
+ * threads in the calling process.
+ */
+
+bool PartitionRouter::start(unsigned numPartitions, const std::string& socketDirectory) {
+    std::filesystem::create_directories(socketDirectory);
+    for (unsigned p = 0; p < std::max(1u, numPartitions); p++) {
+        PartitionHandle partition;
+        partition.m_path = socketDirectory + "/partition_" + std::to_string(p) + ".sock";
+        int listenFd = listenUnixSocket(partition.m_path);
+        if (listenFd < 0) return false;
+
+        partition.m_pid = fork();
+        if (partition.m_pid < 0) {
+            closeSocket(listenFd);
+            return false;
+        }
+        if (partition.m_pid == 0) {
+            for (PartitionHandle& other : m_partitions) closeSocket(other.m_fd);
+            PartitionServer server(p);
+            bool stopped = server.serve(listenFd);
+            _exit(stopped ? 0 : 1);
+        }
+
+        partition.m_fd = connectUnixSocket(partition.m_path);
+        closeSocket(listenFd);
+        m_partitions.push_back(std::move(partition));
+        if (m_partitions.back().m_fd < 0) return false;
+        m_partitions.back().m_pending.reserve(kBatchRecords * kPartitionRecordSize);
+    }
+    return true;
+}
+
+unsigned PartitionRouter::partitionOf(uint16_t channelId) const {
+    return channelId % m_partitions.size();
+}
+
+/**
+ * @brief Route datapoints to their partitions.
+ * 
+ * @details A channel's name and unit are sent once, right away, so they
+ * reach the partition before any of its buffered datapoints. A
+ * partition's buffer is sent when it holds kBatchRecords.
+ */
+
+bool PartitionRouter::ingest(const std::vector<DataInput>& batch) {
+    std::vector<char> declaration;
+    for (const DataInput& input : batch) {
+        PartitionHandle& partition = m_partitions[partitionOf(input.m_id)];
+        if (partition.m_declared.insert(input.m_id).second) {
+            declaration.clear();
+            appendBytes(declaration, input.m_id);
+            appendBytes(declaration, static_cast<uint16_t>(input.m_name.size()));
+            appendBytes(declaration, static_cast<uint16_t>(input.m_unit.size()));
+            declaration.insert(declaration.end(), input.m_name.begin(), input.m_name.end());
+            declaration.insert(declaration.end(), input.m_unit.begin(), input.m_unit.end());
+            if (!send(partition, uint32_t(PartitionMessage::Channel), declaration)) return false;
+        }
+
+        appendBytes(partition.m_pending, input.m_dp.m_timestamp);
+        appendBytes(partition.m_pending, input.m_dp.m_value);
+        appendBytes(partition.m_pending, input.m_id);
+        m_routed++;
+        if (partition.m_pending.size() >= kBatchRecords * kPartitionRecordSize) {
+            if (!send(partition, uint32_t(PartitionMessage::Ingest), partition.m_pending)) return false;
+            partition.m_pending.clear();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Send the buffered datapoints of every partition.
+ */
+
+bool PartitionRouter::flush() {
+    bool sent = true;
+    for (PartitionHandle& partition : m_partitions) {
+        if (partition.m_pending.empty()) continue;
+        sent &= send(partition, uint32_t(PartitionMessage::Ingest), partition.m_pending);
+        partition.m_pending.clear();
+    }
+    return sent;
+}
+
+/**
+ * @brief Flush, then wait until every partition stored its datapoints.
+ * 
+ * @return uint64_t total number of datapoints stored by the partitions
+ */
+
+uint64_t PartitionRouter::sync() {
+    flush();
+    for (PartitionHandle& partition : m_partitions) send(partition, uint32_t(PartitionMessage::Sync), {});
+
+    uint64_t stored = 0;
+    uint32_t type;
+    std::vector<char> reply;
+    for (PartitionHandle& partition : m_partitions) {
+        if (!receiveMessage(partition.m_fd, type, reply) || reply.size() != sizeof(uint64_t)) continue;
+        const char* at = reply.data();
+        stored += readBytes<uint64_t>(at);
+    }
+    return stored;
+}
+
+/**
+ * @brief Scatter-gather subset query over the partitions.
+ * 
+ * @param channelIds 
+ * @param lowerBoundTimestamp 
+ * @param upperBoundTimestamp 
+ * @return std::unordered_map<uint16_t, ExtractedSubChannel>
+ * 
+ * @details Same output as retrieveChannelSubsets on a single channel
+ * map, for the channels that exist. Pending datapoints are sent first,
+ * so the query sees everything ingested so far. The request is sent
+ * to every partition involved before any answer is read, so the
+ * partitions extract their subsets in parallel. A partition that can't
+ * be sent the request or doesn't answer it is reported and listed in
+ * m_failed, and its connection closed unless it answered with an Error.
+ */
+
+std::unordered_map<uint16_t, ExtractedSubChannel> PartitionRouter::retrieveChannelSubsets(
+    const std::vector<uint16_t>& channelIds, Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp)
+{
+    flush();
+    m_failed.clear();
+    std::vector<std::vector<uint16_t>> partitionIds(m_partitions.size());
+    for (uint16_t id : channelIds) partitionIds[partitionOf(id)].push_back(id);
+    auto fail = [&](size_t p, bool broken) {
+        std::cerr << "Partition " << p << " did not answer the query" << std::endl;
+        m_failed.push_back(static_cast<unsigned>(p));
+        partitionIds[p].clear();
+        if (broken) {
+            closeSocket(m_partitions[p].m_fd);
+            m_partitions[p].m_fd = -1;
+        }
+    };
+
+    std::vector<char> request;
+    for (size_t p = 0; p < m_partitions.size(); p++) {
+        if (partitionIds[p].empty()) continue;
+        request.clear();
+        appendBytes(request, lowerBoundTimestamp);
+        appendBytes(request, upperBoundTimestamp);
+        appendBytes(request, static_cast<uint32_t>(partitionIds[p].size()));
+        for (uint16_t id : partitionIds[p]) appendBytes(request, id);
+        if (!send(m_partitions[p], uint32_t(PartitionMessage::Query), request)) fail(p, true);
+    }
+
+    std::unordered_map<uint16_t, ExtractedSubChannel> subsetChannels;
+    uint32_t type;
+    std::vector<char> reply;
+    for (size_t p = 0; p < m_partitions.size(); p++) {
+        if (partitionIds[p].empty()) continue;
+        if (!receiveMessage(m_partitions[p].m_fd, type, reply)) fail(p, true);
+        else if (type != uint32_t(PartitionMessage::Query)) fail(p, false);
+        else PartitionServer::decodeSubsets(reply, subsetChannels);
+    }
+    std::sort(m_failed.begin(), m_failed.end());
+    return subsetChannels;
+}
+
+/**
+ * @brief Stop the partition processes and remove their socket files.
+ */
+
+void PartitionRouter::shutdown() {
+    for (PartitionHandle& partition : m_partitions) {
+        send(partition, uint32_t(PartitionMessage::Shutdown), {});
+        closeSocket(partition.m_fd);
+    }
+    for (PartitionHandle& partition : m_partitions) {
+        if (partition.m_pid > 0) waitpid(partition.m_pid, nullptr, 0);
+        std::filesystem::remove(partition.m_path);
+    }
+    m_partitions.clear();
+}
+
+bool PartitionRouter::send(PartitionHandle& partition, uint32_t type, const std::vector<char>& payload) {
+    m_messages++;
+    return partition.m_fd >= 0 && sendMessage(partition.m_fd, type, payload);
+}
@@ -0,0 +1,85 @@
+#ifndef PARTITIONROUTER_H
+#define PARTITIONROUTER_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "dataInput.h"
+#include "extractedSubChannel.h"
+#include "timestamp.h"
+
+/**
+ * @brief Front-end side of one partition process.
+ * 
+ * The collector process (m_pid), the connection to it (m_fd) and the
+ * records routed to it but not sent yet (m_pending). m_declared holds
+ * the channels whose name and unit were already sent.
+ */
+
+class PartitionHandle {
+
+    public:
+        pid_t m_pid = -1;
+        int m_fd = -1;
+        std::string m_path;
+        std::vector<char> m_pending;
+        std::unordered_set<uint16_t> m_declared;
+};
+
+/**
+ * @class PartitionRouter
+ * 
+ * @brief Front-end of the multi-process partitioned deployment.
+ * 
+ * start() forks one collector process (PartitionServer) per partition,
+ * each listening on its own Unix domain socket in the given directory,
+ * and connects to them. Channels are partitioned by id (id modulo the
+ * number of partitions, as the shards of the in-process pipeline), so
+ * each process only holds its share of the channels in memory.
+ * 
+ * ingest() routes the datapoints to their partition, buffering them in
+ * batches of kBatchRecords, and the partitions store them concurrently.
+ * retrieveChannelSubsets() scatters the query to the partitions owning
+ * the requested channels, all at once, and gathers their answers. The
+ * partitions that didn't answer are listed in m_failed (their channels
+ * are missing from the result); a partition whose connection broke is
+ * closed, so the next queries fail fast.
+ * sync() waits until every partition stored what was routed to it.
+ * shutdown() (also called by the destructor) stops the processes.
+ * 
+ */
+
+class PartitionRouter {
+
+    public:
+        static constexpr size_t kBatchRecords = 4096;
+
+        std::vector<PartitionHandle> m_partitions;
+        uint64_t m_routed = 0;
+        uint64_t m_messages = 0;
+        std::vector<unsigned> m_failed; // partitions that didn't answer the last query
+
+        PartitionRouter() = default;
+        PartitionRouter(const PartitionRouter&) = delete;
+        PartitionRouter& operator=(const PartitionRouter&) = delete;
+        ~PartitionRouter();
+
+        bool start(unsigned numPartitions, const std::string& socketDirectory);
+        unsigned partitionOf(uint16_t channelId) const;
+        bool ingest(const std::vector<DataInput>& batch);
+        bool flush();
+        uint64_t sync();
+        std::unordered_map<uint16_t, ExtractedSubChannel> retrieveChannelSubsets(
+            const std::vector<uint16_t>& channelIds, Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp);
+        void shutdown();
+
+    private:
+        bool send(PartitionHandle& partition, uint32_t type, const std::vector<char>& payload);
+};
+
+#endif // PARTITIONROUTER_H
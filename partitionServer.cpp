@@ -0,0 +1,159 @@
+#include <string>
+
+#include "dataCollector.h"
+#include "partitionServer.h"
+#include "socketFunctions.h"
+
+PartitionServer::PartitionServer(unsigned partition) : m_partition(partition) {}
+
+/**
+ * @brief Handle the front-end's messages until Shutdown.
+ * 
+ * @param listenFd listening socket (created by the front-end before forking)
+ * @return true on Shutdown
+ * @return false if the connection failed or the front-end closed it
+ */
+
+bool PartitionServer::serve(int listenFd) {
+    int fd = acceptUnixSocket(listenFd);
+    if (fd < 0) return false;
+
+    uint32_t type;
+    std::vector<char> payload;
+    std::vector<char> reply;
+    bool shutdown = false;
+    while (!shutdown && receiveMessage(fd, type, payload)) {
+        switch (static_cast<PartitionMessage>(type)) {
+            case PartitionMessage::Channel:
+                declareChannel(payload);
+                break;
+            case PartitionMessage::Ingest:
+                storeRecords(payload);
+                break;
+            case PartitionMessage::Sync:
+                reply.clear();
+                appendBytes(reply, m_stored);
+                sendMessage(fd, type, reply);
+                break;
+            case PartitionMessage::Query:
+                answerQuery(payload, reply);
+                if (!sendMessage(fd, type, reply)) sendMessage(fd, uint32_t(PartitionMessage::Error), {});
+                break;
+            case PartitionMessage::Shutdown:
+                shutdown = true;
+                break;
+            case PartitionMessage::Error:
+                break;
+        }
+    }
+    closeSocket(fd);
+    return shutdown;
+}
+
+void PartitionServer::declareChannel(const std::vector<char>& payload) {
+    const char* at = payload.data();
+    uint16_t id = readBytes<uint16_t>(at);
+    uint16_t nameLength = readBytes<uint16_t>(at);
+    uint16_t unitLength = readBytes<uint16_t>(at);
+    std::string name(at, nameLength);
+    std::string unit(at + nameLength, unitLength);
+    if (m_channels.find(id) == m_channels.end()) m_channels.emplace(id, DataChannel(id, name, unit));
+}
+
+void PartitionServer::storeRecords(const std::vector<char>& payload) {
+    const char* at = payload.data();
+    for (size_t count = payload.size() / kPartitionRecordSize; count > 0; count--) {
+        Timestamp timestamp = readBytes<Timestamp>(at);
+        double value = readBytes<double>(at);
+        uint16_t id = readBytes<uint16_t>(at);
+        auto it = m_channels.find(id);
+        if (it == m_channels.end()) {
+            it = m_channels.emplace(id, DataChannel(id, "Sensor_" + std::to_string(id), "Unit_" + std::to_string(id))).first;
+        }
+        m_stored += it->second.insert(DataPoint(timestamp, value));
+    }
+}
+
+void PartitionServer::answerQuery(const std::vector<char>& payload, std::vector<char>& reply) {
+    const char* at = payload.data();
+    Timestamp lower = readBytes<Timestamp>(at);
+    Timestamp upper = readBytes<Timestamp>(at);
+    uint32_t count = readBytes<uint32_t>(at);
+    std::vector<uint16_t> ids;
+    ids.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t id = readBytes<uint16_t>(at);
+        if (m_channels.find(id) != m_channels.end()) ids.push_back(id);
+    }
+
+    SubChannelMap subsets;
+    retrieveChannelSubsets(m_channels, ids, lower, upper, subsets);
+    reply.clear();
+    encodeSubsets(subsets, reply);
+    m_queries++;
+}
+
+/**
+ * @brief Serialize subsets for a Query answer.
+ * 
+ * @details uint32 count, then per subset: uint16 id, uint16 name length,
+ * uint16 unit length, name, unit, uint64 range start, range size,
+ * late start, late size, NaN count, number of values and of NaN bitmap words, timestamps,
+ * values, NaN bitmap.
+ */
+
+void PartitionServer::encodeSubsets(const SubChannelMap& subsets, std::vector<char>& out) {
+    appendBytes(out, static_cast<uint32_t>(subsets.size()));
+    for (const auto& [id, subset] : subsets) {
+        appendBytes(out, id);
+        appendBytes(out, static_cast<uint16_t>(subset.m_name.size()));
+        appendBytes(out, static_cast<uint16_t>(subset.m_unit.size()));
+        out.insert(out.end(), subset.m_name.begin(), subset.m_name.end());
+        out.insert(out.end(), subset.m_unit.begin(), subset.m_unit.end());
+        appendBytes(out, static_cast<uint64_t>(subset.m_rangeStart));
+        appendBytes(out, static_cast<uint64_t>(subset.m_rangeSize));
+        appendBytes(out, static_cast<uint64_t>(subset.m_lateStart));
+        appendBytes(out, static_cast<uint64_t>(subset.m_lateSize));
+        appendBytes(out, static_cast<uint64_t>(subset.m_nanCount));
+        appendBytes(out, static_cast<uint64_t>(subset.m_values.size()));
+        appendBytes(out, static_cast<uint64_t>(subset.m_nanMask.size()));
+        const char* timestamps = reinterpret_cast<const char*>(subset.m_timestamps.data());
+        const char* values = reinterpret_cast<const char*>(subset.m_values.data());
+        const char* nanMask = reinterpret_cast<const char*>(subset.m_nanMask.data());
+        out.insert(out.end(), timestamps, timestamps + subset.m_timestamps.size() * sizeof(Timestamp));
+        out.insert(out.end(), values, values + subset.m_values.size() * sizeof(double));
+        out.insert(out.end(), nanMask, nanMask + subset.m_nanMask.size() * sizeof(uint64_t));
+    }
+}
+
+void PartitionServer::decodeSubsets(const std::vector<char>& payload, std::unordered_map<uint16_t, ExtractedSubChannel>& out) {
+    const char* at = payload.data();
+    uint32_t count = readBytes<uint32_t>(at);
+    for (uint32_t i = 0; i < count; i++) {
+        ExtractedSubChannel subset;
+        subset.m_id = readBytes<uint16_t>(at);
+        uint16_t nameLength = readBytes<uint16_t>(at);
+        uint16_t unitLength = readBytes<uint16_t>(at);
+        subset.m_name.assign(at, nameLength);
+        subset.m_unit.assign(at + nameLength, unitLength);
+        at += nameLength + unitLength;
+        subset.m_rangeStart = readBytes<uint64_t>(at);
+        subset.m_rangeSize = readBytes<uint64_t>(at);
+        subset.m_lateStart = readBytes<uint64_t>(at);
+        subset.m_lateSize = readBytes<uint64_t>(at);
+        subset.m_nanCount = readBytes<uint64_t>(at);
+        uint64_t size = readBytes<uint64_t>(at);
+        uint64_t words = readBytes<uint64_t>(at);
+        subset.m_timestamps.resize(size);
+        subset.m_values.resize(size);
+        subset.m_nanMask.resize(words);
+        std::memcpy(subset.m_timestamps.data(), at, size * sizeof(Timestamp));
+        at += size * sizeof(Timestamp);
+        std::memcpy(subset.m_values.data(), at, size * sizeof(double));
+        at += size * sizeof(double);
+        std::memcpy(subset.m_nanMask.data(), at, words * sizeof(uint64_t));
+        at += words * sizeof(uint64_t);
+        uint16_t id = subset.m_id;
+        out.emplace(id, std::move(subset));
+    }
+}
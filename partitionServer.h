@@ -0,0 +1,64 @@
+#ifndef PARTITIONSERVER_H
+#define PARTITIONSERVER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "dataChannel.h"
+#include "extractedSubChannel.h"
+#include "timestamp.h"
+
+/**
+ * @brief Messages between the front-end (PartitionRouter) and a partition.
+ * 
+ * Channel: uint16 id, uint16 name length, uint16 unit length, name, unit.
+ * Ingest: records of int64 timestamp, double value, uint16 id (18 bytes).
+ * Sync: empty, answered with the uint64 number of datapoints stored.
+ * Query: int64 lower, int64 upper, uint32 count, uint16 ids, answered
+ * with the encoded subsets (see PartitionServer::encodeSubsets).
+ * Shutdown: empty, not answered.
+ * Error: empty, answers a query whose subsets couldn't be sent (over
+ * kMaxMessagePayload bytes).
+ */
+
+enum class PartitionMessage : uint32_t { Channel = 1, Ingest, Sync, Query, Shutdown, Error };
+
+constexpr size_t kPartitionRecordSize = 18;
+
+/**
+ * @class PartitionServer
+ * 
+ * @brief Collector process owning one partition of the channels.
+ * 
+ * Runs in a process forked by PartitionRouter: serve() accepts the
+ * front-end's connection on the listening socket and handles its
+ * messages one at a time, storing the routed datapoints in its own
+ * channel map and answering subset queries over the channels it owns,
+ * until Shutdown or until the front-end goes away. The process only
+ * ever holds its partition in memory.
+ * 
+ */
+
+class PartitionServer {
+
+    public:
+        unsigned m_partition = 0;
+        std::unordered_map<uint16_t, DataChannel> m_channels;
+        uint64_t m_stored = 0;
+        uint64_t m_queries = 0;
+
+        PartitionServer(unsigned partition);
+
+        bool serve(int listenFd);
+
+        static void encodeSubsets(const SubChannelMap& subsets, std::vector<char>& out);
+        static void decodeSubsets(const std::vector<char>& payload, std::unordered_map<uint16_t, ExtractedSubChannel>& out);
+
+    private:
+        void declareChannel(const std::vector<char>& payload);
+        void storeRecords(const std::vector<char>& payload);
+        void answerQuery(const std::vector<char>& payload, std::vector<char>& reply);
+};
+
+#endif // PARTITIONSERVER_H
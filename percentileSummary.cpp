@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "percentileSummary.h"
+
+void PercentileSummary::add(double value) {
+    m_samples.emplace_back(value, 1.0);
+    m_count++;
+    m_sorted = false;
+}
+
+void PercentileSummary::add(const QuantileSketch& sketch) {
+    double weight = sketch.weight();
+    for (double sample : sketch.samples()) m_samples.emplace_back(sample, weight);
+    m_count += sketch.m_count;
+    m_rankError += sketch.rankError();
+    m_sorted = false;
+}
+
+/**
+ * @brief Value at percentile p (0 - 100). NaN when there are no values.
+ */
+
+double PercentileSummary::percentile(double p) {
+    if (m_samples.empty()) return std::numeric_limits<double>::quiet_NaN();
+    sort();
+    double target = std::max(1.0, std::ceil(p / 100.0 * m_count));
+    double cumulative = 0.0;
+    for (const auto& [value, weight] : m_samples) {
+        cumulative += weight;
+        // Tolerance for the fractional weights of the sketches
+        if (cumulative >= target - 1e-9) return value;
+    }
+    return m_samples.back().first;
+}
+
+/**
+ * @brief Maximum rank error as a fraction of the number of values.
+ */
+
+double PercentileSummary::relativeError() const {
+    return m_count > 0 ? m_rankError / m_count : 0.0;
+}
+
+void PercentileSummary::sort() {
+    if (m_sorted) return;
+    std::sort(m_samples.begin(), m_samples.end());
+    m_sorted = true;
+}
@@ -0,0 +1,44 @@
+#ifndef PERCENTILESUMMARY_H
+#define PERCENTILESUMMARY_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "quantileSketch.h"
+
+/**
+ * @class PercentileSummary
+ * 
+ * @brief Weighted values of a range, answering percentile queries.
+ * 
+ * Built by the percentile query from the sketches of the whole blocks
+ * in the range (weighted samples) and the exact values of the partial
+ * and open blocks (weight 1). m_rankError bounds how far, in number of
+ * values, the rank of a returned percentile can be from the true one;
+ * it is 0 when every value was added exactly. Percentiles use the
+ * nearest-rank definition: the smallest value with at least p% of the
+ * values less than or equal to it.
+ * 
+ */
+
+class PercentileSummary {
+
+    public:
+        std::vector<std::pair<double, double>> m_samples; // (value, weight)
+        uint64_t m_count = 0;
+        double m_rankError = 0.0;
+        bool m_sorted = true;
+
+        PercentileSummary() = default;
+
+        void add(double value);
+        void add(const QuantileSketch& sketch);
+        double percentile(double p);
+        double relativeError() const;
+
+    private:
+        void sort();
+};
+
+#endif // PERCENTILESUMMARY_H
@@ -0,0 +1,56 @@
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perfCounter.h"
+
+PerfCounter::PerfCounter() {
+#if defined(__linux__)
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+}
+
+PerfCounter::~PerfCounter() {
+#if defined(__linux__)
+    if (m_fd >= 0) close(m_fd);
+#endif
+}
+
+bool PerfCounter::available() const {
+    return m_fd >= 0;
+}
+
+void PerfCounter::start() {
+#if defined(__linux__)
+    if (m_fd < 0) return;
+    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+void PerfCounter::stop() {
+#if defined(__linux__)
+    if (m_fd >= 0) ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+uint64_t PerfCounter::read() const {
+    uint64_t count = 0;
+#if defined(__linux__)
+    if (m_fd >= 0 && ::read(m_fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+    return count;
+}
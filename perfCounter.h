@@ -0,0 +1,37 @@
+#ifndef PERFCOUNTER_H
+#define PERFCOUNTER_H
+
+#include <cstdint>
+
+/**
+ * @class PerfCounter
+ * 
+ * @brief Hardware cache-miss counter of the calling thread.
+ * 
+ * Thin wrapper over perf_event_open (Linux only). Counts the
+ * cache misses of the thread that created it between start()
+ * and stop(): the generic PERF_COUNT_HW_CACHE_MISSES event, usually
+ * the last-level cache. That is every miss (cold, capacity and
+ * conflict ones included), not only the lines owned by another
+ * core, so it doesn't isolate cross-core traffic. When perf events
+ * are not available (other OS, perf_event_paranoid, containers...)
+ * available() is false and read() returns 0, so callers can report
+ * it as unavailable.
+ * 
+ */
+
+class PerfCounter {
+
+    public:
+        int m_fd = -1;
+
+        PerfCounter();
+        ~PerfCounter();
+
+        bool available() const;
+        void start();
+        void stop();
+        uint64_t read() const;
+};
+
+#endif // PERFCOUNTER_H
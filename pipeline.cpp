@@ -0,0 +1,159 @@
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "dataCollector.h"
+#include "perfCounter.h"
+#include "pipeline.h"
+#include "timer.h"
+
+PipelineShard::PipelineShard(size_t capacity, OverloadPolicy policy)
+    : m_queue(capacity, policy) {}
+
+uint64_t PipelineReport::totalCacheMisses() const {
+    return std::accumulate(m_cacheMisses.begin(), m_cacheMisses.end(), uint64_t(0));
+}
+
+double PipelineReport::throughput() const {
+    return m_elapsed > 0 ? m_generated / (m_elapsed / 1e3) : 0.0;
+}
+
+double PipelineReport::missesPerSample() const {
+    return m_generated > 0 ? static_cast<double>(totalCacheMisses()) / m_generated : 0.0;
+}
+
+/**
+ * @brief Pin the calling thread to a core.
+ * 
+ * @param core 
+ * @return true if the affinity was set
+ * 
+ * @details Only supported on Linux, elsewhere the thread
+ * is left to the scheduler.
+ */
+
+bool pinThreadToCore(int core) {
+#if defined(__linux__)
+    int numCores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % numCores, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void) core;
+    return false;
+#endif
+}
+
+/**
+ * @brief Run generation + collection with the given topology.
+ * 
+ * @param generatorConfig 
+ * @param pipelineConfig 
+ * @param channels filled with the collected channels of every shard
+ * @return PipelineReport 
+ * 
+ * @details Starts one collector per shard (drain-all batched
+ * collector on the shard's queue, channels and lock) and the
+ * producer threads of the generator config. Each producer routes
+ * the inputs of a tick by channel shard and pushes one batch per
+ * shard. Once the producers are done the queues are closed, the
+ * collectors drain them, and the shard channels are moved into
+ * the output map.
+ */
+
+PipelineReport runPipeline(
+    const GeneratorConfig& generatorConfig,
+    const PipelineConfig& pipelineConfig,
+    std::unordered_map<uint16_t, DataChannel>& channels)
+{
+    Timer timer(pipelineConfig.m_partitioned ? "pipeline (partitioned)" : "pipeline (shared)");
+    if (!generatorConfig.valid()) {
+        std::cerr << "Invalid generator config: every group and channel rate must be positive" << std::endl;
+        return PipelineReport();
+    }
+
+    unsigned numCollectors = pipelineConfig.numShards();
+    unsigned numQueues = pipelineConfig.m_partitioned ? numCollectors : 1;
+    unsigned numProducers = std::max(1u, generatorConfig.m_producerThreads);
+    uint32_t seed = generatorConfig.m_seed != 0 ? generatorConfig.m_seed : std::random_device{}();
+
+    std::vector<std::unique_ptr<PipelineShard>> shards;
+    for (unsigned i = 0; i < numQueues; i++) {
+        shards.push_back(std::make_unique<PipelineShard>(pipelineConfig.m_queueCapacity, pipelineConfig.m_policy));
+    }
+
+    PipelineReport report;
+    report.m_cacheMisses.assign(numCollectors, 0);
+    std::vector<char> countersAvailable(numCollectors, 0);
+
+    std::vector<std::thread> collectors;
+    for (unsigned i = 0; i < numCollectors; i++) {
+        collectors.emplace_back([&, i] {
+            if (pipelineConfig.m_pinned) pinThreadToCore(pipelineConfig.collectorCore(i));
+            PipelineShard& shard = *shards[pipelineConfig.m_partitioned ? i : 0];
+            PerfCounter counter;
+            counter.start();
+            dataCollectorBatched(shard.m_queue, shard.m_channels, 0, &shard.m_channelsMtx);
+            counter.stop();
+            report.m_cacheMisses[i] = counter.read();
+            countersAvailable[i] = counter.available();
+        });
+    }
+
+    std::vector<uint64_t> generated(numProducers, 0);
+    std::vector<std::thread> producers;
+    for (unsigned j = 0; j < numProducers; j++) {
+        uint16_t startIndex = static_cast<uint16_t>(j * generatorConfig.m_numChannels / numProducers);
+        uint16_t endIndex = static_cast<uint16_t>((j + 1) * generatorConfig.m_numChannels / numProducers);
+        producers.emplace_back([&, j, startIndex, endIndex] {
+            if (pipelineConfig.m_pinned) pinThreadToCore(pipelineConfig.producerCore(j));
+            std::vector<std::vector<DataInput>> routed(numQueues);
+            generated[j] = generatorProducer(generatorConfig, startIndex, endIndex, seed + j,
+                [&](std::vector<DataInput>& batch) {
+                    for (DataInput& input : batch) {
+                        routed[pipelineConfig.shardOf(input.m_id)].push_back(std::move(input));
+                    }
+                    for (unsigned q = 0; q < numQueues; q++) {
+                        if (routed[q].empty()) continue;
+                        shards[q]->m_queue.pushBatch(routed[q]);
+                        routed[q].clear();
+                    }
+                });
+        });
+    }
+
+    for (auto& producer : producers) producer.join();
+    for (auto& shard : shards) shard->m_queue.close();
+    for (auto& collector : collectors) collector.join();
+
+    for (auto& shard : shards) {
+        for (auto& pair : shard->m_channels) channels.insert_or_assign(pair.first, std::move(pair.second));
+    }
+
+    report.m_generated = std::accumulate(generated.begin(), generated.end(), uint64_t(0));
+    report.m_elapsed = timer.elapsed();
+    report.m_countersAvailable = std::all_of(countersAvailable.begin(), countersAvailable.end(), [](char c) { return c; });
+    return report;
+}
+
+/**
+ * @brief Print throughput and total cache misses of a pipeline run.
+ */
+
+void printPipelineReport(const std::string& name, const PipelineReport& report) {
+    std::cout << name << ": " << report.m_generated << " datapoints in " << report.m_elapsed << " ms (";
+    std::cout << report.throughput() << " datapoints/s)" << std::endl;
+    if (!report.m_countersAvailable) {
+        std::cout << "  Cache miss counters not available on this platform" << std::endl;
+        return;
+    }
+    std::cout << "  Collector cache misses (total, all causes): " << report.totalCacheMisses();
+    std::cout << " (" << report.missesPerSample() << " per datapoint)" << std::endl;
+}
@@ -0,0 +1,57 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dataChannel.h"
+#include "dataQueue.h"
+#include "generatorConfig.h"
+#include "pipelineConfig.h"
+
+/**
+ * @brief Per-core pipeline topology.
+ * 
+ * @details Generator and collector threads arranged as described
+ * by PipelineConfig: each PipelineShard is the input queue and the
+ * channels owned by one collector, so in partitioned mode samples of
+ * a channel are only ever touched by one core after routing. The
+ * collectors count their total cache misses (PerfCounter) so both
+ * topologies can be compared: a difference includes the cross-core
+ * traffic saved by partitioning, but the count is not specific to it.
+ * The counters are reported as not available when the platform
+ * doesn't allow it.
+ */
+
+class PipelineShard {
+
+    public:
+        DataQueue m_queue;
+        std::unordered_map<uint16_t, DataChannel> m_channels;
+        std::mutex m_channelsMtx;
+
+        PipelineShard(size_t capacity, OverloadPolicy policy);
+};
+
+class PipelineReport {
+
+    public:
+        uint64_t m_generated = 0;
+        double m_elapsed = 0.0; // in milliseconds
+        bool m_countersAvailable = false;
+        std::vector<uint64_t> m_cacheMisses; // total cache misses, per collector
+
+        uint64_t totalCacheMisses() const;
+        double throughput() const;
+        double missesPerSample() const;
+};
+
+bool pinThreadToCore(int core);
+PipelineReport runPipeline(const GeneratorConfig& generatorConfig, const PipelineConfig& pipelineConfig,
+    std::unordered_map<uint16_t, DataChannel>& channels);
+void printPipelineReport(const std::string& name, const PipelineReport& report);
+
+#endif // PIPELINE_H
@@ -0,0 +1,22 @@
+#include <algorithm>
+#include <thread>
+
+#include "pipelineConfig.h"
+
+unsigned PipelineConfig::numShards() const {
+    return std::max(1u, m_numShards);
+}
+
+unsigned PipelineConfig::shardOf(uint16_t channelId) const {
+    return m_partitioned ? channelId % numShards() : 0;
+}
+
+int PipelineConfig::collectorCore(unsigned collector) const {
+    if (collector < m_collectorCores.size()) return m_collectorCores[collector];
+    return static_cast<int>(collector % std::max(1u, std::thread::hardware_concurrency()));
+}
+
+int PipelineConfig::producerCore(unsigned producer) const {
+    if (producer < m_producerCores.size()) return m_producerCores[producer];
+    return static_cast<int>((numShards() + producer) % std::max(1u, std::thread::hardware_concurrency()));
+}
@@ -0,0 +1,45 @@
+#ifndef PIPELINECONFIG_H
+#define PIPELINECONFIG_H
+
+#include <cstdint>
+#include <vector>
+
+#include "dataQueue.h"
+
+/**
+ * @class PipelineConfig
+ * 
+ * @brief Topology of the per-core collection pipeline.
+ * 
+ * In partitioned mode every collector owns its own DataQueue and
+ * its own subset of channels (channel id modulo m_numShards), and
+ * producers route each input to the queue of its channel's shard.
+ * With m_partitioned = false all collectors share a single queue and
+ * a single channel map (the original thread pool topology), which is
+ * useful as a baseline. When m_pinned is set, collector i runs on
+ * core m_collectorCores[i] and producer j on m_producerCores[j]
+ * (defaults: collectors on the first cores, producers on the next
+ * ones, wrapping around the available cores).
+ * 
+ */
+
+class PipelineConfig {
+
+    public:
+        unsigned m_numShards = 2;
+        bool m_partitioned = true;
+        bool m_pinned = true;
+        std::vector<int> m_collectorCores;
+        std::vector<int> m_producerCores;
+        size_t m_queueCapacity = 1 << 16;
+        OverloadPolicy m_policy = OverloadPolicy::Block;
+
+        PipelineConfig() = default;
+
+        unsigned numShards() const;
+        unsigned shardOf(uint16_t channelId) const;
+        int collectorCore(unsigned collector) const;
+        int producerCore(unsigned producer) const;
+};
+
+#endif // PIPELINECONFIG_H
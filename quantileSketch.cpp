@@ -0,0 +1,41 @@
+#include <algorithm>
+
+#include "quantileSketch.h"
+
+/**
+ * @brief Build the sketch from the valid values of a block (sorts them).
+ */
+
+void QuantileSketch::build(std::span<double> values) {
+    std::sort(values.begin(), values.end());
+    m_count = static_cast<uint32_t>(values.size());
+    if (values.size() <= kSamples) {
+        std::copy(values.begin(), values.end(), m_samples.begin());
+        m_size = m_count;
+        return;
+    }
+    for (size_t j = 0; j < kSamples; j++) {
+        m_samples[j] = values[(2 * j + 1) * values.size() / (2 * kSamples)];
+    }
+    m_size = kSamples;
+}
+
+std::span<const double> QuantileSketch::samples() const {
+    return std::span<const double>(m_samples.data(), m_size);
+}
+
+/**
+ * @brief Number of values each sample stands for.
+ */
+
+double QuantileSketch::weight() const {
+    return m_size == 0 ? 0.0 : static_cast<double>(m_count) / m_size;
+}
+
+/**
+ * @brief Maximum rank error (in values) of the sketch.
+ */
+
+double QuantileSketch::rankError() const {
+    return m_size == m_count ? 0.0 : weight();
+}
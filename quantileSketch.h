@@ -0,0 +1,42 @@
+#ifndef QUANTILESKETCH_H
+#define QUANTILESKETCH_H
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+/**
+ * @class QuantileSketch
+ * 
+ * @brief Equi-depth sample of the values of a sealed block.
+ * 
+ * Keeps kSamples of the sorted valid values, taken at evenly spaced
+ * ranks, so every sample stands for m_count / kSamples values and the
+ * rank of any value is known within m_count / kSamples. Sketches of
+ * different blocks merge by simply pooling their weighted samples
+ * (see PercentileSummary), the rank errors adding up: a percentile
+ * over any number of blocks is within 1 / kSamples of the true rank.
+ * Blocks with at most kSamples valid values are kept exactly. The
+ * samples are stored inline (m_size of them), so sealing a block
+ * doesn't allocate.
+ * 
+ */
+
+class QuantileSketch {
+
+    public:
+        static constexpr size_t kSamples = 128;
+
+        std::array<double, kSamples> m_samples;
+        uint32_t m_size = 0;
+        uint32_t m_count = 0;
+
+        QuantileSketch() = default;
+
+        void build(std::span<double> values);
+        std::span<const double> samples() const;
+        double weight() const;
+        double rankError() const;
+};
+
+#endif // QUANTILESKETCH_H
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+#include "dataCollector.h"
+#include "queryCache.h"
+
+/**
+ * @brief Position of a time range in a channel, late buffer included.
+ *
+ * @return std::pair<size_t, size_t> index of its first datapoint once
+ * the late buffer is merged, and its number of datapoints
+ */
+
+static std::pair<size_t, size_t> rangePosition(const DataChannel& channel, Timestamp lower, Timestamp upper) {
+    size_t start = channel.lowerBound(lower);
+    size_t count = std::max(start, channel.upperBound(upper)) - start;
+    for (const DataPoint& dp : channel.m_late) {
+        if (dp.m_timestamp < lower) start++;
+        else if (dp.m_timestamp <= upper) count++;
+    }
+    return {start, count};
+}
+
+/**
+ * @brief Whether no insert can change the range any more.
+ */
+
+static bool rangeClosed(const DataChannel& channel, Timestamp upper) {
+    return !channel.empty() && upper < channel.m_timestamps.back() - channel.m_maxLateness;
+}
+
+size_t QueryCache::KeyHash::operator()(const Key& key) const {
+    size_t h = std::hash<Timestamp>()(key.m_lower);
+    h ^= std::hash<Timestamp>()(key.m_upper) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= (size_t(key.m_channelId) << 1 | size_t(key.m_kind)) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+QueryCache::QueryCache(size_t maxBytes) : m_maxBytes(maxBytes) {}
+
+/**
+ * @brief Subsets of channels between 2 timestamps, from the cache when valid.
+ *
+ * @param channels
+ * @param channelIds
+ * @param lowerBoundTimestamp
+ * @param upperBoundTimestamp
+ * @return std::unordered_map<uint16_t, std::shared_ptr<const ExtractedSubChannel>>
+ *
+ * @details Same subsets as retrieveChannelSubsets, shared with the
+ * cache instead of copied. Missing or stale ones are extracted and
+ * cached.
+ */
+
+std::unordered_map<uint16_t, std::shared_ptr<const ExtractedSubChannel>> QueryCache::retrieveChannelSubsets(
+    std::unordered_map<uint16_t, DataChannel>& channels,
+    const std::vector<uint16_t>& channelIds,
+    Timestamp lowerBoundTimestamp,
+    Timestamp upperBoundTimestamp)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    std::unordered_map<uint16_t, std::shared_ptr<const ExtractedSubChannel>> subsets;
+    SubChannelMap extracted;
+
+    for (uint16_t channelId : channelIds) {
+        DataChannel& channel = channels[channelId];
+        Key key{channelId, Kind::Subset, lowerBoundTimestamp, upperBoundTimestamp};
+        if (const Entry* entry = lookup(key, channel)) {
+            subsets.emplace(channelId, entry->m_subset);
+            continue;
+        }
+
+        ::retrieveChannelSubsets(channels, {channelId}, lowerBoundTimestamp, upperBoundTimestamp, extracted);
+        Entry entry;
+        entry.m_key = key;
+        entry.m_subset = std::make_shared<const ExtractedSubChannel>(std::move(extracted.at(channelId)));
+        entry.m_bytes = sizeof(Entry) + sizeof(ExtractedSubChannel)
+            + entry.m_subset->m_timestamps.capacity() * sizeof(Timestamp)
+            + entry.m_subset->m_values.capacity() * sizeof(double)
+            + entry.m_subset->m_nanMask.capacity() * sizeof(uint64_t);
+        subsets.emplace(channelId, store(std::move(entry), channel).m_subset);
+    }
+    return subsets;
+}
+
+/**
+ * @brief Aggregates of channels between 2 timestamps, from the cache when valid.
+ *
+ * @param channels
+ * @param channelIds
+ * @param lowerBoundTimestamp
+ * @param upperBoundTimestamp
+ * @return std::unordered_map<uint16_t, ValueAggregate>
+ *
+ * @details Same aggregates as retrieveChannelAggregates.
+ */
+
+std::unordered_map<uint16_t, ValueAggregate> QueryCache::retrieveChannelAggregates(
+    std::unordered_map<uint16_t, DataChannel>& channels,
+    const std::vector<uint16_t>& channelIds,
+    Timestamp lowerBoundTimestamp,
+    Timestamp upperBoundTimestamp)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    std::unordered_map<uint16_t, ValueAggregate> aggregates;
+
+    for (uint16_t channelId : channelIds) {
+        DataChannel& channel = channels[channelId];
+        Key key{channelId, Kind::Aggregate, lowerBoundTimestamp, upperBoundTimestamp};
+        if (const Entry* entry = lookup(key, channel)) {
+            aggregates.emplace(channelId, entry->m_aggregate);
+            continue;
+        }
+
+        channel.mergeLate();
+        Entry entry;
+        entry.m_key = key;
+        entry.m_aggregate = channel.m_values.aggregate(channel.lowerBound(lowerBoundTimestamp),
+            channel.upperBound(upperBoundTimestamp));
+        entry.m_bytes = sizeof(Entry);
+        aggregates.emplace(channelId, store(std::move(entry), channel).m_aggregate);
+    }
+    return aggregates;
+}
+
+/**
+ * @brief Cached entry of a key, if still valid for the channel.
+ *
+ * @details Counts a hit (and moves the entry to the front of the LRU
+ * list) or a miss; a stale entry is dropped and counted as invalidated.
+ */
+
+const QueryCache::Entry* QueryCache::lookup(const Key& key, const DataChannel& channel) {
+    auto found = m_index.find(key);
+    if (found == m_index.end()) {
+        m_misses++;
+        return nullptr;
+    }
+    auto it = found->second;
+    if (!it->m_closed) {
+        auto [start, count] = rangePosition(channel, key.m_lower, key.m_upper);
+        if (start != it->m_rangeStart || count != it->m_rangeCount) {
+            erase(it);
+            m_invalidations++;
+            m_misses++;
+            return nullptr;
+        }
+        // Becomes closed once the channel has moved far enough past it
+        it->m_closed = rangeClosed(channel, key.m_upper);
+    }
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    m_hits++;
+    return &*it;
+}
+
+/**
+ * @brief Caches a computed entry, evicting the least recently used ones.
+ *
+ * @details Records the position of the range in the channel the
+ * entry was just computed from. The newest entry is always kept,
+ * even when larger than m_maxBytes.
+ */
+
+const QueryCache::Entry& QueryCache::store(Entry&& entry, const DataChannel& channel) {
+    std::tie(entry.m_rangeStart, entry.m_rangeCount) = rangePosition(channel, entry.m_key.m_lower, entry.m_key.m_upper);
+    entry.m_closed = rangeClosed(channel, entry.m_key.m_upper);
+    m_entries.push_front(std::move(entry));
+    m_index[m_entries.front().m_key] = m_entries.begin();
+    m_bytes += m_entries.front().m_bytes;
+    while (m_bytes > m_maxBytes && m_entries.size() > 1) {
+        erase(std::prev(m_entries.end()));
+        m_evictions++;
+    }
+    return m_entries.front();
+}
+
+void QueryCache::erase(std::list<Entry>::iterator it) {
+    m_bytes -= it->m_bytes;
+    m_index.erase(it->m_key);
+    m_entries.erase(it);
+}
+
+/**
+ * @brief Drops every entry of a channel (after its history changed).
+ */
+
+void QueryCache::invalidate(uint16_t channelId) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        auto next = std::next(it);
+        if (it->m_key.m_channelId == channelId) {
+            erase(it);
+            m_invalidations++;
+        }
+        it = next;
+    }
+}
+
+void QueryCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+size_t QueryCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_entries.size();
+}
+
+/**
+ * @brief Approximate memory used by the cached results, in bytes.
+ */
+
+size_t QueryCache::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_bytes;
+}
+
+/**
+ * @brief Fraction of the lookups served from the cache (0 without lookups).
+ */
+
+double QueryCache::hitRate() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    uint64_t lookups = m_hits + m_misses;
+    return lookups > 0 ? static_cast<double>(m_hits) / lookups : 0.0;
+}
@@ -0,0 +1,103 @@
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dataChannel.h"
+#include "extractedSubChannel.h"
+#include "timestamp.h"
+#include "valueAggregate.h"
+
+/**
+ * @class QueryCache
+ *
+ * @brief Bounded LRU cache of subset and aggregate query results.
+ *
+ * Results are cached per channel and time range (and kind of query),
+ * so a dashboard requesting the same windows again gets them without
+ * extraction or copy: subsets are shared (shared_ptr) with the cache,
+ * and an evicted subset stays valid for whoever still holds it.
+ *
+ * Invalidation is append-aware. A range is closed when it ends more
+ * than m_maxLateness before the channel's newest datapoint: no insert
+ * can change it any more, so it is served as is. Other entries record
+ * the position of their range in the channel (first index, number of
+ * datapoints, late buffer included) and are recomputed only if it
+ * changed, i.e. if datapoints were inserted in or before the range;
+ * appends after the range keep them valid. Changes to stored history
+ * (truncate, setEncoding) need an explicit invalidate().
+ *
+ * The least recently used entries are evicted once the approximate
+ * memory used exceeds m_maxBytes. Hits, misses, invalidations and
+ * evictions are counted. The cache has its own lock; the channels
+ * must be locked by the caller like for the uncached queries.
+ *
+ */
+
+class QueryCache {
+
+    public:
+        static constexpr size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+
+        enum class Kind : uint8_t { Subset, Aggregate };
+
+        struct Key {
+            uint16_t m_channelId;
+            Kind m_kind;
+            Timestamp m_lower;
+            Timestamp m_upper;
+
+            bool operator==(const Key& other) const = default;
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry {
+            Key m_key;
+            std::shared_ptr<const ExtractedSubChannel> m_subset;
+            ValueAggregate m_aggregate;
+            bool m_closed = false;
+            size_t m_rangeStart = 0;
+            size_t m_rangeCount = 0;
+            size_t m_bytes = 0;
+        };
+
+        size_t m_maxBytes;
+        size_t m_bytes = 0;
+        uint64_t m_hits = 0;
+        uint64_t m_misses = 0;
+        uint64_t m_invalidations = 0;
+        uint64_t m_evictions = 0;
+        std::list<Entry> m_entries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+        mutable std::mutex m_mtx;
+
+        explicit QueryCache(size_t maxBytes = kDefaultMaxBytes);
+
+        std::unordered_map<uint16_t, std::shared_ptr<const ExtractedSubChannel>> retrieveChannelSubsets(
+            std::unordered_map<uint16_t, DataChannel>& channels, const std::vector<uint16_t>& channelIds,
+            Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp);
+        std::unordered_map<uint16_t, ValueAggregate> retrieveChannelAggregates(
+            std::unordered_map<uint16_t, DataChannel>& channels, const std::vector<uint16_t>& channelIds,
+            Timestamp lowerBoundTimestamp, Timestamp upperBoundTimestamp);
+
+        void invalidate(uint16_t channelId);
+        void clear();
+        size_t size() const;
+        size_t memoryBytes() const;
+        double hitRate() const;
+
+    private:
+        const Entry* lookup(const Key& key, const DataChannel& channel);
+        const Entry& store(Entry&& entry, const DataChannel& channel);
+        void erase(std::list<Entry>::iterator it);
+};
+
+#endif // QUERYCACHE_H
@@ -0,0 +1,154 @@
+#include <algorithm>
+
+#include "channelLog.h"
+#include "recoveredStore.h"
+#include "snapshotFunctions.h"
+#include "timer.h"
+
+/**
+ * @brief Load the channel directory and the log tail of a storage directory.
+ * 
+ * @return false if neither a snapshot nor a log could be read
+ */
+
+bool RecoveredStore::open(const std::string& directory) {
+    Timer timer("recovery (directory + log tail)");
+    m_directory = directory;
+    m_entries.clear();
+    m_tail.clear();
+    m_channels.clear();
+    m_logSequence = 0;
+    m_bytesRead = 0;
+    m_replayed = 0;
+    m_pagedIn = 0;
+
+    bool snapshot = readDirectory();
+    replayLog();
+    m_openMs = timer.elapsed();
+    return snapshot || !m_entries.empty();
+}
+
+std::vector<uint16_t> RecoveredStore::ids() const {
+    std::vector<uint16_t> result;
+    for (const auto& pair : m_entries) result.push_back(pair.first);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+const SnapshotEntry* RecoveredStore::entry(uint16_t id) const {
+    auto it = m_entries.find(id);
+    return it != m_entries.end() ? &it->second : nullptr;
+}
+
+/**
+ * @brief The channel, paged in from the snapshot (+ log tail) on first use.
+ */
+
+DataChannel& RecoveredStore::channel(uint16_t id) {
+    auto loaded = m_channels.find(id);
+    if (loaded != m_channels.end()) return loaded->second;
+
+    const SnapshotEntry& entry = m_entries.at(id);
+    DataChannel channel(entry.m_id, entry.m_name, entry.m_unit);
+    channel.setEncoding(entry.m_encoding);
+    channel.reserve(entry.m_count);
+
+    std::vector<Timestamp> timestamps(std::min<uint64_t>(entry.m_snapshotCount, kPageRows));
+    std::vector<double> values(timestamps.size());
+    for (const SnapshotPiece& piece : entry.m_pieces) {
+        for (uint64_t first = 0; first < piece.m_count; first += kPageRows) {
+            size_t rows = static_cast<size_t>(std::min<uint64_t>(kPageRows, piece.m_count - first));
+            readSnapshotRows(m_snapshots[piece.m_file], piece, first, rows, timestamps.data(), values.data());
+            m_bytesRead += rows * (sizeof(Timestamp) + sizeof(double));
+            for (size_t i = 0; i < rows; i++) channel.append(DataPoint(timestamps[i], values[i]));
+        }
+    }
+
+    auto tail = m_tail.find(id);
+    if (tail != m_tail.end()) {
+        for (const DataPoint& dp : tail->second) channel.insert(dp);
+        channel.mergeLate();
+        m_tail.erase(tail);
+    }
+
+    m_pagedIn++;
+    return m_channels.emplace(id, std::move(channel)).first->second;
+}
+
+/**
+ * @brief Page in the given channels; returns the map of paged-in channels.
+ */
+
+std::unordered_map<uint16_t, DataChannel>& RecoveredStore::load(const std::vector<uint16_t>& ids) {
+    for (uint16_t id : ids) {
+        if (m_entries.count(id) > 0) channel(id);
+    }
+    return m_channels;
+}
+
+/**
+ * @brief Read the directories of the snapshot chain, applying the pieces in order.
+ * 
+ * @return false if there is no readable snapshot
+ */
+
+bool RecoveredStore::readDirectory() {
+    m_snapshots.clear();
+    std::unordered_map<uint16_t, std::vector<SnapshotPiece>> chains;
+    for (uint64_t sequence : snapshotSequences(m_directory)) {
+        std::ifstream file(snapshotPath(m_directory, sequence), std::ios::binary);
+        uint64_t logSequence = 0;
+        std::vector<SnapshotPiece> pieces;
+        if (!readSnapshotDirectory(file, logSequence, pieces, m_bytesRead)) continue;
+        for (SnapshotPiece& piece : pieces) {
+            piece.m_file = m_snapshots.size();
+            applySnapshotPiece(chains[piece.m_id], piece);
+        }
+        m_logSequence = logSequence;
+        m_snapshots.push_back(std::move(file));
+    }
+
+    for (auto& [id, chain] : chains) {
+        SnapshotEntry entry;
+        entry.m_id = id;
+        entry.m_name = chain.back().m_name;
+        entry.m_unit = chain.back().m_unit;
+        entry.m_encoding = chain.back().m_encoding;
+        for (const SnapshotPiece& piece : chain) entry.m_snapshotCount += piece.m_count;
+        entry.m_count = entry.m_snapshotCount;
+        entry.m_firstTimestamp = chain.front().m_firstTimestamp;
+        entry.m_lastTimestamp = chain.back().m_lastTimestamp;
+        entry.m_pieces = std::move(chain);
+        m_entries.emplace(id, std::move(entry));
+    }
+    return !m_snapshots.empty();
+}
+
+/**
+ * @brief Replay the log files the snapshot is followed by (all of them without snapshot).
+ */
+
+void RecoveredStore::replayLog() {
+    for (uint64_t sequence : ChannelLog::sequences(m_directory)) {
+        if (sequence < m_logSequence) continue;
+        m_replayed += ChannelLog::replay(ChannelLog::path(m_directory, sequence),
+            [&](uint16_t id, const std::string& name, const std::string& unit) {
+                if (m_entries.count(id) > 0) return;
+                SnapshotEntry entry;
+                entry.m_id = id;
+                entry.m_name = name;
+                entry.m_unit = unit;
+                entry.m_encoding = ValueEncoding::forUnit(unit);
+                m_entries.emplace(id, std::move(entry));
+            },
+            [&](uint16_t id, const DataPoint& dp) {
+                auto it = m_entries.find(id);
+                if (it == m_entries.end()) return;
+                SnapshotEntry& entry = it->second;
+                if (entry.m_count == 0 || dp.m_timestamp < entry.m_firstTimestamp) entry.m_firstTimestamp = dp.m_timestamp;
+                if (entry.m_count == 0 || dp.m_timestamp > entry.m_lastTimestamp) entry.m_lastTimestamp = dp.m_timestamp;
+                entry.m_count++;
+                m_tail[id].push_back(dp);
+            });
+    }
+}
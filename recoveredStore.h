@@ -0,0 +1,81 @@
+#ifndef RECOVEREDSTORE_H
+#define RECOVEREDSTORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dataChannel.h"
+#include "dataPoint.h"
+#include "snapshotFunctions.h"
+#include "timestamp.h"
+#include "valueEncoding.h"
+
+/**
+ * @brief Directory entry of a recovered channel.
+ * 
+ * m_pieces are the rows of the snapshot chain that make up the
+ * channel, in order. m_count and the first / last timestamps include
+ * the log tail, so they can be answered before the channel is paged in.
+ */
+
+struct SnapshotEntry {
+    uint16_t m_id = 0;
+    std::string m_name;
+    std::string m_unit;
+    ValueEncoding m_encoding;
+    uint64_t m_snapshotCount = 0;
+    std::vector<SnapshotPiece> m_pieces;
+    uint64_t m_count = 0;
+    Timestamp m_firstTimestamp = 0;
+    Timestamp m_lastTimestamp = 0;
+};
+
+/**
+ * @class RecoveredStore
+ * 
+ * @brief Channels recovered from the snapshots + log tail, paged in lazily.
+ * 
+ * open() only reads the header and channel directory of every file of
+ * the snapshot chain and replays the log files written since the last
+ * one, so its cost depends on the number of channels and on the recent
+ * data, not on the stored history. A channel's columns are read from
+ * the snapshot files (and its log tail applied) the first time it is
+ * requested with channel() or load(); load() returns the map of
+ * paged-in channels, which the usual retrieve functions can query.
+ * Not thread safe.
+ * 
+ */
+
+class RecoveredStore {
+
+    public:
+        static constexpr size_t kPageRows = 64 * 1024;
+
+        std::string m_directory;
+        uint64_t m_logSequence = 0;
+        std::unordered_map<uint16_t, SnapshotEntry> m_entries;
+        std::unordered_map<uint16_t, std::vector<DataPoint>> m_tail;
+        std::unordered_map<uint16_t, DataChannel> m_channels;
+        std::vector<std::ifstream> m_snapshots;
+        uint64_t m_bytesRead = 0;
+        uint64_t m_replayed = 0;
+        uint64_t m_pagedIn = 0;
+        double m_openMs = 0.0;
+
+        RecoveredStore() = default;
+
+        bool open(const std::string& directory);
+        std::vector<uint16_t> ids() const;
+        const SnapshotEntry* entry(uint16_t id) const;
+        DataChannel& channel(uint16_t id);
+        std::unordered_map<uint16_t, DataChannel>& load(const std::vector<uint16_t>& ids);
+
+    private:
+        bool readDirectory();
+        void replayLog();
+};
+
+#endif // RECOVEREDSTORE_H
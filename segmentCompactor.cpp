@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "segmentCompactor.h"
+
+SegmentCompactor::SegmentCompactor(std::function<std::string(const std::string&)> compact)
+    : m_compact(std::move(compact)) {}
+
+SegmentCompactor::~SegmentCompactor() {
+    stop();
+}
+
+/**
+ * @brief Append a segment (one line) to a file, or replace the file with it.
+ * 
+ * @return true if the segment was written
+ */
+
+bool SegmentCompactor::write(const std::string& path, const std::string& segment, bool replace) {
+    bool due;
+    {
+        std::lock_guard<std::mutex> lock(m_fileMtx);
+        std::ofstream file(path, std::ios::binary | (replace ? std::ios::trunc : std::ios::app));
+        file << segment << '\n';
+        if (!file.good()) return false;
+        uint64_t bytes = segment.size() + 1;
+        if (replace) {
+            m_baseBytes[path] = bytes;
+            m_appendedBytes[path] = 0;
+            m_rewrites[path]++;
+        } else {
+            m_appendedBytes[path] += bytes;
+        }
+        due = m_appendedBytes[path] > 0 && m_appendedBytes[path] >= m_baseBytes[path];
+    }
+    if (due) schedule(path);
+    return true;
+}
+
+/**
+ * @brief Queue a file for compaction (once, until it is compacted).
+ */
+
+void SegmentCompactor::schedule(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (m_stop || !m_queued.insert(path).second) return;
+        m_queue.push_back(path);
+        if (!m_thread.joinable()) m_thread = std::thread([this] { compactLoop(); });
+    }
+    m_cv.notify_all();
+}
+
+/**
+ * @brief Wait until every queued file is compacted.
+ */
+
+void SegmentCompactor::waitIdle() {
+    std::unique_lock<std::mutex> lock(m_mtx);
+    m_cv.wait(lock, [this] { return m_queue.empty() && !m_busy; });
+}
+
+void SegmentCompactor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void SegmentCompactor::compactLoop() {
+    while (true) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_cv.wait(lock, [this] { return !m_queue.empty() || m_stop; });
+            if (m_queue.empty()) break;
+            path = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_queued.erase(path);
+            m_busy = true;
+        }
+        if (compact(path)) m_compactions++;
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_busy = false;
+        }
+        m_cv.notify_all();
+    }
+}
+
+/**
+ * @brief Rewrite a segment file as a single segment.
+ */
+
+bool SegmentCompactor::compact(const std::string& path) {
+    std::string content;
+    uint64_t rewrites;
+    {
+        std::lock_guard<std::mutex> lock(m_fileMtx);
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        rewrites = m_rewrites[path];
+    }
+
+    std::string compacted = m_compact(content);
+    if (compacted.empty()) return false;
+    const std::string temporary = path + ".compact";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file << compacted << '\n';
+        if (!file.good()) return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_fileMtx);
+    if (m_rewrites[path] != rewrites) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    // Segments appended since the file was read follow the compacted one
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(content.size()));
+    std::string appended((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::app);
+        out << appended;
+        if (!out.good()) return false;
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) return false;
+    m_baseBytes[path] = compacted.size() + 1;
+    m_appendedBytes[path] = appended.size();
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef SEGMENTCOMPACTOR_H
+#define SEGMENTCOMPACTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * @class SegmentCompactor
+ * 
+ * @brief Appends to segment files and compacts them in the background.
+ * 
+ * A segment file holds one segment per line. write() appends a segment
+ * (or replaces the file with it) and, once the segments appended to a
+ * file add up to the size of its base (the first or compacted
+ * segment), queues the file for compaction. Each compaction rewrites
+ * at most twice the data appended since the previous one, so the
+ * background work stays proportional to the data saved. A background
+ * thread, started on the first compaction, rewrites the file as the
+ * single line returned by m_compact for its content. Saves are not
+ * blocked while a file is being compacted: the compacted line is
+ * built and written to a temporary file without the lock, and the
+ * segments appended meanwhile are copied after it before the rename.
+ * If the file was replaced meanwhile, the compaction is dropped.
+ * 
+ */
+
+class SegmentCompactor {
+
+    public:
+        std::function<std::string(const std::string&)> m_compact;
+        std::unordered_map<std::string, uint64_t> m_baseBytes;
+        std::unordered_map<std::string, uint64_t> m_appendedBytes;
+        std::unordered_map<std::string, uint64_t> m_rewrites;
+        std::mutex m_fileMtx;
+
+        std::deque<std::string> m_queue;
+        std::unordered_set<std::string> m_queued;
+        bool m_busy = false;
+        bool m_stop = false;
+        std::atomic<uint64_t> m_compactions{0};
+        std::mutex m_mtx;
+        std::condition_variable m_cv;
+        std::thread m_thread;
+
+        explicit SegmentCompactor(std::function<std::string(const std::string&)> compact);
+        ~SegmentCompactor();
+
+        bool write(const std::string& path, const std::string& segment, bool replace);
+        void schedule(const std::string& path);
+        void waitIdle();
+        void stop();
+
+    private:
+        void compactLoop();
+        bool compact(const std::string& path);
+};
+
+#endif // SEGMENTCOMPACTOR_H
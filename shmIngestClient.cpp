@@ -0,0 +1,39 @@
+#include <chrono>
+#include <thread>
+
+#include "shmIngestClient.h"
+
+bool ShmIngestClient::connect(const std::string& name) {
+    return m_ring.open(name);
+}
+
+/**
+ * @brief Push one sample. Returns false if the ring was full and wait is
+ * false, or if it stayed full for m_waitTimeoutMs or was closed.
+ */
+
+bool ShmIngestClient::push(uint16_t id, Timestamp timestamp, double value, bool wait) {
+    ShmRecord record{timestamp, value, id, 0, 0};
+    if (!m_ring.tryPush(record)) {
+        m_full++;
+        if (!wait) return false;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_waitTimeoutMs);
+        while (!m_ring.tryPush(record)) {
+            if (m_ring.closed() || std::chrono::steady_clock::now() >= deadline) {
+                m_timedOut++;
+                return false;
+            }
+            std::this_thread::yield();
+        }
+    }
+    m_pushed++;
+    return true;
+}
+
+/**
+ * @brief Tell the endpoint that no more samples are coming (last producer only).
+ */
+
+void ShmIngestClient::closeEndpoint() {
+    m_ring.close();
+}
@@ -0,0 +1,44 @@
+#ifndef SHMINGESTCLIENT_H
+#define SHMINGESTCLIENT_H
+
+#include <cstdint>
+#include <string>
+
+#include "shmRing.h"
+#include "timestamp.h"
+
+/**
+ * @class ShmIngestClient
+ * 
+ * @brief Client library for external producer processes.
+ * 
+ * Connects to the ring of a ShmIngestEndpoint by name and pushes
+ * samples (channel id, timestamp, value) as fixed binary records,
+ * without any syscall unless the collector side is asleep. When the
+ * ring is full, push() either spins (yielding) until there is room or
+ * gives up, and m_full counts how many times the ring was found full.
+ * The spin is bounded: it gives up once the ring is closed or after
+ * m_waitTimeoutMs (counted in m_timedOut), so a stalled endpoint
+ * doesn't hang the producer.
+ * 
+ */
+
+class ShmIngestClient {
+
+    public:
+        static constexpr int kDefaultWaitTimeoutMs = 10000;
+
+        ShmRing m_ring;
+        int m_waitTimeoutMs = kDefaultWaitTimeoutMs;
+        uint64_t m_pushed = 0;
+        uint64_t m_full = 0;
+        uint64_t m_timedOut = 0;
+
+        ShmIngestClient() = default;
+
+        bool connect(const std::string& name);
+        bool push(uint16_t id, Timestamp timestamp, double value, bool wait = true);
+        void closeEndpoint();
+};
+
+#endif // SHMINGESTCLIENT_H
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <thread>
+
+#include "shmIngestEndpoint.h"
+
+bool ShmIngestEndpoint::create(const std::string& name, size_t capacity) {
+    return m_ring.create(name, capacity);
+}
+
+/**
+ * @brief Move the records from the ring to the DataQueue until stopped.
+ * 
+ * @return uint64_t number of records received
+ * 
+ * @details Sleeps on the ring (futex) when it is empty, with a short
+ * timeout so that stop() is noticed. When draining, waits for the
+ * positions already claimed, so the records behind the slot of a dead
+ * producer are delivered once the ring skips it.
+ */
+
+uint64_t ShmIngestEndpoint::run(DataQueue& dataQueue) {
+    std::vector<ShmRecord> records(kBatchSize);
+    std::vector<DataInput> batch;
+    batch.reserve(kBatchSize);
+
+    while (!m_stop.load() && !m_ring.closed()) {
+        if (forward(dataQueue, records, batch) == 0) m_ring.waitForData(kWaitTimeoutMs);
+    }
+    for (;;) {
+        if (forward(dataQueue, records, batch) > 0) continue;
+        if (!m_ring.claimed()) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    dataQueue.close();
+    return m_received.load();
+}
+
+void ShmIngestEndpoint::stop() {
+    m_stop.store(true);
+}
+
+size_t ShmIngestEndpoint::forward(DataQueue& dataQueue, std::vector<ShmRecord>& records, std::vector<DataInput>& batch) {
+    size_t count = m_ring.popBatch(records.data(), records.size());
+    if (count == 0) return 0;
+
+    batch.clear();
+    for (size_t i = 0; i < count; i++) {
+        const ShmRecord& record = records[i];
+        if (record.m_id >= m_names.size()) {
+            for (size_t id = m_names.size(); id <= record.m_id; id++) {
+                m_names.push_back("Sensor_" + std::to_string(id));
+                m_units.push_back("Unit_" + std::to_string(id));
+            }
+        }
+        batch.emplace_back(record.m_id, m_names[record.m_id], m_units[record.m_id], DataPoint(record.m_timestamp, record.m_value));
+    }
+    dataQueue.pushBatch(batch);
+    m_received += count;
+    return count;
+}
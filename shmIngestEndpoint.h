@@ -0,0 +1,53 @@
+#ifndef SHMINGESTENDPOINT_H
+#define SHMINGESTENDPOINT_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dataInput.h"
+#include "dataQueue.h"
+#include "shmRing.h"
+
+/**
+ * @class ShmIngestEndpoint
+ * 
+ * @brief Shared-memory ingest endpoint feeding a DataQueue.
+ * 
+ * Creates the named ring that external processes push into (see
+ * ShmIngestClient) and, in run(), moves the records into the DataQueue
+ * in batches as DataInputs, so the usual collectors store them. Channel
+ * names and units follow the generator's convention (Sensor_<id>,
+ * Unit_<id>). run() returns once stop() was called or a client closed
+ * the ring, after draining what was already pushed, and closes the
+ * DataQueue. The slot claimed by a producer that died mid-push is
+ * skipped by the ring after its stuck timeout (counted in
+ * m_ring.m_skipped), so the other producers' records keep flowing.
+ * 
+ */
+
+class ShmIngestEndpoint {
+
+    public:
+        static constexpr size_t kDefaultCapacity = 1 << 16;
+        static constexpr size_t kBatchSize = 4096;
+        static constexpr int kWaitTimeoutMs = 10;
+
+        ShmRing m_ring;
+        std::atomic<bool> m_stop{false};
+        std::atomic<uint64_t> m_received{0};
+        std::vector<std::string> m_names;
+        std::vector<std::string> m_units;
+
+        ShmIngestEndpoint() = default;
+
+        bool create(const std::string& name, size_t capacity = kDefaultCapacity);
+        uint64_t run(DataQueue& dataQueue);
+        void stop();
+
+    private:
+        size_t forward(DataQueue& dataQueue, std::vector<ShmRecord>& records, std::vector<DataInput>& batch);
+};
+
+#endif // SHMINGESTENDPOINT_H
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+#include "shmRing.h"
+
+static_assert(sizeof(ShmRecord) == 24, "ShmRecord is a fixed binary format");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring needs lock-free atomics");
+
+ShmRing::~ShmRing() {
+    unmap();
+}
+
+/**
+ * @brief Create (or replace) the named segment with room for capacity records.
+ * 
+ * @details The capacity is rounded up to a power of two.
+ */
+
+bool ShmRing::create(const std::string& name, size_t capacity) {
+#if defined(__unix__) || defined(__APPLE__)
+    size_t slots = 1;
+    while (slots < capacity) slots <<= 1;
+    size_t size = sizeof(ShmRingHeader) + slots * sizeof(ShmSlot);
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Error creating shared memory segment: " << name << std::endl;
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    if (!map(fd, size)) return false;
+    m_name = name;
+    m_owner = true;
+
+    new (m_header) ShmRingHeader();
+    m_header->m_capacity = slots;
+    m_header->m_closed.store(0);
+    m_header->m_head.store(0);
+    m_header->m_tail.store(0);
+    m_header->m_waiting.store(0);
+    m_header->m_wakeups.store(0);
+    m_slots = reinterpret_cast<ShmSlot*>(m_header + 1);
+    for (size_t i = 0; i < slots; i++) {
+        new (&m_slots[i]) ShmSlot();
+        m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+    }
+    m_mask = slots - 1;
+    m_header->m_version = kVersion;
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->m_magic = kMagic;
+    return true;
+#else
+    (void) name;
+    (void) capacity;
+    std::cerr << "Shared memory ingest is not available on this system" << std::endl;
+    return false;
+#endif
+}
+
+/**
+ * @brief Open a segment created by the consumer.
+ */
+
+bool ShmRing::open(const std::string& name) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ShmRingHeader)) {
+        std::cerr << "Error opening shared memory segment: " << name << std::endl;
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    if (!map(fd, static_cast<size_t>(info.st_size))) return false;
+    m_name = name;
+    m_owner = false;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_header->m_magic != kMagic || m_header->m_version != kVersion ||
+        sizeof(ShmRingHeader) + m_header->m_capacity * sizeof(ShmSlot) > m_mappedSize) {
+        std::cerr << "Invalid shared memory segment: " << name << std::endl;
+        unmap();
+        return false;
+    }
+    m_slots = reinterpret_cast<ShmSlot*>(m_header + 1);
+    m_mask = m_header->m_capacity - 1;
+    return true;
+#else
+    (void) name;
+    std::cerr << "Shared memory ingest is not available on this system" << std::endl;
+    return false;
+#endif
+}
+
+bool ShmRing::map(int fd, size_t size) {
+#if defined(__unix__) || defined(__APPLE__)
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        std::cerr << "Error mapping shared memory segment" << std::endl;
+        return false;
+    }
+    m_header = static_cast<ShmRingHeader*>(address);
+    m_mappedSize = size;
+    return true;
+#else
+    (void) fd;
+    (void) size;
+    return false;
+#endif
+}
+
+void ShmRing::unmap() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (m_header != nullptr) munmap(m_header, m_mappedSize);
+    if (m_owner) shm_unlink(m_name.c_str());
+#endif
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_mappedSize = 0;
+    m_owner = false;
+}
+
+bool ShmRing::valid() const {
+    return m_header != nullptr;
+}
+
+/**
+ * @brief Append a record (any producer). Returns false if the ring is full.
+ * 
+ * @details Claims a position with a CAS on the head, marks the slot as
+ * being written, writes the record and publishes it through the slot's
+ * sequence number. If the consumer skipped the slot in the meantime,
+ * claims the next free position. Only wakes the consumer (syscall)
+ * when it announced it's going to sleep.
+ */
+
+bool ShmRing::tryPush(const ShmRecord& record) {
+    for (;;) {
+        uint64_t position = m_header->m_head.load(std::memory_order_relaxed);
+        ShmSlot* slot;
+        for (;;) {
+            slot = &m_slots[position & m_mask];
+            uint64_t sequence = slot->m_sequence.load(std::memory_order_acquire);
+            int64_t difference = static_cast<int64_t>(sequence & ~kWriting) - static_cast<int64_t>(position);
+            if (difference == 0 && (sequence & kWriting) == 0) {
+                if (m_header->m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = m_header->m_head.load(std::memory_order_relaxed);
+            }
+        }
+        uint64_t expected = position;
+        if (!slot->m_sequence.compare_exchange_strong(expected, position | kWriting, std::memory_order_acquire)) continue;
+        slot->m_record = record;
+        expected = position | kWriting;
+        if (slot->m_sequence.compare_exchange_strong(expected, position + 1, std::memory_order_release)) break;
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_header->m_waiting.load(std::memory_order_relaxed) != 0) wake();
+    return true;
+}
+
+/**
+ * @brief Take up to maxRecords published records, in order (consumer only).
+ * 
+ * @details A slot at the tail that stays claimed but unpublished for
+ * m_stuckTimeoutMs (its producer died) is freed for the next lap and
+ * skipped, so the records behind it are still delivered.
+ */
+
+size_t ShmRing::popBatch(ShmRecord* out, size_t maxRecords) {
+    uint64_t tail = m_header->m_tail.load(std::memory_order_relaxed);
+    size_t count = 0;
+    while (count < maxRecords) {
+        ShmSlot& slot = m_slots[tail & m_mask];
+        uint64_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+        if (sequence == tail + 1) {
+            out[count++] = slot.m_record;
+            slot.m_sequence.store(tail + m_header->m_capacity, std::memory_order_release);
+            tail++;
+            continue;
+        }
+        if ((sequence & ~kWriting) != tail || m_header->m_head.load(std::memory_order_relaxed) <= tail) break;
+
+        // Claimed but not published: skip it once it has been stuck for the timeout
+        auto now = std::chrono::steady_clock::now();
+        if (m_stuckPosition != tail) {
+            m_stuckPosition = tail;
+            m_stuckSince = now;
+            break;
+        }
+        if (now - m_stuckSince < std::chrono::milliseconds(m_stuckTimeoutMs)) break;
+        if (slot.m_sequence.compare_exchange_strong(sequence, tail + m_header->m_capacity, std::memory_order_acq_rel)) {
+            m_skipped++;
+            tail++;
+        }
+    }
+    m_header->m_tail.store(tail, std::memory_order_relaxed);
+    return count;
+}
+
+bool ShmRing::empty() const {
+    uint64_t tail = m_header->m_tail.load(std::memory_order_relaxed);
+    return m_slots[tail & m_mask].m_sequence.load(std::memory_order_acquire) != tail + 1;
+}
+
+/**
+ * @brief Whether positions were claimed that the consumer hasn't taken yet (consumer only).
+ */
+
+bool ShmRing::claimed() const {
+    return m_header->m_head.load(std::memory_order_relaxed) != m_header->m_tail.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sleep until a record is published, the ring is closed or the timeout expires (consumer only).
+ * 
+ * @return true if there are records to pop
+ */
+
+bool ShmRing::waitForData(int timeoutMs) {
+    uint32_t wakeups = m_header->m_wakeups.load(std::memory_order_acquire);
+    m_header->m_waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (empty() && !closed()) {
+#if defined(__linux__)
+        timespec timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->m_wakeups), FUTEX_WAIT, wakeups, &timeout, nullptr, 0);
+#else
+        (void) wakeups;
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeoutMs, 1)));
+#endif
+    }
+    m_header->m_waiting.store(0, std::memory_order_relaxed);
+    return !empty();
+}
+
+void ShmRing::wake() {
+    m_header->m_wakeups.fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->m_wakeups), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+}
+
+/**
+ * @brief Tell the consumer that no more records will be pushed.
+ */
+
+void ShmRing::close() {
+    m_header->m_closed.store(1, std::memory_order_release);
+    wake();
+}
+
+bool ShmRing::closed() const {
+    return m_header->m_closed.load(std::memory_order_acquire) != 0;
+}
@@ -0,0 +1,123 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Fixed binary record exchanged through the shared-memory ring (24 bytes).
+ */
+
+struct ShmRecord {
+    int64_t m_timestamp; // nanoseconds
+    double m_value;
+    uint16_t m_id;
+    uint16_t m_flags;
+    uint32_t m_reserved;
+};
+
+/**
+ * @brief Slot of the ring: the record and its sequence number.
+ * 
+ * Slot i starts with sequence i. A producer that claimed position p
+ * marks the slot p | kWriting, writes the record and publishes it with
+ * sequence p + 1; the consumer reads it and frees the slot for
+ * position p + capacity. Both steps are CASes, so a producer whose
+ * slot was skipped by the consumer in between (see ShmRing::popBatch)
+ * notices it and claims another position.
+ */
+
+struct ShmSlot {
+    std::atomic<uint64_t> m_sequence;
+    ShmRecord m_record;
+};
+
+/**
+ * @brief Header at the start of the shared-memory segment.
+ * 
+ * The producer and consumer positions live on separate cache lines.
+ * m_waiting is set by the consumer before it sleeps on m_wakeups (a
+ * futex word), so producers only make a syscall when it's needed.
+ */
+
+struct ShmRingHeader {
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint64_t m_capacity;
+    std::atomic<uint32_t> m_closed;
+    alignas(64) std::atomic<uint64_t> m_head;
+    alignas(64) std::atomic<uint64_t> m_tail;
+    alignas(64) std::atomic<uint32_t> m_waiting;
+    std::atomic<uint32_t> m_wakeups;
+};
+
+/**
+ * @class ShmRing
+ * 
+ * @brief Multi-producer / single-consumer ring of ShmRecords in POSIX shared memory.
+ * 
+ * The consumer process create()s the named segment, producer processes
+ * open() it. Pushing and popping only use atomics on the shared mapping
+ * (bounded MPSC queue with per-slot sequence numbers), so the fast path
+ * makes no syscall. When the ring is empty the consumer sleeps in
+ * waitForData() on a futex (Linux) and the next push wakes it up; on
+ * other systems it polls. The creator unlinks the segment when it is
+ * destroyed. Not available outside of POSIX systems (create / open fail).
+ * 
+ * A producer that dies between claiming a position and publishing it
+ * would block the consumer forever: once the slot at the tail has been
+ * claimed but unpublished for m_stuckTimeoutMs, popBatch skips it
+ * (counted in m_skipped) and goes on with the records behind it. The
+ * timeout must be well above the time a live producer can be
+ * descheduled while writing its 24 bytes record.
+ * 
+ */
+
+class ShmRing {
+
+    public:
+        static constexpr uint32_t kMagic = 0x53484d52; // "SHMR"
+        static constexpr uint32_t kVersion = 2;
+        static constexpr uint64_t kWriting = uint64_t(1) << 63;
+        static constexpr int kDefaultStuckTimeoutMs = 1000;
+
+        std::string m_name;
+        ShmRingHeader* m_header = nullptr;
+        ShmSlot* m_slots = nullptr;
+        size_t m_mappedSize = 0;
+        uint64_t m_mask = 0;
+        bool m_owner = false;
+        // Consumer only
+        int m_stuckTimeoutMs = kDefaultStuckTimeoutMs;
+        uint64_t m_skipped = 0;
+
+        ShmRing() = default;
+        ShmRing(const ShmRing&) = delete;
+        ShmRing& operator=(const ShmRing&) = delete;
+        ~ShmRing();
+
+        bool create(const std::string& name, size_t capacity);
+        bool open(const std::string& name);
+        void unmap();
+        bool valid() const;
+
+        bool tryPush(const ShmRecord& record);
+        size_t popBatch(ShmRecord* out, size_t maxRecords);
+        bool empty() const;
+        bool claimed() const;
+        bool waitForData(int timeoutMs);
+        void close();
+        bool closed() const;
+
+    private:
+        uint64_t m_stuckPosition = UINT64_MAX;
+        std::chrono::steady_clock::time_point m_stuckSince;
+
+        bool map(int fd, size_t size);
+        void wake();
+};
+
+#endif // SHMRING_H
@@ -0,0 +1,477 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "snapshotFunctions.h"
+
+namespace {
+
+constexpr size_t kCopyRows = 64 * 1024;
+
+template <typename T>
+void put(std::vector<char>& out, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T get(const char*& in) {
+    T value;
+    std::memcpy(&value, in, sizeof(T));
+    in += sizeof(T);
+    return value;
+}
+
+void putEntry(std::vector<char>& out, const SnapshotPiece& piece) {
+    put(out, piece.m_id);
+    put(out, static_cast<uint8_t>(piece.m_encoding.m_codec));
+    put(out, uint8_t(0));
+    put(out, static_cast<uint16_t>(piece.m_name.size()));
+    put(out, static_cast<uint16_t>(piece.m_unit.size()));
+    put(out, piece.m_encoding.m_scale);
+    put(out, piece.m_encoding.m_offset);
+    put(out, piece.m_start);
+    put(out, piece.m_count);
+    put(out, piece.m_firstTimestamp);
+    put(out, piece.m_lastTimestamp);
+    put(out, piece.m_dataOffset);
+    out.insert(out.end(), piece.m_name.begin(), piece.m_name.end());
+    out.insert(out.end(), piece.m_unit.begin(), piece.m_unit.end());
+}
+
+/**
+ * @brief Write the header (at the start of the file) and the directory (at position).
+ */
+
+void finishFile(std::ofstream& file, uint64_t logSequence, uint64_t position, uint32_t channelCount,
+    const std::vector<char>& directoryBytes)
+{
+    file.write(directoryBytes.data(), directoryBytes.size());
+    std::vector<char> headerBytes(kSnapshotMagic, kSnapshotMagic + 8);
+    put(headerBytes, logSequence);
+    put(headerBytes, position);
+    put(headerBytes, channelCount);
+    put(headerBytes, static_cast<uint32_t>(directoryBytes.size()));
+    file.seekp(0);
+    file.write(headerBytes.data(), headerBytes.size());
+    file.close();
+}
+
+} // namespace
+
+std::string snapshotPath(const std::string& directory, uint64_t sequence) {
+    return (std::filesystem::path(directory) / ("snapshot_" + std::to_string(sequence) + ".bin")).string();
+}
+
+/**
+ * @brief Sequences of the snapshot files in a directory, in increasing order.
+ */
+
+std::vector<uint64_t> snapshotSequences(const std::string& directory) {
+    std::vector<uint64_t> result;
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        std::string name = file.path().filename().string();
+        if (name.rfind("snapshot_", 0) != 0 || file.path().extension() != ".bin") continue;
+        result.push_back(std::stoull(name.substr(9, name.size() - 13)));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @brief Snapshot - Persistence storage
+ *
+ * @details Copying the rows of every channel added since its snapshot
+ * watermark (late datapoints merged first), for the snapshot followed
+ * by the log of the given sequence, and moving the watermarks to the
+ * end of the channels. Must be called with the channels lock held;
+ * the copy can then be written without it.
+ */
+
+SnapshotDelta captureSnapshot(std::unordered_map<uint16_t, DataChannel>& channels, uint64_t logSequence) {
+    SnapshotDelta delta;
+    delta.m_logSequence = logSequence;
+
+    std::vector<uint16_t> ids;
+    size_t rows = 0;
+    for (auto& pair : channels) {
+        pair.second.mergeLate();
+        if (pair.second.m_snapshotted < pair.second.size()) {
+            ids.push_back(pair.first);
+            rows += pair.second.size() - pair.second.m_snapshotted;
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    delta.m_timestamps.resize(rows);
+    delta.m_values.resize(rows);
+
+    size_t row = 0;
+    for (uint16_t id : ids) {
+        DataChannel& channel = channels[id];
+        size_t start = channel.m_snapshotted;
+
+        SnapshotPiece piece;
+        piece.m_id = channel.m_id;
+        piece.m_name = channel.m_name;
+        piece.m_unit = channel.m_unit;
+        piece.m_encoding = channel.m_values.m_encoding;
+        piece.m_start = start;
+        piece.m_count = channel.size() - start;
+        piece.m_firstTimestamp = channel.timestampAt(start);
+        piece.m_lastTimestamp = channel.timestampAt(channel.size() - 1);
+        channel.m_timestamps.decode(start, channel.size(), delta.m_timestamps.data() + row);
+        channel.m_values.decode(start, channel.size(), delta.m_values.data() + row);
+        row += piece.m_count;
+        channel.m_snapshotted = channel.size();
+        delta.m_pieces.push_back(std::move(piece));
+    }
+    return delta;
+}
+
+/**
+ * @brief Snapshot - Persistence storage
+ *
+ * @details Writing captured rows to the snapshot file of their log
+ * sequence: a temporary file, fsynced and renamed (the caller fsyncs
+ * the directory). Needs no channel lock.
+ *
+ * @param bytesWritten if not null, receives the size of the file
+ */
+
+bool writeSnapshot(const SnapshotDelta& delta, const std::string& directory, uint64_t* bytesWritten) {
+    std::filesystem::create_directories(directory);
+    std::string path = snapshotPath(directory, delta.m_logSequence);
+    std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    char header[kSnapshotHeaderSize] = {};
+    file.write(header, sizeof(header));
+    uint64_t position = kSnapshotHeaderSize;
+
+    std::vector<char> directoryBytes;
+    size_t row = 0;
+    for (const SnapshotPiece& piece : delta.m_pieces) {
+        SnapshotPiece entry = piece;
+        entry.m_dataOffset = position;
+        putEntry(directoryBytes, entry);
+        file.write(reinterpret_cast<const char*>(delta.m_timestamps.data() + row), piece.m_count * sizeof(Timestamp));
+        file.write(reinterpret_cast<const char*>(delta.m_values.data() + row), piece.m_count * sizeof(double));
+        row += piece.m_count;
+        position += piece.m_count * (sizeof(Timestamp) + sizeof(double));
+    }
+    finishFile(file, delta.m_logSequence, position, static_cast<uint32_t>(delta.m_pieces.size()), directoryBytes);
+
+    std::error_code error;
+    if (file.fail() || !syncPath(temporary)) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) return false;
+    if (bytesWritten != nullptr) *bytesWritten = position + directoryBytes.size();
+    return true;
+}
+
+/**
+ * @brief Move the snapshot watermarks back to the first rows of a delta that wasn't written.
+ *
+ * @details Must be called with the channels lock held. Channels
+ * truncated since the capture keep their (lower) watermark.
+ */
+
+void restoreSnapshotted(std::unordered_map<uint16_t, DataChannel>& channels, const SnapshotDelta& delta) {
+    for (const SnapshotPiece& piece : delta.m_pieces) {
+        auto it = channels.find(piece.m_id);
+        if (it == channels.end()) continue;
+        it->second.m_snapshotted = std::min<size_t>(it->second.m_snapshotted, piece.m_start);
+    }
+}
+
+/**
+ * @brief Snapshot - Persistence storage
+ *
+ * @details Capturing and writing the rows added since the snapshot
+ * watermarks in one call, with the watermarks moved back if the write
+ * fails.
+ *
+ * @param bytesWritten if not null, receives the size of the file
+ */
+
+bool saveSnapshot(std::unordered_map<uint16_t, DataChannel>& channels, const std::string& directory,
+    uint64_t logSequence, uint64_t* bytesWritten)
+{
+    SnapshotDelta delta = captureSnapshot(channels, logSequence);
+    if (writeSnapshot(delta, directory, bytesWritten)) return true;
+    restoreSnapshotted(channels, delta);
+    return false;
+}
+
+/**
+ * @brief Read the header and the directory of a snapshot file.
+ *
+ * @return false if the file is not a complete snapshot
+ */
+
+bool readSnapshotDirectory(std::istream& file, uint64_t& logSequence, std::vector<SnapshotPiece>& pieces,
+    uint64_t& bytesRead)
+{
+    char header[kSnapshotHeaderSize];
+    if (!file.read(header, sizeof(header)) || std::memcmp(header, kSnapshotMagic, 8) != 0) return false;
+    const char* in = header + 8;
+    logSequence = get<uint64_t>(in);
+    uint64_t directoryOffset = get<uint64_t>(in);
+    uint32_t channelCount = get<uint32_t>(in);
+    uint32_t directorySize = get<uint32_t>(in);
+
+    std::vector<char> directory(directorySize);
+    file.seekg(directoryOffset);
+    if (!file.read(directory.data(), directory.size())) return false;
+    bytesRead += sizeof(header) + directory.size();
+
+    in = directory.data();
+    const char* end = directory.data() + directory.size();
+    for (uint32_t i = 0; i < channelCount && in + kSnapshotEntrySize <= end; i++) {
+        SnapshotPiece piece;
+        piece.m_id = get<uint16_t>(in);
+        ValueCodec codec = static_cast<ValueCodec>(get<uint8_t>(in));
+        get<uint8_t>(in);
+        uint16_t nameLength = get<uint16_t>(in);
+        uint16_t unitLength = get<uint16_t>(in);
+        double scale = get<double>(in);
+        double offset = get<double>(in);
+        piece.m_encoding = ValueEncoding(codec, scale, offset);
+        piece.m_start = get<uint64_t>(in);
+        piece.m_count = get<uint64_t>(in);
+        piece.m_firstTimestamp = get<Timestamp>(in);
+        piece.m_lastTimestamp = get<Timestamp>(in);
+        piece.m_dataOffset = get<uint64_t>(in);
+        piece.m_valuesOffset = piece.m_dataOffset + piece.m_count * sizeof(Timestamp);
+        if (in + nameLength + unitLength > end) return false;
+        piece.m_name.assign(in, nameLength);
+        piece.m_unit.assign(in + nameLength, unitLength);
+        in += nameLength + unitLength;
+        pieces.push_back(std::move(piece));
+    }
+    return true;
+}
+
+/**
+ * @brief Read rows [first, first + rows) of a piece (either column may be null).
+ */
+
+void readSnapshotRows(std::istream& file, const SnapshotPiece& piece, uint64_t first, size_t rows,
+    Timestamp* timestamps, double* values)
+{
+    if (timestamps != nullptr) {
+        file.seekg(piece.m_dataOffset + first * sizeof(Timestamp));
+        file.read(reinterpret_cast<char*>(timestamps), rows * sizeof(Timestamp));
+    }
+    if (values != nullptr) {
+        file.seekg(piece.m_valuesOffset + first * sizeof(double));
+        file.read(reinterpret_cast<char*>(values), rows * sizeof(double));
+    }
+}
+
+/**
+ * @brief Apply a piece to the chain of pieces of a channel.
+ *
+ * @details The rows from the piece's first row on are replaced: later
+ * pieces are dropped and the last one kept is cut. Pieces in the
+ * chain always start at the first row they store, so the channel's
+ * first timestamp is the first piece's and its last the last piece's.
+ */
+
+void applySnapshotPiece(std::vector<SnapshotPiece>& chain, const SnapshotPiece& piece) {
+    while (!chain.empty() && chain.back().m_start >= piece.m_start) chain.pop_back();
+    if (!chain.empty()) {
+        SnapshotPiece& last = chain.back();
+        last.m_count = std::min(last.m_count, piece.m_start - last.m_start);
+    }
+    chain.push_back(piece);
+}
+
+/**
+ * @brief Snapshot - Persistence storage
+ *
+ * @details Merging the snapshot files up to lastSequence into one
+ * full snapshot, which replaces the file of lastSequence, then
+ * deleting the older ones. Only reads the (immutable) files, so it
+ * can run in the background while the channels are being written. A
+ * crash before the older files are deleted is harmless: the merged
+ * pieces all start at row 0, so applying them last gives the same
+ * channels.
+ */
+
+bool compactSnapshots(const std::string& directory, uint64_t lastSequence) {
+    std::vector<uint64_t> sequences = snapshotSequences(directory);
+    std::vector<std::ifstream> files;
+    std::map<uint16_t, std::vector<SnapshotPiece>> chains;
+    for (uint64_t sequence : sequences) {
+        if (sequence > lastSequence) break;
+        std::ifstream input(snapshotPath(directory, sequence), std::ios::binary);
+        uint64_t logSequence = 0;
+        uint64_t bytesRead = 0;
+        std::vector<SnapshotPiece> pieces;
+        if (!readSnapshotDirectory(input, logSequence, pieces, bytesRead)) return false;
+        for (SnapshotPiece& piece : pieces) {
+            piece.m_file = files.size();
+            applySnapshotPiece(chains[piece.m_id], piece);
+        }
+        files.push_back(std::move(input));
+    }
+    if (files.size() < 2) return true;
+
+    std::string path = snapshotPath(directory, lastSequence);
+    std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    char header[kSnapshotHeaderSize] = {};
+    file.write(header, sizeof(header));
+    uint64_t position = kSnapshotHeaderSize;
+
+    std::vector<char> directoryBytes;
+    std::vector<Timestamp> timestamps(kCopyRows);
+    std::vector<double> values(kCopyRows);
+    for (const auto& [id, chain] : chains) {
+        SnapshotPiece merged = chain.back();
+        merged.m_start = 0;
+        merged.m_count = 0;
+        for (const SnapshotPiece& piece : chain) merged.m_count += piece.m_count;
+        merged.m_firstTimestamp = chain.front().m_firstTimestamp;
+        merged.m_dataOffset = position;
+        putEntry(directoryBytes, merged);
+
+        for (const SnapshotPiece& piece : chain) {
+            for (uint64_t first = 0; first < piece.m_count; first += kCopyRows) {
+                size_t rows = static_cast<size_t>(std::min<uint64_t>(kCopyRows, piece.m_count - first));
+                readSnapshotRows(files[piece.m_file], piece, first, rows, timestamps.data(), nullptr);
+                file.write(reinterpret_cast<const char*>(timestamps.data()), rows * sizeof(Timestamp));
+            }
+        }
+        for (const SnapshotPiece& piece : chain) {
+            for (uint64_t first = 0; first < piece.m_count; first += kCopyRows) {
+                size_t rows = static_cast<size_t>(std::min<uint64_t>(kCopyRows, piece.m_count - first));
+                readSnapshotRows(files[piece.m_file], piece, first, rows, nullptr, values.data());
+                file.write(reinterpret_cast<const char*>(values.data()), rows * sizeof(double));
+            }
+        }
+        position += merged.m_count * (sizeof(Timestamp) + sizeof(double));
+    }
+    for (const std::ifstream& input : files) {
+        if (input.fail()) return false;
+    }
+
+    finishFile(file, lastSequence, position, static_cast<uint32_t>(chains.size()), directoryBytes);
+    if (file.fail() || !syncPath(temporary)) return false;
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error || !syncPath(directory)) return false;
+    for (uint64_t sequence : sequences) {
+        if (sequence < lastSequence) std::filesystem::remove(snapshotPath(directory, sequence), error);
+    }
+    return true;
+}
+
+/**
+ * @brief Snapshot - Persistence storage
+ *
+ * @details Checkpoint, first step: the log moves to its next file and
+ * the rows of the channels changed since the previous checkpoint are
+ * copied for a snapshot followed by that file. Must be called with the
+ * channels lock held, so nothing is logged in between; it only copies
+ * the data stored since the previous checkpoint, the disk is left to
+ * finishCheckpoint.
+ *
+ * @return false if the log couldn't be rotated (nothing captured)
+ */
+
+bool beginCheckpoint(std::unordered_map<uint16_t, DataChannel>& channels, ChannelLog& log, SnapshotDelta& delta) {
+    if (!log.rotate()) {
+        log.m_checkpointFailures++;
+        return false;
+    }
+    delta = captureSnapshot(channels, log.m_sequence);
+    return true;
+}
+
+/**
+ * @brief Snapshot - Persistence storage
+ *
+ * @details Checkpoint, second step (without the channels lock): the
+ * captured rows are written to the snapshot, and the older log files
+ * (now covered by the snapshots) are deleted once the directory is
+ * synced, so the new log file and the snapshot's rename are durable
+ * first. Once the deltas written since the last compaction add up to
+ * the size of the base, the chain is compacted by a background task
+ * (one at a time), keeping the total cost linear.
+ *
+ * @return false if the snapshot wasn't written, counted in
+ * m_checkpointFailures: the caller moves the watermarks back
+ * (restoreSnapshotted) and the log files are kept
+ */
+
+bool finishCheckpoint(ChannelLog& log, const SnapshotDelta& delta) {
+    uint64_t bytes = 0;
+    if (!writeSnapshot(delta, log.m_directory, &bytes) || !syncPath(log.m_directory)) {
+        log.m_checkpointFailures++;
+        return false;
+    }
+
+    for (uint64_t sequence : ChannelLog::sequences(log.m_directory)) {
+        if (sequence < delta.m_logSequence) std::filesystem::remove(ChannelLog::path(log.m_directory, sequence));
+    }
+    log.m_checkpoints++;
+
+    if (log.m_baseBytes == 0) log.m_baseBytes = bytes;
+    else log.m_deltaBytes += bytes;
+    bool running = log.m_compaction.valid()
+        && log.m_compaction.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    if (!running && log.m_deltaBytes >= log.m_baseBytes) {
+        if (log.m_compaction.valid()) log.m_compaction.get();
+        log.m_baseBytes += log.m_deltaBytes;
+        log.m_deltaBytes = 0;
+        log.m_compactions++;
+        log.m_compaction = std::async(std::launch::async, compactSnapshots, log.m_directory, delta.m_logSequence);
+    }
+    return true;
+}
+
+/**
+ * @brief Snapshot - Persistence storage
+ *
+ * @details Both steps of a checkpoint in one call, for callers that
+ * own the channels: the watermarks are moved back if it fails.
+ */
+
+bool checkpoint(std::unordered_map<uint16_t, DataChannel>& channels, ChannelLog& log) {
+    SnapshotDelta delta;
+    if (!beginCheckpoint(channels, log, delta)) return false;
+    log.sync();
+    if (finishCheckpoint(log, delta)) return true;
+    restoreSnapshotted(channels, delta);
+    return false;
+}
+
+/**
+ * @brief fsync a file or a directory (to make the entries renamed or created in it durable).
+ */
+
+bool syncPath(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
@@ -0,0 +1,106 @@
+#ifndef SNAPSHOTFUNCTIONS_H
+#define SNAPSHOTFUNCTIONS_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "channelLog.h"
+#include "dataChannel.h"
+#include "timestamp.h"
+#include "valueEncoding.h"
+
+/**
+ * @brief Binary snapshot utility functions.
+ *
+ * @details Snapshots are incremental: every checkpoint writes a file
+ * <dir>/snapshot_<log sequence>.bin with, for each channel changed
+ * since the previous one, only the rows from its snapshot watermark
+ * (DataChannel::m_snapshotted) on, decoded (int64 timestamps, then
+ * double values), followed by a directory with one entry per channel
+ * (id, name, unit, encoding, first row, row count, first / last
+ * timestamp, offset of its columns). Applying the files in sequence
+ * order (truncate the channel to the first row, append the rows)
+ * gives the channels at the last checkpoint, so a checkpoint costs the
+ * data stored since the previous one, not the whole history.
+ *
+ * Once the deltas add up to the size of the base, compactSnapshots
+ * merges the chain into a single full snapshot in the background (the
+ * files are immutable, so this needs no channel lock). The header
+ * gives the directory position and the log sequence the snapshot is
+ * followed by, so a restart only reads the headers, the directories
+ * and the log tail (see RecoveredStore), and the columns are paged in
+ * per channel when queried. Files are written to a temporary file,
+ * fsynced and renamed (and the directory fsynced), so a crash keeps
+ * the previous chain. Only capturing the rows (captureSnapshot) needs
+ * the channels lock: writing them (writeSnapshot) doesn't, and if it
+ * fails the watermarks are moved back (restoreSnapshotted), so the
+ * next checkpoint saves the rows again. A channel truncated
+ * since the previous checkpoint is rewritten from the truncation
+ * point along with its next rows.
+ *
+ * Layout of the header (32 bytes): magic "DCSNAP2", uint64 log
+ * sequence, uint64 directory offset, uint32 channel count, uint32
+ * directory size. Directory entry: uint16 id, uint8 codec, uint8 pad,
+ * uint16 name length, uint16 unit length, double scale, double offset,
+ * uint64 first row, uint64 count, int64 first, int64 last, uint64 data
+ * offset, name, unit.
+ */
+
+constexpr char kSnapshotMagic[8] = {'D', 'C', 'S', 'N', 'A', 'P', '2', 0};
+constexpr size_t kSnapshotHeaderSize = 32;
+constexpr size_t kSnapshotEntrySize = 64; // without name and unit
+
+/**
+ * @brief Rows [m_start, m_start + m_count) of a channel stored in one snapshot file.
+ */
+
+struct SnapshotPiece {
+    uint16_t m_id = 0;
+    std::string m_name;
+    std::string m_unit;
+    ValueEncoding m_encoding;
+    uint64_t m_start = 0;
+    uint64_t m_count = 0;
+    Timestamp m_firstTimestamp = 0;
+    Timestamp m_lastTimestamp = 0;
+    uint64_t m_dataOffset = 0;
+    uint64_t m_valuesOffset = 0; // after the m_count timestamps stored in the file
+    size_t m_file = 0; // index of the file in the chain (set by the reader)
+};
+
+/**
+ * @brief Rows of the channels changed since their snapshot watermark, copied for writing.
+ *
+ * @details The rows of m_pieces[i] follow those of the pieces before it
+ * in m_timestamps and m_values.
+ */
+
+struct SnapshotDelta {
+    uint64_t m_logSequence = 0;
+    std::vector<SnapshotPiece> m_pieces;
+    std::vector<Timestamp> m_timestamps;
+    std::vector<double> m_values;
+};
+
+std::string snapshotPath(const std::string& directory, uint64_t sequence);
+std::vector<uint64_t> snapshotSequences(const std::string& directory);
+SnapshotDelta captureSnapshot(std::unordered_map<uint16_t, DataChannel>& channels, uint64_t logSequence);
+bool writeSnapshot(const SnapshotDelta& delta, const std::string& directory, uint64_t* bytesWritten = nullptr);
+void restoreSnapshotted(std::unordered_map<uint16_t, DataChannel>& channels, const SnapshotDelta& delta);
+bool saveSnapshot(std::unordered_map<uint16_t, DataChannel>& channels, const std::string& directory,
+    uint64_t logSequence, uint64_t* bytesWritten = nullptr);
+bool readSnapshotDirectory(std::istream& file, uint64_t& logSequence, std::vector<SnapshotPiece>& pieces,
+    uint64_t& bytesRead);
+void readSnapshotRows(std::istream& file, const SnapshotPiece& piece, uint64_t first, size_t rows,
+    Timestamp* timestamps, double* values);
+void applySnapshotPiece(std::vector<SnapshotPiece>& chain, const SnapshotPiece& piece);
+bool compactSnapshots(const std::string& directory, uint64_t lastSequence);
+bool beginCheckpoint(std::unordered_map<uint16_t, DataChannel>& channels, ChannelLog& log, SnapshotDelta& delta);
+bool finishCheckpoint(ChannelLog& log, const SnapshotDelta& delta);
+bool checkpoint(std::unordered_map<uint16_t, DataChannel>& channels, ChannelLog& log);
+bool syncPath(const std::string& path);
+
+#endif // SNAPSHOTFUNCTIONS_H
@@ -0,0 +1,107 @@
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "socketFunctions.h"
+
+/**
+ * @brief Bind and listen on a socket file (replacing a stale one).
+ * 
+ * @return int listening socket, -1 on failure
+ */
+
+int listenUnixSocket(const std::string& path, int backlog) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) return -1;
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, backlog) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int acceptUnixSocket(int listenFd) {
+    int fd;
+    do {
+        fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    return fd;
+}
+
+int connectUnixSocket(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) return -1;
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static bool receiveAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+/**
+ * @brief Send one framed message (header and payload).
+ * 
+ * @return false if the payload doesn't fit the 32 bit size (nothing is sent) or the send failed
+ */
+
+bool sendMessage(int fd, uint32_t type, const std::vector<char>& payload) {
+    if (payload.size() > kMaxMessagePayload) return false;
+    char header[kMessageHeaderSize];
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    std::memcpy(header, &type, 4);
+    std::memcpy(header + 4, &size, 4);
+    return sendAll(fd, header, sizeof(header)) && sendAll(fd, payload.data(), payload.size());
+}
+
+/**
+ * @brief Receive one framed message. False when the peer closed the socket.
+ */
+
+bool receiveMessage(int fd, uint32_t& type, std::vector<char>& payload) {
+    char header[kMessageHeaderSize];
+    if (!receiveAll(fd, header, sizeof(header))) return false;
+    uint32_t size;
+    std::memcpy(&type, header, 4);
+    std::memcpy(&size, header + 4, 4);
+    payload.resize(size);
+    return receiveAll(fd, payload.data(), size);
+}
+
+void closeSocket(int fd) {
+    if (fd >= 0) close(fd);
+}
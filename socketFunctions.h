@@ -0,0 +1,44 @@
+#ifndef SOCKETFUNCTIONS_H
+#define SOCKETFUNCTIONS_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Unix domain socket utility functions.
+ * 
+ * @details Stream sockets between local processes, exchanging framed
+ * messages: a header (uint32 type, uint32 payload size) followed by
+ * the payload, so payloads over kMaxMessagePayload bytes are rejected
+ * (sendMessage fails without writing anything) rather than truncated.
+ * Writes never raise SIGPIPE, a closed peer makes them fail instead. appendBytes / readBytes build and parse payloads of
+ * fixed size fields.
+ */
+
+constexpr size_t kMessageHeaderSize = 8;
+constexpr size_t kMaxMessagePayload = UINT32_MAX;
+
+int listenUnixSocket(const std::string& path, int backlog = 16);
+int acceptUnixSocket(int listenFd);
+int connectUnixSocket(const std::string& path);
+bool sendMessage(int fd, uint32_t type, const std::vector<char>& payload);
+bool receiveMessage(int fd, uint32_t& type, std::vector<char>& payload);
+void closeSocket(int fd);
+
+template <typename T>
+void appendBytes(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T readBytes(const char*& at) {
+    T value;
+    std::memcpy(&value, at, sizeof(T));
+    at += sizeof(T);
+    return value;
+}
+
+#endif // SOCKETFUNCTIONS_H
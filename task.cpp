@@ -0,0 +1,49 @@
+#include "task.h"
+
+std::coroutine_handle<> Task::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+    std::coroutine_handle<> continuation = handle.promise().m_continuation;
+    return continuation ? continuation : std::noop_coroutine();
+}
+
+Task Task::promise_type::get_return_object() {
+    return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+void Task::promise_type::unhandled_exception() {
+    m_exception = std::current_exception();
+}
+
+/**
+ * @brief Start the awaited task, resuming the awaiting coroutine when it's done.
+ */
+
+std::coroutine_handle<> Task::Awaiter::await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    m_handle.promise().m_continuation = awaiting;
+    return m_handle;
+}
+
+void Task::Awaiter::await_resume() const {
+    if (m_handle && m_handle.promise().m_exception) std::rethrow_exception(m_handle.promise().m_exception);
+}
+
+Task::Task(std::coroutine_handle<promise_type> handle)
+    : m_handle(handle) {}
+
+Task::Task(Task&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+Task::~Task() {
+    if (m_handle) m_handle.destroy();
+}
+
+Task& Task::operator=(Task&& other) noexcept {
+    if (this != &other) {
+        if (m_handle) m_handle.destroy();
+        m_handle = std::exchange(other.m_handle, nullptr);
+    }
+    return *this;
+}
+
+Task::Awaiter Task::operator co_await() const noexcept {
+    return Awaiter{m_handle};
+}
@@ -0,0 +1,77 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+/**
+ * @class Task
+ * 
+ * @brief Lazily started coroutine, for the asynchronous pipeline stages.
+ * 
+ * A Task only runs when it is co_awaited (the awaiting coroutine is
+ * resumed when it completes, by symmetric transfer, so long chains of
+ * awaits don't grow the stack) or when it is handed to an Executor
+ * with spawn(). Exceptions are rethrown to the awaiting coroutine.
+ * 
+ */
+
+class Task {
+
+    public:
+        class promise_type {
+
+            public:
+                std::coroutine_handle<> m_continuation;
+                std::exception_ptr m_exception;
+
+                struct FinalAwaiter {
+                    bool await_ready() const noexcept { return false; }
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+                    void await_resume() const noexcept {}
+                };
+
+                Task get_return_object();
+                std::suspend_always initial_suspend() const noexcept { return {}; }
+                FinalAwaiter final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept {}
+                void unhandled_exception();
+        };
+
+        struct Awaiter {
+            std::coroutine_handle<promise_type> m_handle;
+
+            bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept;
+            void await_resume() const;
+        };
+
+        std::coroutine_handle<promise_type> m_handle;
+
+        Task() = default;
+        explicit Task(std::coroutine_handle<promise_type> handle);
+        Task(Task&& other) noexcept;
+        ~Task();
+
+        Task& operator=(Task&& other) noexcept;
+        Awaiter operator co_await() const noexcept;
+};
+
+/**
+ * @brief Eagerly started, self-destroying coroutine (used by Executor::spawn).
+ */
+
+class DetachedTask {
+
+    public:
+        struct promise_type {
+            DetachedTask get_return_object() const noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+};
+
+#endif // TASK_H
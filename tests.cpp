@@ -1,14 +1,51 @@
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <queue>
+#include <random>
 #include <thread>
 
 #include <gtest/gtest.h>
 
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "arrowFunctions.h"
+#include "asyncPipeline.h"
+#include "channelLog.h"
+#include "channelQuery.h"
 #include "dataChannel.h"
 #include "dataCollector.h"
 #include "dataInput.h"
 #include "dataPoint.h"
+#include "dataQueue.h"
+#include "deadlineScheduler.h"
 #include "extractedSubChannel.h"
+#include "fixedRateChannel.h"
+#include "generatorConfig.h"
+#include "jitterHistogram.h"
 #include "jsonFunctions.h"
+#include "latestValueTable.h"
+#include "partitionRouter.h"
+#include "pipeline.h"
+#include "pipelineConfig.h"
+#include "queryCache.h"
+#include "recoveredStore.h"
+#include "shmIngestClient.h"
+#include "shmIngestEndpoint.h"
+#include "snapshotFunctions.h"
+#include "timestampColumn.h"
 
 // Create a test suite for the DataPoint class
 TEST(DataPointTest, Constructors) {
@@ -29,17 +66,159 @@ TEST(DataChannelTest, Constructors) {
     ASSERT_EQ(channel1.m_id, 1);
     ASSERT_EQ(channel1.m_name, "Sensor_1");
     ASSERT_EQ(channel1.m_unit, "Unit_1");
-    ASSERT_TRUE(channel1.m_data.empty());
+    ASSERT_TRUE(channel1.empty());
 
     DataPoint dp(1.0, 42.0);
     DataChannel channel2(2, "Sensor_2", "Unit_2");
-    channel2.m_data.push_back(dp);
+    channel2.append(dp);
     ASSERT_EQ(channel2.m_id, 2);
     ASSERT_EQ(channel2.m_name, "Sensor_2");
     ASSERT_EQ(channel2.m_unit, "Unit_2");
-    ASSERT_EQ(channel2.m_data.size(), 1);
-    ASSERT_EQ(channel2.m_data[0].m_timestamp, 1.0);
-    ASSERT_EQ(channel2.m_data[0].m_value, 42.0);
+    ASSERT_EQ(channel2.size(), 1);
+    ASSERT_EQ(channel2.at(0).m_timestamp, 1.0);
+    ASSERT_EQ(channel2.at(0).m_value, 42.0);
+}
+
+// Test suite for the out-of-order tolerant insertion
+TEST(DataChannelTest, LateInsert) {
+
+    DataChannel channel(1, "Sensor_1", "Unit_1");
+    channel.m_maxLateness = 10;
+    ASSERT_TRUE(channel.insert(DataPoint(1.0, 1.0)));
+    ASSERT_TRUE(channel.insert(DataPoint(5.0, 5.0)));
+    ASSERT_TRUE(channel.insert(DataPoint(20.0, 20.0)));
+    ASSERT_TRUE(channel.insert(DataPoint(12.0, 12.0))); // late
+    ASSERT_TRUE(channel.insert(DataPoint(11.0, 11.0))); // late
+    ASSERT_FALSE(channel.insert(DataPoint(2.0, 2.0))); // too late
+    ASSERT_TRUE(channel.insert(DataPoint(15.0, std::nan("")))); // late
+    ASSERT_EQ(channel.size(), 3);
+    ASSERT_EQ(channel.m_late.size(), 3);
+    ASSERT_EQ(channel.m_lateCount, 3);
+    ASSERT_EQ(channel.m_tooLateCount, 1);
+
+    // Queries see the late datapoints before they are merged, without merging them
+    std::unordered_map<uint16_t, DataChannel> channels;
+    channels[1] = std::move(channel);
+    auto subsets = retrieveChannelSubsets(channels, {1}, 4.0, 15.0);
+    ASSERT_EQ(subsets[1].m_timestamps, std::pmr::vector<Timestamp>({5, 11, 12}));
+    ASSERT_EQ(subsets[1].m_values, std::pmr::vector<double>({5.0, 11.0, 12.0}));
+    ASSERT_EQ(subsets[1].m_rangeSize, 4);
+    ASSERT_EQ(subsets[1].m_lateSize, 3);
+    ASSERT_EQ(subsets[1].m_nanCount, 1);
+    std::vector<DataPoint> nanDatapoints = subsets[1].nanDatapoints(channels[1]);
+    ASSERT_EQ(nanDatapoints.size(), 1);
+    ASSERT_EQ(nanDatapoints[0].m_timestamp, 15);
+    ASSERT_EQ(channels[1].size(), 3);
+    ASSERT_EQ(channels[1].m_late.size(), 3);
+    std::filesystem::create_directories("../storage");
+    const std::string latePath = "../storage/channel_test_late.arrow";
+    ASSERT_TRUE(saveChannelArrow(channels[1], latePath, 0, 20));
+    ASSERT_EQ(channels[1].m_late.size(), 3);
+
+    channels[1].mergeLate();
+    ASSERT_TRUE(channels[1].m_late.empty());
+    ASSERT_EQ(channels[1].size(), 6);
+    const std::string mergedPath = "../storage/channel_test_merged.arrow";
+    ASSERT_TRUE(saveChannelArrow(channels[1], mergedPath, 0, 20));
+    std::ifstream lateFile(latePath, std::ios::binary), mergedFile(mergedPath, std::ios::binary);
+    ASSERT_EQ(std::string((std::istreambuf_iterator<char>(lateFile)), std::istreambuf_iterator<char>()),
+        std::string((std::istreambuf_iterator<char>(mergedFile)), std::istreambuf_iterator<char>()));
+    auto merged = retrieveChannelSubsets(channels, {1}, 4.0, 15.0);
+    ASSERT_EQ(merged[1].m_timestamps, subsets[1].m_timestamps);
+    ASSERT_EQ(merged[1].m_nanMask, subsets[1].m_nanMask);
+    ASSERT_TRUE(checkOrder(channels));
+
+    // The side buffer is merged on its own once it reaches the threshold
+    DataChannel busy(2, "Sensor_2", "Unit_2");
+    busy.insert(DataPoint(1000.0, 0.0));
+    for (size_t i = 0; i < DataChannel::kLateMergeThreshold; i++) busy.insert(DataPoint(999.0 - i, 0.0));
+    ASSERT_TRUE(busy.m_late.empty());
+    ASSERT_TRUE(OrderedByTimestamp(busy));
+}
+
+// Test suite for the chunked integer timestamp column
+TEST(DataChannelTest, TimestampChunks) {
+
+    TimestampColumn column;
+    std::vector<Timestamp> timestamps;
+    Timestamp timestamp = 0;
+    for (int i = 0; i < 5000; i++) {
+        // Steps from 1 ns up to 3 s, so some chunks end early on 32 bit offset overflow
+        timestamp += (i % 500 == 0) ? 3000 * kNanosPerMilli : 1 + i % 3;
+        column.push_back(timestamp);
+        timestamps.push_back(timestamp);
+    }
+    ASSERT_EQ(column.size(), timestamps.size());
+    ASSERT_GT(column.m_bases.size(), (timestamps.size() + TimestampColumn::kChunkSize - 1) / TimestampColumn::kChunkSize);
+    for (size_t i = 0; i < timestamps.size(); i++) ASSERT_EQ(column.get(i), timestamps[i]);
+    auto assertChunks = [&]() {
+        ASSERT_EQ(column.m_blockChunks.size(), (column.size() + TimestampColumn::kChunkSize - 1) / TimestampColumn::kChunkSize);
+        for (size_t i = 0; i < column.size(); i++) {
+            size_t chunk = column.chunkOf(i);
+            ASSERT_LE(column.m_starts[chunk], i);
+            ASSERT_LT(i, column.chunkEnd(chunk));
+        }
+    };
+    assertChunks();
+
+    // Bounds match std::lower_bound / std::upper_bound over the plain timestamps
+    std::vector<Timestamp> probes = {-1, 0, timestamps.front(), timestamps.back(), timestamps.back() + 1};
+    for (size_t i = 0; i < timestamps.size(); i += 97) {
+        probes.push_back(timestamps[i]);
+        probes.push_back(timestamps[i] + 1);
+        probes.push_back(timestamps[i] - kNanosPerMilli);
+    }
+    for (Timestamp probe : probes) {
+        ASSERT_EQ(column.lowerBound(probe), std::lower_bound(timestamps.begin(), timestamps.end(), probe) - timestamps.begin());
+        ASSERT_EQ(column.upperBound(probe), std::upper_bound(timestamps.begin(), timestamps.end(), probe) - timestamps.begin());
+    }
+
+    std::vector<Timestamp> decoded(3000);
+    column.decode(1000, 4000, decoded.data());
+    ASSERT_TRUE(std::equal(decoded.begin(), decoded.end(), timestamps.begin() + 1000));
+
+    column.truncate(2500);
+    ASSERT_EQ(column.back(), timestamps[2499]);
+    assertChunks();
+    column.push_back(timestamps[2500]);
+    ASSERT_EQ(column.get(2500), timestamps[2500]);
+    assertChunks();
+    ASSERT_LT(column.memoryBytes(), timestamps.capacity() * sizeof(Timestamp));
+}
+
+// Test suite for the interpolation search of range and point lookups
+TEST(DataChannelTest, InterpolatedLookups) {
+
+    // Jittered 10 ms samples, runs of equal timestamps, then a skewed (quadratic) tail
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<Timestamp> jitter(-200000, 200000);
+    std::vector<Timestamp> timestamps;
+    for (Timestamp i = 0; i < 20000; i++) timestamps.push_back(i * 10 * kNanosPerMilli + jitter(gen));
+    for (int i = 0; i < 50; i++) timestamps.push_back(timestamps.back());
+    for (Timestamp i = 1; i < 3000; i++) timestamps.push_back(timestamps.back() + i * i);
+    std::sort(timestamps.begin(), timestamps.end());
+
+    DataChannel channel(1, "Sensor_1", "Unit_1");
+    for (size_t i = 0; i < timestamps.size(); i++) channel.insert(DataPoint(timestamps[i], double(i)));
+    std::uniform_int_distribution<Timestamp> anywhere(timestamps.front() - 10, timestamps.back() + 10);
+    for (int i = 0; i < 20000; i++) {
+        Timestamp probe = i % 2 == 0 ? anywhere(gen) : timestamps[gen() % timestamps.size()];
+        size_t lower = std::lower_bound(timestamps.begin(), timestamps.end(), probe) - timestamps.begin();
+        size_t upper = std::upper_bound(timestamps.begin(), timestamps.end(), probe) - timestamps.begin();
+        ASSERT_EQ(channel.lowerBound(probe), lower) << probe;
+        ASSERT_EQ(channel.upperBound(probe), upper) << probe;
+        ASSERT_EQ(channel.valueAtTime(probe), upper > 0 ? channel.valueAt(upper - 1) : 0.0) << probe;
+    }
+    ASSERT_TRUE(std::isnan(channel.valueAtTime(timestamps.front() - 1)));
+
+    // Point lookups see late datapoints before they are merged
+    Timestamp last = timestamps.back();
+    channel.insert(DataPoint(last + 100, 1.5));
+    channel.insert(DataPoint(last + 50, 2.5));
+    ASSERT_EQ(channel.m_late.size(), 1);
+    ASSERT_EQ(channel.valueAtTime(last + 60), 2.5);
+    ASSERT_EQ(channel.valueAtTime(last + 49), channel.valueAt(timestamps.size() - 1));
+    ASSERT_EQ(channel.valueAtTime(last + 100), 1.5);
 }
 
 // Test suite for the DataInput class
@@ -59,8 +238,8 @@ TEST(ExtractedSubChannelTest, Constructors) {
     DataChannel channel1(1, "Sensor_1", "Unit_1");
     DataPoint dp1(1.0, 42.0);
     DataPoint dp2(2.0, 43.0);
-    channel1.m_data.push_back(dp1);
-    channel1.m_data.push_back(dp2);
+    channel1.append(dp1);
+    channel1.append(dp2);
 
     ExtractedSubChannel subChannel1(channel1, 2);
     ASSERT_EQ(subChannel1.m_id, 1);
@@ -68,12 +247,13 @@ TEST(ExtractedSubChannelTest, Constructors) {
     ASSERT_EQ(subChannel1.m_unit, "Unit_1");
     ASSERT_TRUE(subChannel1.m_timestamps.empty());
     ASSERT_TRUE(subChannel1.m_values.empty());
-    ASSERT_TRUE(subChannel1.m_nan_dps.empty());
+    ASSERT_EQ(subChannel1.m_nanCount, 0);
+    ASSERT_TRUE(subChannel1.m_nanMask.empty());
 }
 
 // Test suite for the generateDataPoint function
 TEST(GenerateDataPointTest, Basic) {
-    std::queue<DataInput> dataQueue;
+    DataQueue dataQueue;
     generateDataPoint(1.0, dataQueue, 0, 1); // Generate a data point for one channel
     ASSERT_EQ(dataQueue.size(), 1);
     ASSERT_EQ(dataQueue.front().m_dp.m_timestamp, 1.0);
@@ -83,11 +263,155 @@ TEST(GenerateDataPointTest, Basic) {
     ASSERT_EQ(dataQueue.back().m_dp.m_timestamp, 2.0);
 }
 
+// Test suite for the bounded DataQueue overload policies
+TEST(DataQueueTest, DropPolicies) {
+
+    DataQueue dropOldest(100, OverloadPolicy::DropOldest);
+    DataQueue dropNewest(100, OverloadPolicy::DropNewest);
+    for (int i = 0; i < 1000; i++) {
+        dropOldest.push(DataInput(1, "Sensor_1", "Unit_1", DataPoint(i, i)));
+        dropNewest.push(DataInput(1, "Sensor_1", "Unit_1", DataPoint(i, i)));
+    }
+    ASSERT_EQ(dropOldest.size(), 100);
+    ASSERT_EQ(dropOldest.m_dropped, 900);
+    ASSERT_EQ(dropOldest.front().m_dp.m_timestamp, 900.0);
+    ASSERT_EQ(dropNewest.size(), 100);
+    ASSERT_EQ(dropNewest.m_dropped, 900);
+    ASSERT_EQ(dropNewest.back().m_dp.m_timestamp, 99.0);
+    ASSERT_EQ(dropNewest.m_highWater, 100);
+}
+
+TEST(DataQueueTest, Decimate) {
+
+    DataQueue queue(100, OverloadPolicy::Decimate);
+    queue.m_decimationFactor = 4;
+    for (int i = 0; i < 75; i++) queue.push(DataInput(1, "Sensor_1", "Unit_1", DataPoint(i, i)));
+    ASSERT_EQ(queue.m_decimated, 0);
+
+    // Above the high watermark, only 1 out of 4 inputs per channel is kept
+    for (int i = 75; i < 115; i++) queue.push(DataInput(2, "Sensor_2", "Unit_2", DataPoint(i, i)));
+    ASSERT_EQ(queue.size(), 85);
+    ASSERT_EQ(queue.m_decimated, 30);
+    ASSERT_EQ(queue.m_dropped, 0);
+
+    // A factor of 0 keeps every input instead of dividing by zero
+    queue.m_decimationFactor = 0;
+    queue.push(DataInput(3, "Sensor_3", "Unit_3", DataPoint(115, 115)));
+    ASSERT_EQ(queue.size(), 86);
+    ASSERT_EQ(queue.m_decimated, 30);
+}
+
+TEST(DataQueueTest, BlockingBackpressure) {
+
+    DataQueue queue(16, OverloadPolicy::Block);
+    std::thread producer([&] {
+        for (int i = 0; i < 5000; i++) queue.push(DataInput(1, "Sensor_1", "Unit_1", DataPoint(i, i)));
+        queue.close();
+    });
+
+    DataInput input;
+    int received = 0;
+    while (queue.pop(input)) {
+        ASSERT_EQ(input.m_dp.m_timestamp, received);
+        received++;
+    }
+    producer.join();
+    ASSERT_EQ(received, 5000);
+    ASSERT_EQ(queue.m_dropped, 0);
+    ASSERT_LE(queue.m_highWater, 16);
+
+    // A producer blocked on a full queue drops its input when the queue is closed
+    DataQueue full(2, OverloadPolicy::Block);
+    full.push(DataInput(1, "Sensor_1", "Unit_1", DataPoint(0, 0)));
+    full.push(DataInput(1, "Sensor_1", "Unit_1", DataPoint(1, 1)));
+    std::thread blocked([&] { full.push(DataInput(1, "Sensor_1", "Unit_1", DataPoint(2, 2))); });
+    while (full.m_blocked == 0) std::this_thread::yield();
+    full.close();
+    blocked.join();
+    ASSERT_EQ(full.size(), 2);
+    ASSERT_EQ(full.m_dropped, 1);
+}
+
+// Test suite for draining the queue in batches
+TEST(DataQueueTest, PopBatch) {
+
+    DataQueue queue;
+    for (int i = 0; i < 10; i++) queue.push(DataInput(1, "Sensor_1", "Unit_1", DataPoint(i, i)));
+
+    std::deque<DataInput> batch;
+    ASSERT_TRUE(queue.popBatch(batch, 4));
+    ASSERT_EQ(batch.size(), 4);
+    ASSERT_EQ(batch.front().m_dp.m_timestamp, 0.0);
+    ASSERT_TRUE(queue.popBatch(batch));
+    ASSERT_EQ(batch.size(), 6);
+    ASSERT_EQ(batch.front().m_dp.m_timestamp, 4.0);
+    ASSERT_TRUE(queue.empty());
+
+    queue.close();
+    ASSERT_FALSE(queue.popBatch(batch));
+    ASSERT_TRUE(batch.empty());
+}
+
+// Test suite for the configurable generator (unpaced, several producers, fixed seed)
+TEST(DataGeneratorTest, UnpacedDeterministic) {
+
+    GeneratorConfig config;
+    config.m_numChannels = 10;
+    config.m_groupRates = {100.0, 50.0};
+    config.m_duration = 1000.0;
+    config.m_seed = 42;
+    config.m_producerThreads = 2;
+    config.m_paced = false;
+
+    DataQueue queue1;
+    DataQueue queue2;
+    ASSERT_EQ(dataGenerator(queue1, config), 5 * 100 + 5 * 50);
+    ASSERT_EQ(dataGenerator(queue2, config), 5 * 100 + 5 * 50);
+    ASSERT_EQ(queue1.size(), queue2.size());
+
+    // Producers interleave in the queue, but each channel is generated identically
+    std::unordered_map<uint16_t, DataChannel> channels1;
+    std::unordered_map<uint16_t, DataChannel> channels2;
+    dataCollector(queue1, channels1);
+    dataCollector(queue2, channels2);
+    ASSERT_EQ(channels1.size(), 10);
+    ASSERT_EQ(channels1[0].size(), 100);
+    ASSERT_EQ(channels1[9].size(), 50);
+    ASSERT_EQ(channels1[9].at(1).m_timestamp, fromMilliseconds(30.0));
+    for (auto& pair : channels1) {
+        const auto& data1 = pair.second;
+        const auto& data2 = channels2[pair.first];
+        ASSERT_EQ(data1.size(), data2.size());
+        for (size_t i = 0; i < data1.size(); i++) {
+            ASSERT_EQ(data1.at(i).m_timestamp, data2.at(i).m_timestamp);
+            ASSERT_TRUE(std::isnan(data1.at(i).m_value) ? std::isnan(data2.at(i).m_value) : data1.at(i).m_value == data2.at(i).m_value);
+        }
+    }
+
+    // Configs without groups or with a non positive rate are rejected, and generate nothing
+    ASSERT_TRUE(config.valid());
+    GeneratorConfig empty = config;
+    empty.m_groupRates.clear();
+    ASSERT_FALSE(empty.valid());
+    ASSERT_EQ(empty.maxRate(), 0.0);
+    ASSERT_EQ(empty.channelRate(3), 0.0);
+    GeneratorConfig zero = config;
+    zero.m_channelRates = {100.0, 0.0};
+    ASSERT_FALSE(zero.valid());
+    GeneratorConfig negative = config;
+    negative.m_groupRates = {100.0, -50.0};
+    ASSERT_FALSE(negative.valid());
+    DataQueue rejected;
+    ASSERT_EQ(dataGenerator(rejected, empty), 0);
+    ASSERT_TRUE(rejected.closed());
+    ASSERT_EQ(rejected.size(), 0);
+}
+
 // Test suite for the main functionality (generation + collection) - sequential
 TEST(GenerateAndCollectTest, Basic) {
 
     std::unordered_map<uint16_t, DataChannel> channels;
-    std::queue<DataInput> dataQueue;
+    DataQueue dataQueue;
 
     dataGenerator(dataQueue);
     ASSERT_GT(dataQueue.size(), 0);
@@ -97,29 +421,658 @@ TEST(GenerateAndCollectTest, Basic) {
 
 }
 
+// Test suite for the drain-all collector, against the one-by-one collector
+TEST(GenerateAndCollectTest, Batched) {
+
+    GeneratorConfig config;
+    config.m_duration = 2000.0;
+    config.m_seed = 7;
+    config.m_paced = false;
+
+    DataQueue queue1;
+    DataQueue queue2;
+    dataGenerator(queue1, config);
+    dataGenerator(queue2, config);
+
+    std::unordered_map<uint16_t, DataChannel> channels1;
+    std::unordered_map<uint16_t, DataChannel> channels2;
+    dataCollector(queue1, channels1);
+    dataCollectorBatched(queue2, channels2, 1000);
+    ASSERT_TRUE(queue2.empty());
+    ASSERT_TRUE(checkOrder(channels2));
+    ASSERT_EQ(channels1.size(), channels2.size());
+    for (auto& pair : channels1) {
+        ASSERT_EQ(pair.second.m_name, channels2[pair.first].m_name);
+        ASSERT_EQ(pair.second.size(), channels2[pair.first].size());
+        ASSERT_EQ(pair.second.at(pair.second.size() - 1).m_timestamp, channels2[pair.first].at(channels2[pair.first].size() - 1).m_timestamp);
+    }
+}
+
+// Test suite for the per-core pipeline (routing by channel shard)
+TEST(PipelineTest, Partitioned) {
+
+    GeneratorConfig generatorConfig;
+    generatorConfig.m_numChannels = 20;
+    generatorConfig.m_groupRates = {100.0, 10.0};
+    generatorConfig.m_duration = 5000.0;
+    generatorConfig.m_seed = 3;
+    generatorConfig.m_producerThreads = 2;
+    generatorConfig.m_paced = false;
+
+    PipelineConfig pipelineConfig;
+    pipelineConfig.m_numShards = 3;
+    pipelineConfig.m_queueCapacity = 64;
+    ASSERT_EQ(pipelineConfig.shardOf(7), 1);
+
+    std::unordered_map<uint16_t, DataChannel> channels;
+    PipelineReport report = runPipeline(generatorConfig, pipelineConfig, channels);
+    ASSERT_EQ(report.m_generated, 10 * 500 + 10 * 50);
+    ASSERT_EQ(report.m_cacheMisses.size(), 3);
+    ASSERT_EQ(channels.size(), 20);
+    ASSERT_EQ(channels[0].size(), 500);
+    ASSERT_EQ(channels[19].size(), 50);
+    ASSERT_EQ(channels[19].m_name, "Sensor_19");
+    ASSERT_TRUE(checkOrder(channels));
+}
+
+// Test suite for the coroutine pipeline (executor, awaitable queues, async persistence)
+TEST(AsyncPipelineTest, CollectAndPersist) {
+
+    GeneratorConfig generatorConfig;
+    generatorConfig.m_numChannels = 20;
+    generatorConfig.m_groupRates = {100.0, 10.0};
+    generatorConfig.m_duration = 5000.0;
+    generatorConfig.m_seed = 3;
+    generatorConfig.m_paced = false;
+
+    AsyncPipelineConfig config;
+    config.m_executorThreads = 2;
+    config.m_generatorTasks = 3;
+    config.m_numCollectors = 3;
+    config.m_queueCapacity = 4;
+    config.m_persistChunk = 64;
+    config.m_persistDirectory = "../storage/async_test";
+
+    std::unordered_map<uint16_t, DataChannel> channels;
+    AsyncPipelineReport report = runAsyncPipeline(generatorConfig, config, channels);
+    ASSERT_EQ(report.m_generated, 10 * 500 + 10 * 50);
+    ASSERT_EQ(report.m_persisted, report.m_generated);
+    // 7 full chunks + the flushed remainder for the 100 hz channels, 1 flushed chunk for the 10 hz ones
+    ASSERT_EQ(report.m_bytesWritten, report.m_generated * 16 + 8 * (10 * 8 + 10 * 1));
+    ASSERT_GT(report.m_suspensions, 0);
+    ASSERT_GE(report.m_drainMs, 0.0);
+    ASSERT_GE(report.m_flushMs, 0.0);
+    ASSERT_EQ(channels.size(), 20);
+    ASSERT_EQ(channels[0].size(), 500);
+    ASSERT_EQ(channels[19].size(), 50);
+    ASSERT_EQ(channels[19].m_name, "Sensor_19");
+    ASSERT_TRUE(checkOrder(channels));
+
+    // The persisted blocks of a channel, read back in order, are the channel
+    std::ifstream file("../storage/async_test/channel_7.bin", std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t row = 0;
+    for (size_t at = 0; at < bytes.size(); ) {
+        uint32_t count;
+        std::memcpy(&count, bytes.data() + at, 4);
+        for (uint32_t i = 0; i < count; i++, row++) {
+            Timestamp timestamp;
+            double value;
+            std::memcpy(&timestamp, bytes.data() + at + 8 + 8 * i, 8);
+            std::memcpy(&value, bytes.data() + at + 8 + 8 * count + 8 * i, 8);
+            ASSERT_EQ(timestamp, channels[7].timestampAt(row));
+            ASSERT_TRUE(std::isnan(value) ? std::isnan(channels[7].valueAt(row)) : value == channels[7].valueAt(row));
+        }
+        at += 8 + 16 * count;
+    }
+    ASSERT_EQ(row, 500);
+}
+
+// Test suite for the shared-memory ingest endpoint (several producer processes)
+TEST(ShmIngestTest, MultiProcess) {
+#if defined(__linux__)
+    const std::string name = "/datacollector_test_" + std::to_string(getpid());
+    const int numProducers = 3;
+    const int perProducer = 200000;
+
+    ShmIngestEndpoint endpoint;
+    ASSERT_TRUE(endpoint.create(name, 4096));
+
+    // Producers are forked before any thread is started; they wait while the ring is full
+    auto start = std::chrono::steady_clock::now();
+    std::vector<pid_t> producers;
+    for (int p = 0; p < numProducers; p++) {
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            ShmIngestClient client;
+            if (!client.connect(name)) _exit(1);
+            for (int i = 0; i < perProducer; i++) client.push(static_cast<uint16_t>(p * 10 + i % 10), i, i);
+            _exit(0);
+        }
+        producers.push_back(pid);
+    }
+
+    DataQueue queue(1 << 16, OverloadPolicy::Block);
+    std::unordered_map<uint16_t, DataChannel> channels;
+    std::thread endpointThread([&] { endpoint.run(queue); });
+    std::thread collectorThread([&] { dataCollectorBatched(queue, channels); });
+
+    // Stop and join before asserting, a failed producer must not leave the threads joinable
+    std::vector<int> statuses;
+    for (pid_t pid : producers) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        statuses.push_back(status);
+    }
+    endpoint.stop();
+    endpointThread.join();
+    collectorThread.join();
+    for (int status : statuses) ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Shared-memory ingest: " << numProducers * perProducer / seconds << " records/s" << std::endl;
+
+    ASSERT_EQ(endpoint.m_received, numProducers * perProducer);
+    ASSERT_EQ(channels.size(), numProducers * 10);
+    for (auto& channel : channels) {
+        ASSERT_EQ(channel.second.size(), perProducer / 10);
+        ASSERT_EQ(channel.second.m_name, "Sensor_" + std::to_string(channel.first));
+    }
+    ASSERT_TRUE(checkOrder(channels));
+#else
+    GTEST_SKIP() << "Shared-memory ingest needs POSIX shared memory and fork";
+#endif
+}
+
+// Test suite for the shared-memory ingest endpoint when a producer dies mid-push
+TEST(ShmIngestTest, ProducerKilledMidPush) {
+#if defined(__linux__)
+    const std::string name = "/datacollector_test_killed_" + std::to_string(getpid());
+    const int before = 100;
+    const int after = 1000;
+
+    ShmIngestEndpoint endpoint;
+    ASSERT_TRUE(endpoint.create(name, 4096));
+    endpoint.m_ring.m_stuckTimeoutMs = 50;
+
+    // Pushes some records, then claims a position and is killed before publishing it
+    pid_t killed = fork();
+    ASSERT_GE(killed, 0);
+    if (killed == 0) {
+        ShmIngestClient client;
+        if (!client.connect(name)) _exit(1);
+        for (int i = 0; i < before; i++) client.push(1, i, i);
+        client.m_ring.m_header->m_head.fetch_add(1);
+        raise(SIGKILL);
+        _exit(0);
+    }
+    int killedStatus = 0;
+    waitpid(killed, &killedStatus, 0);
+
+    // Another producer's records land behind the stuck slot
+    pid_t producer = fork();
+    ASSERT_GE(producer, 0);
+    if (producer == 0) {
+        ShmIngestClient client;
+        if (!client.connect(name)) _exit(1);
+        for (int i = 0; i < after; i++) {
+            if (!client.push(2, i, i)) _exit(2);
+        }
+        _exit(0);
+    }
+    int producerStatus = 0;
+    waitpid(producer, &producerStatus, 0);
+
+    DataQueue queue(1 << 16, OverloadPolicy::Block);
+    std::unordered_map<uint16_t, DataChannel> channels;
+    std::thread endpointThread([&] { endpoint.run(queue); });
+    std::thread collectorThread([&] { dataCollectorBatched(queue, channels); });
+    endpoint.stop();
+    endpointThread.join();
+    collectorThread.join();
+
+    ASSERT_TRUE(WIFSIGNALED(killedStatus) && WTERMSIG(killedStatus) == SIGKILL);
+    ASSERT_TRUE(WIFEXITED(producerStatus) && WEXITSTATUS(producerStatus) == 0);
+    ASSERT_EQ(endpoint.m_ring.m_skipped, 1);
+    ASSERT_EQ(endpoint.m_received, before + after);
+    ASSERT_EQ(channels[1].size(), before);
+    ASSERT_EQ(channels[2].size(), after);
+    ASSERT_FALSE(endpoint.m_ring.claimed());
+
+    // The skipped slot is free again for the next lap
+    ShmIngestClient client;
+    ASSERT_TRUE(client.connect(name));
+    client.m_waitTimeoutMs = 10;
+    size_t pushed = 0;
+    while (client.push(3, 0, 0.0)) pushed++;
+    ASSERT_EQ(pushed, endpoint.m_ring.m_header->m_capacity);
+    ASSERT_EQ(client.m_timedOut, 1);
+#else
+    GTEST_SKIP() << "Shared-memory ingest needs POSIX shared memory and fork";
+#endif
+}
+
+// Test suite for the multi-process partitioned deployment (scatter-gather over Unix sockets)
+TEST(PartitionRouterTest, ScatterGather) {
+#if defined(__linux__)
+    GeneratorConfig config;
+    config.m_numChannels = 20;
+    config.m_duration = 5000.0;
+    config.m_seed = 9;
+    config.m_paced = false;
+
+    PartitionRouter router;
+    ASSERT_TRUE(router.start(3, "../storage/partition_test"));
+    ASSERT_EQ(router.m_partitions.size(), 3);
+    ASSERT_EQ(router.partitionOf(7), 1);
+
+    // The same inputs go to the partitions and to a local channel map
+    std::unordered_map<uint16_t, DataChannel> channels;
+    uint64_t generated = generatorProducer(config, 0, config.m_numChannels, config.m_seed, [&](std::vector<DataInput>& batch) {
+        ASSERT_TRUE(router.ingest(batch));
+        for (const DataInput& input : batch) {
+            auto it = channels.try_emplace(input.m_id, input.m_id, input.m_name, input.m_unit).first;
+            it->second.insert(input.m_dp);
+        }
+    });
+    ASSERT_EQ(router.m_routed, generated);
+    ASSERT_EQ(router.sync(), generated);
+
+    std::vector<uint16_t> ids = {0, 1, 2, 7, 13, 19, 300};
+    auto gathered = router.retrieveChannelSubsets(ids, fromMilliseconds(1000), fromMilliseconds(4000));
+    ids.pop_back();
+    auto local = retrieveChannelSubsets(channels, ids, fromMilliseconds(1000), fromMilliseconds(4000));
+    ASSERT_EQ(gathered.size(), ids.size());
+    for (uint16_t id : ids) {
+        ASSERT_EQ(gathered[id].m_name, "Sensor_" + std::to_string(id));
+        ASSERT_EQ(gathered[id].m_timestamps, local[id].m_timestamps);
+        ASSERT_EQ(gathered[id].m_values, local[id].m_values);
+        ASSERT_EQ(gathered[id].m_nanMask, local[id].m_nanMask);
+        ASSERT_EQ(gathered[id].m_rangeStart, local[id].m_rangeStart);
+    }
+
+    // Later datapoints are visible to the next query
+    std::vector<DataInput> late;
+    late.emplace_back(7, "Sensor_7", "Unit_7", DataPoint(fromMilliseconds(3999.5), 0.25));
+    ASSERT_TRUE(router.ingest(late));
+    auto again = router.retrieveChannelSubsets({7}, fromMilliseconds(3999), fromMilliseconds(4000));
+    ASSERT_EQ(again[7].m_values.back(), 0.25);
+    ASSERT_TRUE(router.m_failed.empty());
+
+    // A partition that died is reported, the others still answer
+    kill(router.m_partitions[1].m_pid, SIGKILL);
+    auto partial = router.retrieveChannelSubsets({0, 1, 2, 7}, fromMilliseconds(1000), fromMilliseconds(4000));
+    ASSERT_EQ(router.m_failed, std::vector<unsigned>{1});
+    ASSERT_EQ(partial.size(), 2);
+    ASSERT_EQ(partial[0].m_timestamps, local[0].m_timestamps);
+    ASSERT_EQ(partial[2].m_timestamps, local[2].m_timestamps);
+    ASSERT_EQ(router.m_partitions[1].m_fd, -1);
+    router.retrieveChannelSubsets({0}, fromMilliseconds(1000), fromMilliseconds(4000));
+    ASSERT_TRUE(router.m_failed.empty());
+
+    router.shutdown();
+    ASSERT_TRUE(router.m_partitions.empty());
+    ASSERT_FALSE(std::filesystem::exists("../storage/partition_test/partition_0.sock"));
+#else
+    GTEST_SKIP() << "The partitioned deployment needs Unix domain sockets and fork";
+#endif
+}
+
 // Test suite for the method retrieveChannelSubsets 
 TEST(RetrieveChannelSubsetsTest, Basic) {
     std::unordered_map<uint16_t, DataChannel> channels;
     DataChannel channel1(1, "Sensor_1", "Unit_1");
     DataChannel channel2(2, "Sensor_2", "Unit_2");
-    DataPoint dp1(1.0, 42.0);
-    DataPoint dp2(1.5, 43.0);
-    DataPoint dp3(2.0, std::numeric_limits<double>::quiet_NaN());
-    channel1.m_data.push_back(dp1);
-    channel2.m_data.push_back(dp2);
-    channel2.m_data.push_back(dp3);
+    DataPoint dp1(fromMilliseconds(1.0), 42.0);
+    DataPoint dp2(fromMilliseconds(1.5), 43.0);
+    DataPoint dp3(fromMilliseconds(2.0), std::numeric_limits<double>::quiet_NaN());
+    channel1.append(dp1);
+    channel2.append(dp2);
+    channel2.append(dp3);
     channels[1] = std::move(channel1);
     channels[2] = std::move(channel2);
     std::vector<uint16_t> channelIds = {1, 2};
-    auto subsetChannels = retrieveChannelSubsets(channels, channelIds, 0.0, 3.0);
+    auto subsetChannels = retrieveChannelSubsets(channels, channelIds, 0, fromMilliseconds(3.0));
     ASSERT_TRUE(checkOrder(channels));
     ASSERT_EQ(subsetChannels.size(), channelIds.size());
     ASSERT_EQ(subsetChannels[1].m_timestamps.size(), 1);
     ASSERT_EQ(subsetChannels[2].m_timestamps.size(), 1);
     ASSERT_EQ(subsetChannels[1].m_values.size(), 1);
     ASSERT_EQ(subsetChannels[2].m_values.size(), 1);
-    ASSERT_TRUE(subsetChannels[1].m_nan_dps.empty());
-    ASSERT_EQ(subsetChannels[2].m_nan_dps.size(), 1);
+    ASSERT_EQ(subsetChannels[1].m_nanCount, 0);
+    ASSERT_EQ(subsetChannels[2].m_nanCount, 1);
+    ASSERT_EQ(subsetChannels[2].nanPositions(), std::vector<size_t>({1}));
+    ASSERT_EQ(subsetChannels[2].nanDatapoints(channels[2])[0].m_timestamp, fromMilliseconds(2.0));
+}
+
+// Test suite for the validity bitmap and the NaN bitmap of extracted ranges
+TEST(RetrieveChannelSubsetsTest, NanBitmap) {
+
+    std::unordered_map<uint16_t, DataChannel> channels;
+    DataChannel channel(1, "Sensor_1", "Unit_1");
+    std::vector<Timestamp> nanTimestamps;
+    for (int i = 0; i < 3000; i++) {
+        bool nan = i % 13 == 0 || (i >= 2000 && i < 2100);
+        channel.insert(DataPoint(i, nan ? std::numeric_limits<double>::quiet_NaN() : i));
+        if (nan && i >= 70 && i <= 2500) nanTimestamps.push_back(i);
+    }
+    channels[1] = std::move(channel);
+    ASSERT_FALSE(channels[1].isValid(13));
+    ASSERT_TRUE(channels[1].isValid(14));
+    ASSERT_EQ(channels[1].m_blocks[1].m_nanCount, 79 + 48 - 4); // multiples of 13 + [2000, 2048), 4 in both
+
+    auto subsets = retrieveChannelSubsets(channels, {1}, 70, 2500);
+    const ExtractedSubChannel& subset = subsets[1];
+    ASSERT_EQ(subset.m_rangeStart, 70);
+    ASSERT_EQ(subset.m_rangeSize, 2431);
+    ASSERT_EQ(subset.m_nanCount, nanTimestamps.size());
+    ASSERT_EQ(subset.m_values.size() + subset.m_nanCount, subset.m_rangeSize);
+    for (double value : subset.m_values) ASSERT_FALSE(std::isnan(value));
+    for (size_t i = 0; i < subset.m_values.size(); i++) ASSERT_EQ(subset.m_timestamps[i], subset.m_values[i]);
+
+    std::vector<DataPoint> nanDatapoints = subset.nanDatapoints(channels[1]);
+    ASSERT_EQ(nanDatapoints.size(), nanTimestamps.size());
+    for (size_t i = 0; i < nanDatapoints.size(); i++) {
+        ASSERT_EQ(nanDatapoints[i].m_timestamp, nanTimestamps[i]);
+        ASSERT_TRUE(std::isnan(nanDatapoints[i].m_value));
+    }
+
+    // An inverted range is empty
+    auto inverted = retrieveChannelSubsets(channels, {1}, 2500, 70);
+    ASSERT_EQ(inverted[1].m_rangeSize, 0);
+    ASSERT_TRUE(inverted[1].m_values.empty());
+    ASSERT_EQ(inverted[1].m_nanCount, 0);
+}
+
+// Test suite for the zone map (block summaries) predicate queries
+TEST(RetrieveChannelMatchesTest, Basic) {
+
+    std::unordered_map<uint16_t, DataChannel> channels;
+    DataChannel channel(1, "Sensor_1", "Unit_1");
+    for (int i = 0; i < 5000; i++) {
+        double value = (i >= 3000 && i < 3010) ? 10.0 + i : 0.5;
+        if (i % 7 == 0) value = std::numeric_limits<double>::quiet_NaN();
+        channel.insert(DataPoint(2 * i, value));
+    }
+    channel.insert(DataPoint(8201, 50.0)); // late
+    channels[1] = std::move(channel);
+
+    ASSERT_EQ(channels[1].m_blocks.size(), 5);
+    ASSERT_EQ(channels[1].m_blocks[2].m_max, 3009 + 10.0);
+    ASSERT_EQ(channels[1].m_blocks[2].m_min, 0.5);
+    ASSERT_EQ(channels[1].m_blocks[0].m_count, DataChannel::kBlockSize);
+    ASSERT_FALSE(blockMayMatch(channels[1].m_blocks[0], Comparison::Greater, 1.0));
+    ASSERT_TRUE(blockMayMatch(channels[1].m_blocks[2], Comparison::Greater, 1.0));
+
+    auto matches = retrieveChannelMatches(channels, {1}, 2000, 9000, Comparison::Greater, 1.0);
+    std::pmr::vector<Timestamp> expected;
+    for (int i = 3000; i < 3010; i++) if (i % 7 != 0) expected.push_back(2 * i);
+    expected.push_back(8201);
+    ASSERT_EQ(matches[1].m_timestamps, expected);
+    ASSERT_EQ(matches[1].m_values.front(), 3000 + 10.0);
+    ASSERT_EQ(matches[1].m_values.back(), 50.0);
+
+    // Same answer as extracting the range and filtering every point
+    auto lessMatches = retrieveChannelMatches(channels, {1}, 20, 6008, Comparison::LessEqual, 0.5);
+    auto subsets = retrieveChannelSubsets(channels, {1}, 20, 6008);
+    std::pmr::vector<Timestamp> filtered;
+    for (size_t i = 0; i < subsets[1].m_values.size(); i++) {
+        if (subsets[1].m_values[i] <= 0.5) filtered.push_back(subsets[1].m_timestamps[i]);
+    }
+    ASSERT_EQ(lessMatches[1].m_timestamps, filtered);
+}
+
+// Test suite for the per-channel value codecs and the aggregate query
+TEST(ValueCodecTest, RoundTripAndAggregates) {
+
+    std::unordered_map<uint16_t, DataChannel> channels;
+    std::vector<ValueEncoding> encodings = {
+        ValueEncoding(ValueCodec::Double),
+        ValueEncoding(ValueCodec::Float),
+        ValueEncoding::scaled16(-10.0, 10.0)
+    };
+    for (uint16_t id = 0; id < encodings.size(); id++) {
+        DataChannel channel(id, "Sensor_" + std::to_string(id), "Unit_" + std::to_string(id));
+        for (int i = 0; i < 3000; i++) {
+            double value = (i % 11 == 0) ? std::numeric_limits<double>::quiet_NaN() : 10.0 * std::sin(i * 0.01);
+            channel.insert(DataPoint(i, value));
+        }
+        channel.setEncoding(encodings[id]);
+        channels[id] = std::move(channel);
+    }
+
+    ASSERT_EQ(channels[1].m_values.memoryBytes() * 2, channels[0].m_values.memoryBytes());
+    ASSERT_EQ(channels[2].m_values.memoryBytes() * 4, channels[0].m_values.memoryBytes());
+    ASSERT_EQ(ValueEncoding::codecFromName(encodings[2].codecName()), ValueCodec::Scaled16);
+
+    // Values within the codec's resolution, NaN preserved
+    double tolerance[] = {0.0, 1e-5, encodings[2].m_scale / 2};
+    for (uint16_t id = 0; id < encodings.size(); id++) {
+        ASSERT_EQ(channels[id].size(), 3000);
+        for (size_t i = 0; i < channels[id].size(); i++) {
+            ASSERT_EQ(std::isnan(channels[id].valueAt(i)), std::isnan(channels[0].valueAt(i)));
+            if (!std::isnan(channels[0].valueAt(i))) {
+                ASSERT_NEAR(channels[id].valueAt(i), channels[0].valueAt(i), tolerance[id]);
+            }
+        }
+    }
+
+    // Aggregates computed on the stored type match a brute force over the decoded values
+    auto aggregates = retrieveChannelAggregates(channels, {0, 1, 2}, 100, 2500);
+    for (uint16_t id = 0; id < encodings.size(); id++) {
+        uint64_t count = 0;
+        double sum = 0.0;
+        double minValue = std::numeric_limits<double>::infinity();
+        for (int i = 100; i <= 2500; i++) {
+            double value = channels[id].valueAt(i);
+            if (std::isnan(value)) continue;
+            count++;
+            sum += value;
+            minValue = std::min(minValue, value);
+        }
+        ASSERT_EQ(aggregates[id].m_count, count);
+        ASSERT_NEAR(aggregates[id].m_sum, sum, 1e-6);
+        ASSERT_EQ(aggregates[id].m_min, minValue);
+    }
+}
+
+// Test suite for the per-block quantile sketches and the percentile query
+TEST(RetrieveChannelPercentilesTest, ErrorBound) {
+
+    std::unordered_map<uint16_t, DataChannel> channels;
+    DataChannel channel(1, "Sensor_1", "Unit_1");
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> valueDist(0, 100000);
+    for (int i = 0; i < 10000; i++) {
+        double value = (i % 31 == 0) ? std::numeric_limits<double>::quiet_NaN() : valueDist(gen) / 8.0;
+        channel.insert(DataPoint(i, value));
+    }
+    channels[1] = std::move(channel);
+    ASSERT_EQ(channels[1].m_blocks[0].m_sketch.samples().size(), QuantileSketch::kSamples);
+    ASSERT_TRUE(channels[1].m_blocks.back().m_sketch.samples().empty()); // open block
+
+    auto summaries = retrieveChannelPercentiles(channels, {1}, 500, 9700);
+    PercentileSummary& summary = summaries[1];
+    std::vector<double> exact;
+    for (int i = 500; i <= 9700; i++) if (i % 31 != 0) exact.push_back(channels[1].valueAt(i));
+    std::sort(exact.begin(), exact.end());
+    ASSERT_EQ(summary.m_count, exact.size());
+    ASSERT_GT(summary.m_rankError, 0.0);
+    ASSERT_LE(summary.relativeError(), 1.0 / QuantileSketch::kSamples);
+
+    for (double p : {1.0, 50.0, 95.0, 99.0}) {
+        double estimate = summary.percentile(p);
+        double target = std::ceil(p / 100.0 * exact.size());
+        double lowRank = std::lower_bound(exact.begin(), exact.end(), estimate) - exact.begin() + 1;
+        double highRank = std::upper_bound(exact.begin(), exact.end(), estimate) - exact.begin();
+        ASSERT_LE(lowRank, target + summary.m_rankError + 1);
+        ASSERT_GE(highRank, target - summary.m_rankError - 1);
+    }
+
+    // Within a single block every value is added exactly
+    auto small = retrieveChannelPercentiles(channels, {1}, 1100, 1900);
+    std::vector<double> smallExact;
+    for (int i = 1100; i <= 1900; i++) if (i % 31 != 0) smallExact.push_back(channels[1].valueAt(i));
+    std::sort(smallExact.begin(), smallExact.end());
+    ASSERT_EQ(small[1].m_rankError, 0.0);
+    ASSERT_EQ(small[1].percentile(50.0), smallExact[std::ceil(0.5 * smallExact.size()) - 1]);
+    ASSERT_EQ(small[1].percentile(100.0), smallExact.back());
+
+    // Samples keep the full double precision, so exact sketches are really exact
+    std::vector<double> precise = {123456.789012345, 0.1, 1.0 / 3.0};
+    QuantileSketch sketch;
+    sketch.build(precise);
+    ASSERT_EQ(sketch.rankError(), 0.0);
+    ASSERT_EQ(sketch.samples()[0], 0.1);
+    ASSERT_EQ(sketch.samples()[1], 1.0 / 3.0);
+    ASSERT_EQ(sketch.samples()[2], 123456.789012345);
+}
+
+// Test suite for the derived-channel expressions (alignment, arithmetic, moving average)
+TEST(RetrieveDerivedChannelTest, Expressions) {
+
+    std::unordered_map<uint16_t, DataChannel> channels;
+    DataChannel fast(1, "Sensor_1", "Unit_1");
+    DataChannel slow(2, "Sensor_2", "Unit_2");
+    for (int i = 0; i < 3000; i++) {
+        double value = (i % 17 == 0) ? std::numeric_limits<double>::quiet_NaN() : i % 100;
+        fast.insert(DataPoint(10 * i, value));
+        if (i % 4 == 0) slow.insert(DataPoint(10 * i + 5, i));
+    }
+    channels[1] = std::move(fast);
+    channels[2] = std::move(slow);
+
+    // Difference: the slow channel is held at the fast channel's timestamps
+    ChannelExpr difference = ChannelExpr::channel(1) - ChannelExpr::channel(2) * ChannelExpr::constant(2.0);
+    ASSERT_EQ(difference.toString(), "(ch1 - (ch2 * 2))");
+    ASSERT_EQ(difference.channelIds(), std::vector<uint16_t>({1, 2}));
+    ExtractedSubChannel derived = retrieveDerivedChannel(channels, difference, 0, 29990);
+    ASSERT_EQ(derived.m_id, 1);
+    ASSERT_EQ(derived.m_rangeSize, 3000);
+    size_t expectedValid = 0;
+    for (int i = 0; i < 3000; i++) {
+        if (i % 17 == 0) continue; // NaN (at 0 there is no slow datapoint yet either)
+        ASSERT_EQ(derived.m_timestamps[expectedValid], 10 * i);
+        ASSERT_EQ(derived.m_values[expectedValid], i % 100 - 2.0 * ((i - 1) / 4 * 4));
+        expectedValid++;
+    }
+    ASSERT_EQ(derived.m_values.size(), expectedValid);
+    ASSERT_EQ(derived.m_nanCount, 3000 - expectedValid);
+    ASSERT_EQ(derived.nanPositions().front(), 0);
+
+    // Moving average over 100 ns (10 datapoints), full windows from the lower bound on
+    ChannelExpr average = ChannelExpr::movingAverage(ChannelExpr::channel(1), 100);
+    ASSERT_EQ(average.lookback(), 100);
+    ExtractedSubChannel averaged = retrieveDerivedChannel(channels, average, 15000, 25000);
+    ASSERT_EQ(averaged.m_nanCount, 0);
+    for (size_t k = 0; k < averaged.m_timestamps.size(); k++) {
+        Timestamp t = averaged.m_timestamps[k];
+        double sum = 0.0;
+        int count = 0;
+        for (Timestamp u = t - 90; u <= t; u += 10) {
+            double value = channels[1].valueAt(u / 10);
+            if (!std::isnan(value)) { sum += value; count++; }
+        }
+        ASSERT_NEAR(averaged.m_values[k], sum / count, 1e-9);
+    }
+    ASSERT_EQ(averaged.m_timestamps.front(), 15000);
+    ASSERT_EQ(averaged.m_timestamps.back(), 25000);
+}
+
+// Test suite for the Arrow IPC file export (read back with a minimal flatbuffer reader)
+TEST(ArrowExportTest, FileLayout) {
+
+    DataChannel channel(1, "Sensor_1", "Unit_1");
+    const size_t size = ArrowWriter::kBatchRows + 4464;
+    for (size_t i = 0; i < size; i++) {
+        double value = i % 100 == 7 ? std::numeric_limits<double>::quiet_NaN() : i * 0.5;
+        channel.append(DataPoint(static_cast<Timestamp>(i) * 1000 + 3, value));
+    }
+    const std::string path = "../storage/channel_test.arrow";
+    ASSERT_TRUE(saveChannelArrow(channel, path, std::numeric_limits<Timestamp>::min(), std::numeric_limits<Timestamp>::max()));
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_GT(bytes.size(), size * 16);
+    ASSERT_EQ(std::string(bytes.begin(), bytes.begin() + 6), "ARROW1");
+    ASSERT_EQ(std::string(bytes.end() - 6, bytes.end()), "ARROW1");
+
+    auto read = [&](size_t at, auto value) { std::memcpy(&value, bytes.data() + at, sizeof(value)); return value; };
+    auto deref = [&](size_t at) { return at + read(at, uint32_t(0)); };
+    auto field = [&](size_t table, int index) -> size_t {
+        size_t vtable = table - read(table, int32_t(0));
+        if (4 + 2 * index >= read(vtable, uint16_t(0))) return 0;
+        uint16_t offset = read(vtable + 4 + 2 * index, uint16_t(0));
+        return offset ? table + offset : 0;
+    };
+    auto string = [&](size_t at) { return std::string(bytes.begin() + at + 4, bytes.begin() + at + 4 + read(at, uint32_t(0))); };
+
+    // Footer: version, schema (timestamp[ns] not null, nullable float64), record batch index
+    int32_t footerLength = read(bytes.size() - 10, int32_t(0));
+    size_t footer = deref(bytes.size() - 10 - footerLength);
+    ASSERT_EQ(read(field(footer, 0), int16_t(0)), 4);
+    size_t fields = deref(field(deref(field(footer, 1)), 1));
+    ASSERT_EQ(read(fields, uint32_t(0)), 2u);
+    size_t timestampField = deref(fields + 4), valueField = deref(fields + 8);
+    ASSERT_EQ(string(deref(field(timestampField, 0))), "timestamp");
+    ASSERT_EQ(read(field(timestampField, 2), uint8_t(0)), 10);
+    ASSERT_EQ(read(field(deref(field(timestampField, 3)), 0), int16_t(0)), 3);
+    ASSERT_EQ(string(deref(field(valueField, 0))), "value");
+    ASSERT_EQ(read(field(valueField, 1), uint8_t(0)), 1);
+    ASSERT_EQ(read(field(valueField, 2), uint8_t(0)), 3);
+    ASSERT_EQ(read(field(deref(field(valueField, 3)), 0), int16_t(0)), 2);
+    ASSERT_EQ(read(deref(field(valueField, 5)), uint32_t(0)), 0u);
+
+    size_t blocks = deref(field(footer, 3));
+    ASSERT_EQ(read(blocks, uint32_t(0)), 2u);
+
+    size_t row = 0;
+    for (size_t b = 0; b < 2; b++) {
+        ArrowBlock block = read(blocks + 4 + b * sizeof(ArrowBlock), ArrowBlock{});
+        ASSERT_EQ(block.m_offset % 8, 0);
+        ASSERT_EQ(read(block.m_offset, uint32_t(0)), 0xFFFFFFFFu);
+        ASSERT_EQ(8 + read(block.m_offset + 4, int32_t(0)), block.m_metaDataLength);
+
+        size_t message = deref(block.m_offset + 8);
+        ASSERT_EQ(read(field(message, 1), uint8_t(0)), 3);
+        ASSERT_EQ(read(field(message, 3), int64_t(0)), block.m_bodyLength);
+        size_t batch = deref(field(message, 2));
+        int64_t length = read(field(batch, 0), int64_t(0));
+        ASSERT_EQ(length, b == 0 ? ArrowWriter::kBatchRows : size - ArrowWriter::kBatchRows);
+
+        size_t nodes = deref(field(batch, 1));
+        int64_t nullCount = read(nodes + 4 + 24, int64_t(0));
+        ASSERT_EQ(read(nodes + 4 + 16, int64_t(0)), length);
+        int64_t expectedNulls = 0;
+        for (int64_t i = 0; i < length; i++) expectedNulls += std::isnan(channel.valueAt(row + i));
+        ASSERT_EQ(nullCount, expectedNulls);
+
+        size_t buffers = deref(field(batch, 2));
+        ASSERT_EQ(read(buffers, uint32_t(0)), 4u);
+        size_t body = block.m_offset + block.m_metaDataLength;
+        size_t timestamps = body + read(buffers + 4 + 16, int64_t(0));
+        size_t validity = body + read(buffers + 4 + 32, int64_t(0));
+        size_t values = body + read(buffers + 4 + 48, int64_t(0));
+        for (int64_t i = 0; i < length; i++, row++) {
+            ASSERT_EQ(read(timestamps + 8 * i, Timestamp(0)), channel.timestampAt(row));
+            bool valid = (bytes[validity + i / 8] >> (i % 8)) & 1;
+            ASSERT_EQ(valid, !std::isnan(channel.valueAt(row)));
+            if (valid) {
+                ASSERT_EQ(read(values + 8 * i, 0.0), channel.valueAt(row));
+            }
+        }
+    }
+    ASSERT_EQ(row, size);
+
+    // A subset of the whole range, with its NaN datapoints put back as nulls, gives the same file
+    std::unordered_map<uint16_t, DataChannel> channels;
+    channels[1] = std::move(channel);
+    auto subsets = retrieveChannelSubsets(channels, {1}, 0, std::numeric_limits<Timestamp>::max());
+    const std::string subsetPath = "../storage/channel_test_subset.arrow";
+    ASSERT_TRUE(saveSubChannelArrow(subsets[1], channels[1], subsetPath));
+    std::ifstream subsetFile(subsetPath, std::ios::binary);
+    std::vector<uint8_t> subsetBytes((std::istreambuf_iterator<char>(subsetFile)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(subsetBytes, bytes);
 }
 
 // Test suite for saving and loading all channels
@@ -128,14 +1081,14 @@ TEST(JsonTests, SaveAndLoadJson) {
     std::unordered_map<uint16_t, DataChannel> testChannels;
 
     DataChannel dc1(1, "Sensor_1", "Unit_1");
-    DataPoint dp1(1.0, 10.0);
-    DataPoint dp2(2.0, 11.0);
-    dc1.m_data.push_back(dp1);
-    dc1.m_data.push_back(dp2);
+    DataPoint dp1(fromMilliseconds(1.0), 10.0);
+    DataPoint dp2(fromMilliseconds(2.0), 11.0);
+    dc1.append(dp1);
+    dc1.append(dp2);
 
     DataChannel dc2(2, "Sensor_2", "Unit_2");
-    DataPoint dp3(2.5, std::numeric_limits<double>::quiet_NaN());
-    dc2.m_data.push_back(dp3);
+    DataPoint dp3(fromMilliseconds(2.5), std::numeric_limits<double>::quiet_NaN());
+    dc2.append(dp3);
 
     testChannels[1] = std::move(dc1);
     testChannels[2] = std::move(dc2);
@@ -149,7 +1102,7 @@ TEST(JsonTests, SaveAndLoadJson) {
         ASSERT_NE(loadedChannels.find(pair.first), loadedChannels.end());
         ASSERT_EQ(pair.second.m_name, loadedChannels[pair.first].m_name);
         ASSERT_EQ(pair.second.m_unit, loadedChannels[pair.first].m_unit);
-        ASSERT_EQ(pair.second.m_data.size(), loadedChannels[pair.first].m_data.size());
+        ASSERT_EQ(pair.second.size(), loadedChannels[pair.first].size());
     }
 }
 
@@ -164,16 +1117,16 @@ bool customEquality(double a, double b) {
 TEST(JsonTests, SaveAndLoadChannel) {
 
     DataChannel testChannel(1, "Sensor_1", "Unit_1");
-    DataPoint dp1(1.0, 42.0);
-    DataPoint dp2(1.5, 43.0);
-    DataPoint dp3(2.0, std::numeric_limits<double>::quiet_NaN());
-    DataPoint dp4(3.0, 39.0);
-    DataPoint dp5(5.0, 40.0);
-    testChannel.m_data.push_back(dp1);
-    testChannel.m_data.push_back(dp2);
-    testChannel.m_data.push_back(dp3);
-    testChannel.m_data.push_back(dp4);
-    testChannel.m_data.push_back(dp5);
+    DataPoint dp1(fromMilliseconds(1.0), 42.0);
+    DataPoint dp2(fromMilliseconds(1.5), 43.0);
+    DataPoint dp3(fromMilliseconds(2.0), std::numeric_limits<double>::quiet_NaN());
+    DataPoint dp4(fromMilliseconds(3.0), 39.0);
+    DataPoint dp5(fromMilliseconds(5.0), 40.0);
+    testChannel.append(dp1);
+    testChannel.append(dp2);
+    testChannel.append(dp3);
+    testChannel.append(dp4);
+    testChannel.append(dp5);
     saveChannel(testChannel);
 
     DataChannel loadedChannel;
@@ -182,13 +1135,547 @@ TEST(JsonTests, SaveAndLoadChannel) {
     ASSERT_EQ(testChannel.m_id, loadedChannel.m_id);
     ASSERT_EQ(testChannel.m_name, loadedChannel.m_name);
     ASSERT_EQ(testChannel.m_unit, loadedChannel.m_unit);
-    ASSERT_EQ(testChannel.m_data.size(), loadedChannel.m_data.size());
-    for (auto i = 0; i < testChannel.m_data.size(); i++) {
-        ASSERT_EQ(testChannel.m_data[i].m_timestamp, loadedChannel.m_data[i].m_timestamp);
-        ASSERT_TRUE(customEquality(testChannel.m_data[i].m_value, loadedChannel.m_data[i].m_value));
+    ASSERT_EQ(testChannel.size(), loadedChannel.size());
+    for (auto i = 0; i < testChannel.size(); i++) {
+        ASSERT_EQ(testChannel.at(i).m_timestamp, loadedChannel.at(i).m_timestamp);
+        ASSERT_TRUE(customEquality(testChannel.at(i).m_value, loadedChannel.at(i).m_value));
     } 
 }
 
+// Test suite for the incremental (segment) saves and their background compaction
+TEST(JsonTests, IncrementalSegments) {
+
+    auto lineCount = [](const std::string& path) {
+        std::ifstream file(path);
+        return std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
+    };
+    auto assertSameChannel = [](const DataChannel& a, const DataChannel& b) {
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); i++) {
+            ASSERT_EQ(a.timestampAt(i), b.timestampAt(i));
+            ASSERT_TRUE(customEquality(a.valueAt(i), b.valueAt(i)));
+        }
+    };
+
+    DataChannel channel(900, "Sensor_900", "Unit_900");
+    const std::string path = segmentPath(channel.m_id);
+    for (Timestamp t = 0; t < 1000; t++) channel.insert(DataPoint(t * kNanosPerMilli, t % 97 == 0 ? std::nan("") : t * 0.5));
+    ASSERT_EQ(saveSegment(channel), 1000);
+    ASSERT_EQ(channel.m_persisted, 1000);
+    auto fullBytes = std::filesystem::file_size(path);
+
+    // Only the new datapoints are appended, nothing when there are none
+    for (Timestamp t = 1000; t < 1010; t++) channel.insert(DataPoint(t * kNanosPerMilli, t * 0.5));
+    ASSERT_EQ(saveSegment(channel), 10);
+    ASSERT_EQ(saveSegment(channel), 0);
+    ASSERT_EQ(lineCount(path), 2);
+    ASSERT_LT(std::filesystem::file_size(path) - fullBytes, fullBytes / 20);
+
+    // A late datapoint merged into the persisted range moves the watermark back
+    channel.insert(DataPoint(1005 * kNanosPerMilli + 1, -1.0));
+    ASSERT_EQ(saveSegment(channel), 5);
+    DataChannel loaded;
+    ASSERT_TRUE(loadSegments(loaded, path));
+    assertSameChannel(loaded, channel);
+    ASSERT_EQ(loaded.m_persisted, loaded.size());
+    ASSERT_EQ(loaded.m_name, "Sensor_900");
+
+    // Many saves: the file is only compacted (in the background, appends going on meanwhile)
+    // once the appended segments add up to the size of the base
+    uint64_t compactions = segmentCompactor().m_compactions;
+    auto saveMore = [&](Timestamp from, Timestamp to) {
+        for (Timestamp t = from; t < to; t += 50) {
+            for (Timestamp i = t; i < t + 50; i++) channel.insert(DataPoint(i * kNanosPerMilli, i * 0.5));
+            ASSERT_EQ(saveSegment(channel), 50);
+        }
+    };
+    saveMore(1010, 1510);
+    ASSERT_EQ(segmentCompactor().m_compactions, compactions);
+    ASSERT_EQ(lineCount(path), 13);
+    saveMore(1510, 2510);
+    segmentCompactor().waitIdle();
+    ASSERT_GT(segmentCompactor().m_compactions, compactions);
+    ASSERT_LT(lineCount(path), 33);
+    ASSERT_LT(segmentCompactor().m_appendedBytes[path], segmentCompactor().m_baseBytes[path]);
+    ASSERT_TRUE(loadSegments(loaded, path));
+    assertSameChannel(loaded, channel);
+
+    // A new encoding rewrites the whole channel in one segment
+    channel.setEncoding(ValueEncoding(ValueCodec::Float));
+    ASSERT_EQ(saveSegment(channel), channel.size());
+    ASSERT_EQ(lineCount(path), 1);
+    ASSERT_TRUE(loadSegments(loaded, path));
+    ASSERT_EQ(loaded.m_values.m_encoding.codecName(), channel.m_values.m_encoding.codecName());
+    assertSameChannel(loaded, channel);
+}
+
+// Test suite for the snapshot + log recovery (lazy paging of the channels)
+TEST(RecoveredStoreTest, SnapshotAndLogTail) {
+
+    const std::string directory = "../storage/recovery_test";
+    std::filesystem::remove_all(directory);
+
+    ChannelLog log;
+    ASSERT_TRUE(log.open(directory));
+    std::unordered_map<uint16_t, DataChannel> channels;
+    auto store = [&](uint16_t id, Timestamp timestamp, double value) {
+        DataInput input(id, "Sensor_" + std::to_string(id), "Unit_" + std::to_string(id), DataPoint(timestamp, value));
+        if (channels.find(id) == channels.end()) channels.emplace(id, DataChannel(id, input.m_name, input.m_unit));
+        channels[id].insert(input.m_dp);
+        log.append(input);
+    };
+    for (Timestamp t = 0; t < 5000; t++) {
+        for (uint16_t id = 1; id <= 3; id++) store(id, t * 1000, t % 50 == 0 ? std::numeric_limits<double>::quiet_NaN() : t * id * 0.25);
+    }
+    ASSERT_TRUE(checkpoint(channels, log));
+    ASSERT_EQ(ChannelLog::sequences(directory), std::vector<uint64_t>{2});
+
+    // Log tail: more datapoints, a channel that only exists in the log and a torn last record
+    for (Timestamp t = 5000; t < 5100; t++) store(2, t * 1000, t * 0.5);
+    for (Timestamp t = 0; t < 10; t++) store(9, t * 1000, 1.0);
+    log.sync();
+    std::ofstream(ChannelLog::path(directory, log.m_sequence), std::ios::binary | std::ios::app).write("torn", 4);
+
+    RecoveredStore recovered;
+    ASSERT_TRUE(recovered.open(directory));
+    ASSERT_EQ(recovered.m_logSequence, 2);
+    ASSERT_EQ(recovered.ids(), (std::vector<uint16_t>{1, 2, 3, 9}));
+    ASSERT_EQ(recovered.m_replayed, 110);
+    ASSERT_TRUE(recovered.m_channels.empty());
+    // Only the header and the directory were read from the snapshot
+    ASSERT_LT(recovered.m_bytesRead, 400);
+    ASSERT_EQ(recovered.entry(2)->m_count, 5100);
+    ASSERT_EQ(recovered.entry(2)->m_lastTimestamp, 5099000);
+    ASSERT_EQ(recovered.entry(9)->m_name, "Sensor_9");
+
+    std::unordered_map<uint16_t, DataChannel>& loaded = recovered.load({2, 9});
+    ASSERT_EQ(loaded.size(), 2);
+    ASSERT_EQ(recovered.m_pagedIn, 2);
+    for (uint16_t id : {2, 9}) {
+        ASSERT_EQ(loaded[id].size(), channels[id].size());
+        for (size_t i = 0; i < channels[id].size(); i++) {
+            ASSERT_EQ(loaded[id].timestampAt(i), channels[id].timestampAt(i));
+            ASSERT_TRUE(customEquality(loaded[id].valueAt(i), channels[id].valueAt(i)));
+        }
+    }
+    auto subsets = retrieveChannelSubsets(loaded, {2}, 4990000, 5010000);
+    ASSERT_EQ(subsets[2].m_values.size(), 21);
+    ASSERT_EQ(recovered.channel(3).size(), 5000);
+    ASSERT_EQ(recovered.m_pagedIn, 3);
+
+    // Second checkpoint: only the rows stored since the first one are saved (from the late datapoint on for channel 1)
+    store(1, 4990500, -1.0);
+    ASSERT_TRUE(checkpoint(channels, log));
+    ASSERT_EQ(snapshotSequences(directory), (std::vector<uint64_t>{2, 3}));
+    ASSERT_EQ(log.m_compactions, 0);
+    const uint64_t deltaRows = 10 + 100 + 10; // channels 1, 2 and 9
+    ASSERT_EQ(std::filesystem::file_size(snapshotPath(directory, 3)), kSnapshotHeaderSize + deltaRows * 16 + 3 * (kSnapshotEntrySize + 14));
+
+    auto assertRecovered = [&]() {
+        RecoveredStore chain;
+        ASSERT_TRUE(chain.open(directory));
+        ASSERT_EQ(chain.m_logSequence, 3);
+        ASSERT_EQ(chain.m_replayed, 0);
+        ASSERT_EQ(chain.ids(), (std::vector<uint16_t>{1, 2, 3, 9}));
+        for (uint16_t id : chain.ids()) {
+            ASSERT_EQ(chain.entry(id)->m_count, channels[id].size());
+            ASSERT_EQ(chain.entry(id)->m_firstTimestamp, channels[id].timestampAt(0));
+            ASSERT_EQ(chain.entry(id)->m_lastTimestamp, channels[id].timestampAt(channels[id].size() - 1));
+            DataChannel& channel = chain.channel(id);
+            ASSERT_EQ(channel.size(), channels[id].size());
+            for (size_t i = 0; i < channel.size(); i++) {
+                ASSERT_EQ(channel.timestampAt(i), channels[id].timestampAt(i));
+                ASSERT_TRUE(customEquality(channel.valueAt(i), channels[id].valueAt(i)));
+            }
+        }
+    };
+    assertRecovered();
+
+    // Compaction merges the chain into a single full snapshot
+    ASSERT_TRUE(compactSnapshots(directory, 3));
+    ASSERT_EQ(snapshotSequences(directory), std::vector<uint64_t>{3});
+    ASSERT_EQ(std::filesystem::file_size(snapshotPath(directory, 3)), kSnapshotHeaderSize + (5001 + 5100 + 5000 + 10) * 16 + 4 * (kSnapshotEntrySize + 14));
+    assertRecovered();
+
+    // A checkpoint that can't write its snapshot is counted, keeps the log files and moves the watermarks back
+    store(3, 5000000, 7.0);
+    const std::string blocked = snapshotPath(directory, 4) + ".tmp";
+    std::filesystem::create_directory(blocked);
+    ASSERT_FALSE(checkpoint(channels, log));
+    ASSERT_EQ(log.m_checkpointFailures, 1);
+    ASSERT_EQ(channels[3].m_snapshotted, 5000);
+    ASSERT_EQ(ChannelLog::sequences(directory), (std::vector<uint64_t>{3, 4}));
+    std::filesystem::remove(blocked);
+    ASSERT_TRUE(checkpoint(channels, log));
+    ASSERT_EQ(channels[3].m_snapshotted, 5001);
+    ASSERT_EQ(ChannelLog::sequences(directory), std::vector<uint64_t>{5});
+    ASSERT_EQ(snapshotSequences(directory), (std::vector<uint64_t>{3, 5}));
+    RecoveredStore retried;
+    ASSERT_TRUE(retried.open(directory));
+    ASSERT_EQ(retried.m_logSequence, 5);
+    ASSERT_EQ(retried.channel(3).size(), 5001);
+    ASSERT_EQ(retried.channel(3).valueAt(5000), 7.0);
+}
+
+// Test suite for the FixedRateChannel class and the common query interface
+TEST(FixedRateChannelTest, ImplicitTimestampsAndGaps) {
+    const Timestamp period = FixedRate100Hz::kPeriod;
+    FixedRate100Hz fixed(1, "Sensor_1", "Unit_1");
+    DataChannel irregular(1, "Sensor_1", "Unit_1");
+    for (Timestamp i = 0; i < 3000; i++) {
+        if (i % 500 == 7) continue; // missed sample
+        double value = i % 300 == 0 ? std::nan("") : i * 0.25;
+        Timestamp jitter = (i % 3) * 1000; // snapped to the grid
+        ASSERT_TRUE(fixed.insert(DataPoint(5000 + i * period + jitter, value)));
+        irregular.insert(DataPoint(5000 + i * period, value));
+    }
+    ASSERT_EQ(fixed.m_start, 5000);
+    ASSERT_EQ(fixed.size(), 3000);
+    ASSERT_EQ(fixed.gapCount(), 6);
+    ASSERT_FALSE(fixed.isPresent(507));
+    ASSERT_TRUE(std::isnan(fixed.valueAt(507)));
+    ASSERT_EQ(fixed.timestampAt(2999), 5000 + 2999 * period);
+    ASSERT_LT(fixed.memoryBytes(), irregular.memoryBytes());
+
+    // Rejected: before the start, slot already filled. A late sample fills its gap
+    ASSERT_FALSE(fixed.insert(DataPoint(0, 1.0)));
+    ASSERT_FALSE(fixed.insert(DataPoint(5000 + 10 * period, 1.0)));
+    ASSERT_EQ(fixed.m_rejected, 2);
+    ASSERT_TRUE(fixed.insert(DataPoint(5000 + 2507 * period, 2507 * 0.25)));
+    ASSERT_EQ(fixed.gapCount(), 5);
+    ASSERT_EQ(fixed.valueAt(2507), 2507 * 0.25);
+
+    // O(1) bounds agree with a scan of the implicit timestamps
+    for (Timestamp t : {Timestamp(0), Timestamp(5000), Timestamp(5001), 5000 + 42 * period, 5000 + 42 * period + 1,
+                        5000 + 2999 * period, 5000 + 4000 * period}) {
+        size_t below = 0, atOrBelow = 0;
+        for (size_t i = 0; i < fixed.size(); i++) {
+            below += fixed.timestampAt(i) < t;
+            atOrBelow += fixed.timestampAt(i) <= t;
+        }
+        ASSERT_EQ(fixed.lowerBound(t), below);
+        ASSERT_EQ(fixed.upperBound(t), atOrBelow);
+    }
+
+    // Both layouts answer the same range query; gaps count as omitted datapoints
+    std::unordered_map<uint16_t, FixedRate100Hz> fixedChannels;
+    fixedChannels.emplace(1, std::move(fixed));
+    Timestamp lower = 5000 + 250 * period, upper = 5000 + 1250 * period;
+    std::unordered_map<uint16_t, DataChannel> irregularChannels;
+    irregularChannels[1] = std::move(irregular);
+    irregularChannels[1].insert(DataPoint(5000 + 2507 * period, 2507 * 0.25));
+    auto fixedSubsets = retrieveChannelSubsets(fixedChannels, {1, 2}, lower, upper);
+    auto irregularSubsets = retrieveChannelSubsets(irregularChannels, {1}, lower, upper);
+    ASSERT_EQ(fixedSubsets.size(), 1);
+    ASSERT_EQ(fixedSubsets[1].m_timestamps, irregularSubsets[1].m_timestamps);
+    ASSERT_EQ(fixedSubsets[1].m_values, irregularSubsets[1].m_values);
+    ASSERT_EQ(fixedSubsets[1].m_rangeSize, 1001);
+    ASSERT_EQ(fixedSubsets[1].m_nanCount, irregularSubsets[1].m_nanCount + 2);
+    ASSERT_EQ(fixedSubsets[1].nanPositions(), (std::vector<size_t>{50, 257, 350, 650, 757, 950}));
+
+    // The generic extraction also works on the irregular layout
+    auto generic = extractSubset(irregularChannels[1], lower, upper);
+    ASSERT_EQ(generic.m_timestamps, irregularSubsets[1].m_timestamps);
+    ASSERT_EQ(generic.m_nanMask, irregularSubsets[1].m_nanMask);
+}
+
+// Test suite for the lock-free latest-value table and the "as of" query
+TEST(LatestValueTableTest, ConsistentReadsAndAsOf) {
+    LatestValueTable table(8);
+    ASSERT_FALSE(table.latest(3).has_value());
+    ASSERT_TRUE(table.update(3, DataPoint(100, 1.5)));
+    ASSERT_FALSE(table.update(3, DataPoint(50, 9.0))); // older, ignored
+    ASSERT_FALSE(table.update(8, DataPoint(100, 1.0))); // beyond the capacity
+    ASSERT_EQ(table.latest(3)->m_timestamp, 100);
+    ASSERT_EQ(table.latest(3)->m_value, 1.5);
+    ASSERT_FALSE(table.latest(8).has_value());
+
+    // A reader never sees a timestamp and a value from different updates (checked after the join)
+    std::atomic<bool> writing{true};
+    std::thread writer([&] {
+        for (Timestamp t = 101; t < 200000; t++) table.update(5, DataPoint(t, 2.0 * t));
+        writing = false;
+    });
+    Timestamp previous = 0;
+    uint64_t reads = 0, torn = 0, regressions = 0;
+    while (writing || reads == 0) {
+        std::optional<DataPoint> dp = table.latest(5);
+        reads++;
+        if (!dp) continue;
+        if (dp->m_value != 2.0 * dp->m_timestamp) torn++;
+        if (dp->m_timestamp < previous) regressions++;
+        previous = dp->m_timestamp;
+    }
+    writer.join();
+    ASSERT_EQ(torn, 0);
+    ASSERT_EQ(regressions, 0);
+    ASSERT_EQ(table.latest(5)->m_timestamp, 199999);
+
+    // The collectors publish the newest stored datapoint of every channel: datapoint t of
+    // channel id is (t us, 1000 * id + t), except a NaN at 250 us on channel 4
+    DataQueue queue;
+    std::unordered_map<uint16_t, DataChannel> channels;
+    LatestValueTable latest;
+    std::vector<DataInput> inputs;
+    for (Timestamp t = 1; t <= 500; t++) {
+        inputs.clear();
+        for (uint16_t id = 0; id < 6; id++) {
+            double value = id == 4 && t == 250 ? std::nan("") : 1000.0 * id + t;
+            inputs.emplace_back(id, "Sensor_" + std::to_string(id), "Unit_" + std::to_string(id), DataPoint(t * 1000, value));
+        }
+        queue.pushBatch(inputs);
+    }
+    inputs.clear();
+    inputs.emplace_back(2, "Sensor_2", "Unit_2", DataPoint(250500, 42.0)); // late datapoint
+    queue.pushBatch(inputs);
+    queue.close();
+    dataCollectorBatched(queue, channels, 0, nullptr, nullptr, &latest);
+
+    std::vector<uint16_t> ids = {0, 1, 2, 3, 4, 5, 77};
+    std::vector<DataPoint> values(ids.size());
+    ASSERT_EQ(latest.latest(ids, values), 6);
+    for (uint16_t id = 0; id < 6; id++) {
+        ASSERT_EQ(values[id].m_timestamp, 500000); // the late datapoint is not the latest
+        ASSERT_EQ(values[id].m_value, 1000.0 * id + 500);
+    }
+    ASSERT_EQ(values[6].m_timestamp, 0);
+    ASSERT_TRUE(std::isnan(values[6].m_value));
+
+    // As-of query: one datapoint per channel, at or before the timestamp
+    ASSERT_EQ(retrieveChannelsAsOf(channels, ids, 0, values), 0);
+    for (const DataPoint& dp : values) {
+        ASSERT_EQ(dp.m_timestamp, 0);
+        ASSERT_TRUE(std::isnan(dp.m_value));
+    }
+    ASSERT_EQ(retrieveChannelsAsOf(channels, ids, 250499, values), 6);
+    for (uint16_t id = 0; id < 6; id++) {
+        ASSERT_EQ(values[id].m_timestamp, 250000);
+        if (id == 4) {
+            ASSERT_TRUE(std::isnan(values[id].m_value));
+        } else {
+            ASSERT_EQ(values[id].m_value, 1000.0 * id + 250);
+        }
+    }
+    ASSERT_EQ(retrieveChannelsAsOf(channels, ids, 250500, values), 6);
+    ASSERT_EQ(values[2].m_timestamp, 250500);
+    ASSERT_EQ(values[2].m_value, 42.0);
+    ASSERT_EQ(values[3].m_timestamp, 250000);
+    ASSERT_EQ(values[3].m_value, 3250.0);
+    ASSERT_EQ(retrieveChannelsAsOf(channels, ids, 10000000, values), 6);
+    for (uint16_t id = 0; id < 6; id++) {
+        ASSERT_EQ(values[id].m_timestamp, 500000);
+        ASSERT_EQ(values[id].m_value, 1000.0 * id + 500);
+    }
+    ASSERT_EQ(values[6].m_timestamp, 0);
+    ASSERT_EQ(channels.at(1).asOf(1500)->m_timestamp, 1000);
+    ASSERT_FALSE(channels.at(1).asOf(999).has_value());
+}
+
+// Test suite for the query result cache and its append-aware invalidation
+TEST(QueryCacheTest, HitsAndAppendAwareInvalidation) {
+    std::unordered_map<uint16_t, DataChannel> channels;
+    for (uint16_t id = 0; id < 3; id++) channels.emplace(id, DataChannel(id, "Sensor_" + std::to_string(id), "Unit"));
+    for (Timestamp t = 0; t < 5000; t++) {
+        for (uint16_t id = 0; id < 3; id++) channels[id].insert(DataPoint(fromMilliseconds(t), id + 0.5 * t));
+    }
+    QueryCache cache;
+    std::vector<uint16_t> ids = {0, 1, 2};
+    Timestamp historyEnd = fromMilliseconds(1000);
+    Timestamp tailEnd = fromMilliseconds(100000);
+
+    // Repeated windows are served from the cache, without copies
+    auto history = cache.retrieveChannelSubsets(channels, ids, 0, historyEnd);
+    auto tail = cache.retrieveChannelSubsets(channels, ids, fromMilliseconds(4500), tailEnd);
+    auto again = cache.retrieveChannelSubsets(channels, ids, 0, historyEnd);
+    ASSERT_EQ(cache.m_misses, 6);
+    ASSERT_EQ(cache.m_hits, 3);
+    ASSERT_EQ(again.at(1).get(), history.at(1).get());
+    auto reference = retrieveChannelSubsets(channels, ids, 0, historyEnd);
+    ASSERT_EQ(history.at(1)->m_values, reference.at(1).m_values);
+    ASSERT_EQ(cache.size(), 6);
+    ASSERT_GT(cache.memoryBytes(), 3 * 1001 * 2 * sizeof(double));
+
+    // Appends only invalidate the ranges covering the tail
+    channels[1].insert(DataPoint(fromMilliseconds(5000), 7.0));
+    again = cache.retrieveChannelSubsets(channels, ids, 0, historyEnd);
+    ASSERT_EQ(again.at(1).get(), history.at(1).get());
+    auto newTail = cache.retrieveChannelSubsets(channels, ids, fromMilliseconds(4500), tailEnd);
+    ASSERT_EQ(newTail.at(0).get(), tail.at(0).get());
+    ASSERT_NE(newTail.at(1).get(), tail.at(1).get());
+    ASSERT_EQ(newTail.at(1)->m_values.back(), 7.0);
+    ASSERT_EQ(cache.m_invalidations, 1);
+
+    // A late datapoint in an open range invalidates it too, before or in the range
+    channels[2].insert(DataPoint(fromMilliseconds(4600) + 1, 3.0));
+    newTail = cache.retrieveChannelSubsets(channels, ids, fromMilliseconds(4500), tailEnd);
+    ASSERT_EQ(newTail.at(2)->m_values.size(), tail.at(2)->m_values.size() + 1);
+    ASSERT_EQ(cache.m_invalidations, 2);
+
+    // Aggregates are cached the same way
+    auto aggregates = cache.retrieveChannelAggregates(channels, ids, 0, historyEnd);
+    auto expected = retrieveChannelAggregates(channels, ids, 0, historyEnd);
+    ASSERT_EQ(aggregates.at(2).m_sum, expected.at(2).m_sum);
+    uint64_t hits = cache.m_hits;
+    cache.retrieveChannelAggregates(channels, ids, 0, historyEnd);
+    ASSERT_EQ(cache.m_hits, hits + 3);
+
+    // History changes need an explicit invalidation
+    channels[0].truncate(10);
+    cache.invalidate(0);
+    ASSERT_EQ(cache.retrieveChannelSubsets(channels, {0}, 0, historyEnd).at(0)->m_values.size(), 10);
+    ASSERT_GT(cache.hitRate(), 0.0);
+    ASSERT_LT(cache.hitRate(), 1.0);
+
+    // The least recently used entries are evicted past the memory bound
+    QueryCache small(3 * 1024);
+    for (Timestamp start = 0; start < 10; start++) {
+        small.retrieveChannelSubsets(channels, {1}, fromMilliseconds(100 * start), fromMilliseconds(100 * start + 20));
+    }
+    ASSERT_GT(small.m_evictions, 0);
+    ASSERT_LE(small.memoryBytes(), small.m_maxBytes);
+    uint64_t misses = small.m_misses;
+    small.retrieveChannelSubsets(channels, {1}, fromMilliseconds(900), fromMilliseconds(920));
+    small.retrieveChannelSubsets(channels, {1}, 0, fromMilliseconds(20));
+    ASSERT_EQ(small.m_misses, misses + 1);
+}
+
+// Test suite for the absolute-deadline acquisition scheduler
+TEST(DeadlineSchedulerTest, ExactRatesAndBatchedTicks) {
+    DeadlineScheduler scheduler;
+    scheduler.addChannel(0, 200.0);
+    scheduler.addChannel(1, 200.0);
+    scheduler.addChannel(2, 50.0);
+    scheduler.addChannel(3, 30.0); // doesn't divide the other rates
+    ASSERT_EQ(scheduler.m_streams.size(), 3);
+
+    std::unordered_map<uint16_t, std::vector<Timestamp>> samples;
+    Timestamp previous = -1;
+    size_t batched = 0;
+    const Timestamp duration = fromMilliseconds(300);
+    uint64_t scheduled = scheduler.run(duration, [&](Timestamp deadline, const std::vector<uint16_t>& due) {
+        ASSERT_GT(deadline, previous);
+        previous = deadline;
+        batched += due.size() > 2;
+        for (uint16_t id : due) samples[id].push_back(deadline);
+    });
+
+    // Every sample at its nominal deadline, none lost however late the thread woke up
+    ASSERT_EQ(samples[0].size(), 60);
+    ASSERT_EQ(samples[1].size(), 60);
+    ASSERT_EQ(samples[2].size(), 15);
+    ASSERT_EQ(samples[3].size(), 9);
+    ASSERT_EQ(scheduled, 60 + 60 + 15 + 9);
+    for (size_t k = 0; k < samples[3].size(); k++) ASSERT_EQ(samples[3][k], DeadlineScheduler::deadline(30.0, k));
+    ASSERT_EQ(samples[2][7], fromMilliseconds(140));
+    ASSERT_EQ(batched, 15); // the 50 hz samples share the 200 hz ticks
+    ASSERT_EQ(scheduler.m_ticks, 60 + 9 - 3);
+    ASSERT_EQ(scheduler.m_wakeLateness.m_count, scheduler.m_ticks);
+    ASSERT_EQ(scheduler.m_streams[0].m_periodJitter.m_count, 59);
+    ASSERT_EQ(scheduler.periodJitter().m_count, 59 + 14 + 8);
+
+    // Histogram buckets and percentiles
+    JitterHistogram histogram;
+    for (Timestamp error : {Timestamp(500), Timestamp(-1500), Timestamp(3000), Timestamp(100 * kNanosPerMicro)}) histogram.record(error);
+    ASSERT_EQ(histogram.m_counts[0], 1);
+    ASSERT_EQ(histogram.m_counts[1], 1);
+    ASSERT_EQ(histogram.m_counts[2], 1);
+    ASSERT_EQ(histogram.m_counts[7], 1);
+    ASSERT_EQ(histogram.m_max, 100 * kNanosPerMicro);
+    ASSERT_EQ(histogram.percentile(50.0), 2 * kNanosPerMicro);
+    ASSERT_EQ(histogram.percentile(100.0), 100 * kNanosPerMicro);
+
+    // Per-channel rates from the generator config, paced and unpaced
+    GeneratorConfig config;
+    config.m_numChannels = 4;
+    config.m_channelRates = {100.0, 40.0, 40.0, 10.0};
+    config.m_duration = 200.0;
+    config.m_seed = 3;
+    DataQueue queue;
+    ASSERT_EQ(dataGenerator(queue, config), 20 + 8 + 8 + 2);
+    config.m_paced = false;
+    ASSERT_EQ(dataGenerator(queue, config), 20 + 8 + 8 + 2);
+}
+
+// Allocation counting hook: operator new has to be replaced for the whole binary, but it
+// only counts on threads inside an AllocationScope, so the other tests are unaffected.
+static std::atomic<uint64_t> countedAllocations{0};
+static thread_local bool countingAllocations = false;
+
+struct AllocationScope {
+    AllocationScope() { countingAllocations = true; }
+    ~AllocationScope() { countingAllocations = false; }
+};
+
+void* operator new(std::size_t size) {
+    if (countingAllocations) countedAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Test suite for allocation-free ingest and queries
+TEST(AllocationTest, SteadyStateIngestAndQuery) {
+    const uint16_t numChannels = 8;
+    const Timestamp warmupTicks = 256, ticks = 4096;
+    std::unordered_map<uint16_t, DataChannel> channels;
+    for (uint16_t id = 0; id < numChannels; id++) {
+        channels.emplace(id, DataChannel(id, "Sensor_" + std::to_string(id), "Unit_" + std::to_string(id)));
+        channels[id].reserve(warmupTicks + ticks);
+    }
+    DataQueue dataQueue;
+    LatestValueTable latest;
+    std::mutex mtx;
+    std::thread collector([&] {
+        AllocationScope scope;
+        dataCollectorBatched(dataQueue, channels, 0, &mtx, nullptr, &latest);
+    });
+
+    // The producer (this thread) generates the inputs (with their name and unit strings) and
+    // waits until the collector has stored each tick, so batches never exceed one tick
+    AllocationScope scope;
+    std::vector<DataInput> inputs;
+    inputs.reserve(numChannels);
+    std::mt19937 gen(7);
+    auto ingest = [&](Timestamp from, Timestamp to) {
+        for (Timestamp t = from; t < to; t++) {
+            inputs.clear();
+            generateDataInputs(t * 1000, inputs, 0, numChannels, gen, 0.05);
+            dataQueue.pushBatch(inputs);
+            std::optional<DataPoint> stored;
+            while (!(stored = latest.latest(numChannels - 1)) || stored->m_timestamp != t * 1000) std::this_thread::yield();
+        }
+    };
+
+    // Warm-up fills the queue's pool, then ingest runs without touching the heap
+    ingest(0, warmupTicks);
+    uint64_t before = countedAllocations.load();
+    uint64_t warmupAllocations = before;
+    ingest(warmupTicks, warmupTicks + ticks);
+    uint64_t ingestAllocations = countedAllocations.load() - before;
+    dataQueue.close();
+    collector.join();
+    ASSERT_GT(warmupAllocations, 0); // the hook does count (pool growth, the collector's timer)
+    ASSERT_EQ(ingestAllocations, 0);
+    ASSERT_EQ(channels[3].size(), warmupTicks + ticks);
+
+    // A query into a stack arena does not allocate either
+    std::vector<uint16_t> ids = {1, 5};
+    std::array<std::byte, 256 * 1024> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    SubChannelMap subsets(&arena);
+    before = countedAllocations.load();
+    retrieveChannelSubsets(channels, ids, 100000, 2100000, subsets);
+    ASSERT_EQ(countedAllocations.load() - before, 0);
+
+    auto reference = retrieveChannelSubsets(channels, ids, 100000, 2100000);
+    for (uint16_t id : ids) {
+        ASSERT_EQ(subsets.at(id).m_timestamps, reference.at(id).m_timestamps);
+        ASSERT_EQ(subsets.at(id).m_nanCount, reference.at(id).m_nanCount);
+        ASSERT_EQ(subsets.at(id).m_timestamps.get_allocator().resource(), &arena);
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
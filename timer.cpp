@@ -21,4 +21,13 @@ Timer::~Timer() {
         std::unique_lock<std::mutex> lock(printMtx);
         std::cout << "Timer for " << m_name << ": " << (m_nanos / 1e6) << " ms" << std::endl;
     }
+}
+
+/**
+ * @brief Milliseconds elapsed since the timer started.
+ */
+
+double Timer::elapsed() const {
+    auto now = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count() / 1e6;
 }
\ No newline at end of file
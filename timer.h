@@ -26,6 +26,8 @@ class Timer {
     
         Timer(const std::string& name);
         ~Timer();
+
+        double elapsed() const;
 };
 
 #endif // TIMER_H
\ No newline at end of file
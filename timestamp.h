@@ -0,0 +1,28 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Timestamps: integer nanoseconds since the start of the generation.
+ * 
+ * Integer timestamps compare exactly and keep their resolution however
+ * long the run is. Configuration and printed output use milliseconds,
+ * converted with fromMilliseconds / toMilliseconds.
+ */
+
+using Timestamp = int64_t;
+
+constexpr Timestamp kNanosPerMicro = 1000;
+constexpr Timestamp kNanosPerMilli = 1000000;
+
+inline Timestamp fromMilliseconds(double milliseconds) {
+    return static_cast<Timestamp>(std::llround(milliseconds * kNanosPerMilli));
+}
+
+inline double toMilliseconds(Timestamp timestamp) {
+    return static_cast<double>(timestamp) / kNanosPerMilli;
+}
+
+#endif // TIMESTAMP_H
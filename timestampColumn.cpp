@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <limits>
+
+#include "timestampColumn.h"
+
+static constexpr Timestamp kMaxOffset = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief First position in [first, last) where before(element, value) is false.
+ * 
+ * @details Interpolation search for near-uniform sorted data: the
+ * position is predicted from the values at both ends, then the bound
+ * is bracketed by galloping from the prediction (1, 2, 4... positions
+ * away) and found by a binary search inside the bracket. Evenly spaced
+ * timestamps are found in a couple of probes close to each other; a
+ * bad prediction costs at most two binary searches.
+ */
+
+template <typename Iterator, typename Value, typename Before>
+static Iterator interpolationSearch(Iterator first, Iterator last, Value value, Before before) {
+    if (first == last || !before(*first, value)) return first;
+    if (before(*(last - 1), value)) return last;
+
+    // *first is before the value and *(last - 1) is not: the bound is in (first, last - 1]
+    size_t low = 1, high = static_cast<size_t>(last - first) - 1;
+    double span = static_cast<double>(*(last - 1)) - static_cast<double>(*first);
+    double fraction = (static_cast<double>(value) - static_cast<double>(*first)) / span;
+    size_t guess = std::clamp(static_cast<size_t>(fraction * high), low, high);
+
+    if (before(first[guess], value)) {
+        low = guess + 1;
+        for (size_t step = 1; guess + step < high; step *= 2) {
+            if (!before(first[guess + step], value)) {
+                high = guess + step;
+                break;
+            }
+            low = guess + step + 1;
+        }
+    } else {
+        high = guess;
+        for (size_t step = 1; step <= guess - low; step *= 2) {
+            if (before(first[guess - step], value)) {
+                low = guess - step + 1;
+                break;
+            }
+            high = guess - step;
+        }
+    }
+    return std::partition_point(first + low, first + high, [&](const auto& element) { return before(element, value); });
+}
+
+static bool lessThan(Timestamp element, Timestamp value) { return element < value; }
+static bool lessEqual(Timestamp element, Timestamp value) { return element <= value; }
+
+size_t TimestampColumn::size() const {
+    return m_offsets.size();
+}
+
+bool TimestampColumn::empty() const {
+    return m_offsets.empty();
+}
+
+void TimestampColumn::reserve(size_t size) {
+    m_bases.reserve(size / kChunkSize + 1);
+    m_starts.reserve(size / kChunkSize + 1);
+    m_offsets.reserve(size);
+    m_blockChunks.reserve(size / kChunkSize + 1);
+}
+
+/**
+ * @brief Append a timestamp (must not be older than the last one).
+ */
+
+void TimestampColumn::push_back(Timestamp timestamp) {
+    size_t index = m_offsets.size();
+    if (index % kChunkSize == 0 || timestamp < m_bases.back() || timestamp - m_bases.back() > kMaxOffset) {
+        m_bases.push_back(timestamp);
+        m_starts.push_back(index);
+        if (index % kChunkSize == 0) m_blockChunks.push_back(m_starts.size() - 1);
+    }
+    m_offsets.push_back(static_cast<uint32_t>(timestamp - m_bases.back()));
+}
+
+Timestamp TimestampColumn::get(size_t index) const {
+    return m_bases[chunkOf(index)] + m_offsets[index];
+}
+
+Timestamp TimestampColumn::back() const {
+    return m_bases.back() + m_offsets.back();
+}
+
+/**
+ * @brief Keep only the first size timestamps.
+ */
+
+void TimestampColumn::truncate(size_t size) {
+    if (size >= m_offsets.size()) return;
+    m_offsets.resize(size);
+    while (!m_starts.empty() && m_starts.back() >= size) {
+        m_starts.pop_back();
+        m_bases.pop_back();
+    }
+    m_blockChunks.resize((size + kChunkSize - 1) / kChunkSize);
+}
+
+void TimestampColumn::clear() {
+    m_bases.clear();
+    m_starts.clear();
+    m_offsets.clear();
+    m_blockChunks.clear();
+}
+
+/**
+ * @brief Index of the first timestamp >= the given one.
+ * 
+ * @details The answer lies in the last chunk whose base is smaller
+ * than the timestamp (or is the start of the next chunk). Both the
+ * chunk and the offset within it are located by interpolation search.
+ */
+
+size_t TimestampColumn::lowerBound(Timestamp timestamp) const {
+    size_t chunk = interpolationSearch(m_bases.begin(), m_bases.end(), timestamp, lessThan) - m_bases.begin();
+    if (chunk == 0) return 0;
+    chunk--;
+    Timestamp offset = timestamp - m_bases[chunk];
+    if (offset > kMaxOffset) return chunkEnd(chunk);
+    auto first = m_offsets.begin() + m_starts[chunk];
+    auto last = m_offsets.begin() + chunkEnd(chunk);
+    return interpolationSearch(first, last, offset, lessThan) - m_offsets.begin();
+}
+
+/**
+ * @brief Index of the first timestamp > the given one.
+ * 
+ * @details The answer lies in the last chunk whose base is smaller
+ * than or equal to the timestamp (or is the start of the next chunk).
+ */
+
+size_t TimestampColumn::upperBound(Timestamp timestamp) const {
+    size_t chunk = interpolationSearch(m_bases.begin(), m_bases.end(), timestamp, lessEqual) - m_bases.begin();
+    if (chunk == 0) return 0;
+    chunk--;
+    Timestamp offset = timestamp - m_bases[chunk];
+    if (offset >= kMaxOffset) return chunkEnd(chunk);
+    auto first = m_offsets.begin() + m_starts[chunk];
+    auto last = m_offsets.begin() + chunkEnd(chunk);
+    return interpolationSearch(first, last, offset, lessEqual) - m_offsets.begin();
+}
+
+/**
+ * @brief Decode the timestamps in [first, last) into out.
+ */
+
+void TimestampColumn::decode(size_t first, size_t last, Timestamp* out) const {
+    if (first >= last) return;
+    size_t index = first;
+    for (size_t chunk = chunkOf(first); index < last; chunk++) {
+        size_t end = std::min(last, chunkEnd(chunk));
+        Timestamp base = m_bases[chunk];
+        for (; index < end; index++) out[index - first] = base + m_offsets[index];
+    }
+}
+
+/**
+ * @brief Memory used by the column (capacities).
+ */
+
+size_t TimestampColumn::memoryBytes() const {
+    return m_bases.capacity() * sizeof(Timestamp) 
+         + m_starts.capacity() * sizeof(size_t) 
+         + m_offsets.capacity() * sizeof(uint32_t)
+         + m_blockChunks.capacity() * sizeof(size_t);
+}
+
+/**
+ * @brief Chunk holding an index.
+ * 
+ * @details The chunks of the index's kChunkSize block are
+ * [m_blockChunks[block], first chunk of the next block): usually just
+ * one, otherwise the last one starting at or before the index.
+ */
+
+size_t TimestampColumn::chunkOf(size_t index) const {
+    size_t block = index / kChunkSize;
+    size_t first = m_blockChunks[block];
+    size_t last = block + 1 < m_blockChunks.size() ? m_blockChunks[block + 1] : m_starts.size();
+    if (last - first == 1) return first;
+    return std::upper_bound(m_starts.begin() + first, m_starts.begin() + last, index) - m_starts.begin() - 1;
+}
+
+size_t TimestampColumn::chunkEnd(size_t chunk) const {
+    return chunk + 1 < m_starts.size() ? m_starts[chunk + 1] : m_offsets.size();
+}
@@ -0,0 +1,60 @@
+#ifndef TIMESTAMPCOLUMN_H
+#define TIMESTAMPCOLUMN_H
+
+#include <cstdint>
+#include <vector>
+
+#include "timestamp.h"
+
+/**
+ * @class TimestampColumn
+ * 
+ * @brief Sorted timestamps of a channel, stored as chunk base + 32 bit offset.
+ * 
+ * Timestamp i is m_bases[c] + m_offsets[i], c being the chunk holding
+ * i (chunk c starts at index m_starts[c]). A new chunk starts every
+ * kChunkSize timestamps and whenever the offset would not fit in 32
+ * bits (~4.29 s), so a timestamp costs 4 bytes instead of 8. Searches
+ * first look for the chunk in the small m_bases vector and then only
+ * compare 32 bit offsets within that chunk. Both levels use an
+ * interpolation search (timestamps are close to evenly spaced) with a
+ * bounded fallback to binary search.
+ * 
+ * Every kChunkSize-aligned index starts a chunk, so m_blockChunks[b]
+ * (the chunk starting at b * kChunkSize) finds the chunk of an index
+ * in O(1); only blocks split by an offset overflow need a search among
+ * their own few chunks. get() and the full scans calling it for every
+ * row therefore stay linear.
+ * 
+ */
+
+class TimestampColumn {
+
+    public:
+        static constexpr size_t kChunkSize = 1024;
+
+        std::vector<Timestamp> m_bases;
+        std::vector<size_t> m_starts;
+        std::vector<uint32_t> m_offsets;
+        std::vector<size_t> m_blockChunks;
+
+        TimestampColumn() = default;
+
+        size_t size() const;
+        bool empty() const;
+        void reserve(size_t size);
+        void push_back(Timestamp timestamp);
+        Timestamp get(size_t index) const;
+        Timestamp back() const;
+        void truncate(size_t size);
+        void clear();
+        size_t lowerBound(Timestamp timestamp) const;
+        size_t upperBound(Timestamp timestamp) const;
+        void decode(size_t first, size_t last, Timestamp* out) const;
+        size_t memoryBytes() const;
+
+        size_t chunkOf(size_t index) const;
+        size_t chunkEnd(size_t chunk) const;
+};
+
+#endif // TIMESTAMPCOLUMN_H
@@ -0,0 +1,19 @@
+#include <algorithm>
+#include <limits>
+
+#include "valueAggregate.h"
+
+ValueAggregate::ValueAggregate()
+    : m_min(std::numeric_limits<double>::infinity()),
+      m_max(-std::numeric_limits<double>::infinity()) {}
+
+void ValueAggregate::merge(const ValueAggregate& other) {
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+double ValueAggregate::mean() const {
+    return m_count > 0 ? m_sum / m_count : std::numeric_limits<double>::quiet_NaN();
+}
@@ -0,0 +1,30 @@
+#ifndef VALUEAGGREGATE_H
+#define VALUEAGGREGATE_H
+
+#include <cstdint>
+
+/**
+ * @class ValueAggregate
+ * 
+ * @brief Count, sum, minimum and maximum of the valid values of a range.
+ * 
+ * NaN values are not counted. Aggregates of consecutive ranges can
+ * be merged. An empty aggregate has m_min > m_max and a NaN mean.
+ * 
+ */
+
+class ValueAggregate {
+
+    public:
+        uint64_t m_count = 0;
+        double m_sum = 0.0;
+        double m_min;
+        double m_max;
+
+        ValueAggregate();
+
+        void merge(const ValueAggregate& other);
+        double mean() const;
+};
+
+#endif // VALUEAGGREGATE_H
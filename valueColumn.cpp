@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+
+#include "valueColumn.h"
+
+size_t ValueColumn::size() const {
+    switch (m_encoding.m_codec) {
+        case ValueCodec::Double: return m_doubles.size();
+        case ValueCodec::Float: return m_floats.size();
+        case ValueCodec::Scaled16: return m_scaled.size();
+    }
+    return 0;
+}
+
+void ValueColumn::reserve(size_t size) {
+    switch (m_encoding.m_codec) {
+        case ValueCodec::Double: m_doubles.reserve(size); break;
+        case ValueCodec::Float: m_floats.reserve(size); break;
+        case ValueCodec::Scaled16: m_scaled.reserve(size); break;
+    }
+}
+
+void ValueColumn::push_back(double value) {
+    switch (m_encoding.m_codec) {
+        case ValueCodec::Double: m_doubles.push_back(value); break;
+        case ValueCodec::Float: m_floats.push_back(static_cast<float>(value)); break;
+        case ValueCodec::Scaled16: m_scaled.push_back(m_encoding.encodeScaled(value)); break;
+    }
+}
+
+double ValueColumn::get(size_t index) const {
+    switch (m_encoding.m_codec) {
+        case ValueCodec::Double: return m_doubles[index];
+        case ValueCodec::Float: return m_floats[index];
+        case ValueCodec::Scaled16: return m_encoding.decodeScaled(m_scaled[index]);
+    }
+    return 0.0;
+}
+
+void ValueColumn::truncate(size_t size) {
+    switch (m_encoding.m_codec) {
+        case ValueCodec::Double: m_doubles.resize(std::min(size, m_doubles.size())); break;
+        case ValueCodec::Float: m_floats.resize(std::min(size, m_floats.size())); break;
+        case ValueCodec::Scaled16: m_scaled.resize(std::min(size, m_scaled.size())); break;
+    }
+}
+
+void ValueColumn::clear() {
+    m_doubles.clear();
+    m_floats.clear();
+    m_scaled.clear();
+}
+
+/**
+ * @brief Decode the values in [first, last) into out.
+ */
+
+void ValueColumn::decode(size_t first, size_t last, double* out) const {
+    switch (m_encoding.m_codec) {
+        case ValueCodec::Double:
+            std::copy(m_doubles.begin() + first, m_doubles.begin() + last, out);
+            break;
+        case ValueCodec::Float:
+            for (size_t i = first; i < last; i++) *out++ = m_floats[i];
+            break;
+        case ValueCodec::Scaled16:
+            for (size_t i = first; i < last; i++) *out++ = m_encoding.decodeScaled(m_scaled[i]);
+            break;
+    }
+}
+
+/**
+ * @brief Aggregate of the valid values in [first, last).
+ * 
+ * @details Branch-free loops over the stored type. For Scaled16 the
+ * raw integers are summed in 64 bits and their minimum / maximum are
+ * found on the raw values (the NaN sentinel is the smallest raw value,
+ * so it is replaced for the minimum only); the scale and offset are
+ * applied once to the results.
+ */
+
+ValueAggregate ValueColumn::aggregate(size_t first, size_t last) const {
+    ValueAggregate result;
+    if (first >= last) return result;
+
+    switch (m_encoding.m_codec) {
+        case ValueCodec::Double:
+        case ValueCodec::Float: {
+            double sum = 0.0;
+            double minValue = result.m_min;
+            double maxValue = result.m_max;
+            uint64_t count = 0;
+            auto kernel = [&](const auto* values) {
+                for (size_t i = first; i < last; i++) {
+                    double value = values[i];
+                    bool valid = !std::isnan(value);
+                    count += valid;
+                    sum += valid ? value : 0.0;
+                    minValue = valid ? std::min(minValue, value) : minValue;
+                    maxValue = valid ? std::max(maxValue, value) : maxValue;
+                }
+            };
+            if (m_encoding.m_codec == ValueCodec::Double) kernel(m_doubles.data());
+            else kernel(m_floats.data());
+            result.m_count = count;
+            result.m_sum = sum;
+            result.m_min = minValue;
+            result.m_max = maxValue;
+            break;
+        }
+        case ValueCodec::Scaled16: {
+            int64_t rawSum = 0;
+            int16_t rawMin = INT16_MAX;
+            int16_t rawMax = ValueEncoding::kScaledNan;
+            uint64_t count = 0;
+            for (size_t i = first; i < last; i++) {
+                int16_t raw = m_scaled[i];
+                bool valid = raw != ValueEncoding::kScaledNan;
+                count += valid;
+                rawSum += valid ? raw : 0;
+                rawMin = std::min<int16_t>(rawMin, valid ? raw : INT16_MAX);
+                rawMax = std::max(rawMax, raw);
+            }
+            if (count == 0) break;
+            double low = m_encoding.m_offset + m_encoding.m_scale * rawMin;
+            double high = m_encoding.m_offset + m_encoding.m_scale * rawMax;
+            result.m_count = count;
+            result.m_sum = m_encoding.m_offset * count + m_encoding.m_scale * static_cast<double>(rawSum);
+            result.m_min = std::min(low, high);
+            result.m_max = std::max(low, high);
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Change the codec, re-encoding the stored values.
+ */
+
+void ValueColumn::setEncoding(const ValueEncoding& encoding) {
+    std::vector<double> values(size());
+    decode(0, values.size(), values.data());
+    std::vector<double>().swap(m_doubles);
+    std::vector<float>().swap(m_floats);
+    std::vector<int16_t>().swap(m_scaled);
+    m_encoding = encoding;
+    reserve(values.size());
+    for (double value : values) push_back(value);
+}
+
+size_t ValueColumn::memoryBytes() const {
+    return m_doubles.capacity() * sizeof(double) 
+         + m_floats.capacity() * sizeof(float) 
+         + m_scaled.capacity() * sizeof(int16_t);
+}
@@ -0,0 +1,45 @@
+#ifndef VALUECOLUMN_H
+#define VALUECOLUMN_H
+
+#include <cstdint>
+#include <vector>
+
+#include "valueAggregate.h"
+#include "valueEncoding.h"
+
+/**
+ * @class ValueColumn
+ * 
+ * @brief Values of a channel, stored with the channel's ValueEncoding.
+ * 
+ * Only the vector matching the codec is used (m_doubles, m_floats or
+ * m_scaled), so a Float channel uses half and a Scaled16 channel a
+ * quarter of the memory of a Double one. Values are encoded on
+ * push_back and decoded on get / decode. aggregate() works on the
+ * stored (narrow) type directly and only converts the result.
+ * 
+ */
+
+class ValueColumn {
+
+    public:
+        ValueEncoding m_encoding;
+        std::vector<double> m_doubles;
+        std::vector<float> m_floats;
+        std::vector<int16_t> m_scaled;
+
+        ValueColumn() = default;
+
+        size_t size() const;
+        void reserve(size_t size);
+        void push_back(double value);
+        double get(size_t index) const;
+        void truncate(size_t size);
+        void clear();
+        void decode(size_t first, size_t last, double* out) const;
+        ValueAggregate aggregate(size_t first, size_t last) const;
+        void setEncoding(const ValueEncoding& encoding);
+        size_t memoryBytes() const;
+};
+
+#endif // VALUECOLUMN_H
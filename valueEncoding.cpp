@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+#include "valueEncoding.h"
+
+ValueEncoding::ValueEncoding(ValueCodec codec, double scale, double offset)
+    : m_codec(codec), m_scale(scale), m_offset(offset) {}
+
+/**
+ * @brief Scaled16 encoding covering [minValue, maxValue] with the full raw range.
+ */
+
+ValueEncoding ValueEncoding::scaled16(double minValue, double maxValue) {
+    double offset = (minValue + maxValue) / 2.0;
+    double scale = (maxValue - minValue) / (2.0 * INT16_MAX);
+    return ValueEncoding(ValueCodec::Scaled16, scale > 0 ? scale : 1.0, offset);
+}
+
+static std::mutex unitEncodingsMtx;
+static std::unordered_map<std::string, ValueEncoding> unitEncodings;
+
+/**
+ * @brief Encoding registered for a unit (Double if none).
+ */
+
+ValueEncoding ValueEncoding::forUnit(const std::string& unit) {
+    std::unique_lock<std::mutex> lock(unitEncodingsMtx);
+    auto it = unitEncodings.find(unit);
+    return it != unitEncodings.end() ? it->second : ValueEncoding();
+}
+
+void ValueEncoding::setForUnit(const std::string& unit, const ValueEncoding& encoding) {
+    std::unique_lock<std::mutex> lock(unitEncodingsMtx);
+    unitEncodings[unit] = encoding;
+}
+
+int16_t ValueEncoding::encodeScaled(double value) const {
+    if (std::isnan(value)) return kScaledNan;
+    double raw = std::round((value - m_offset) / m_scale);
+    return static_cast<int16_t>(std::clamp(raw, -double(INT16_MAX), double(INT16_MAX)));
+}
+
+double ValueEncoding::decodeScaled(int16_t raw) const {
+    if (raw == kScaledNan) return std::numeric_limits<double>::quiet_NaN();
+    return m_offset + m_scale * raw;
+}
+
+/**
+ * @brief Value as it will be read back after being stored.
+ */
+
+double ValueEncoding::quantize(double value) const {
+    switch (m_codec) {
+        case ValueCodec::Double: return value;
+        case ValueCodec::Float: return static_cast<float>(value);
+        case ValueCodec::Scaled16: return decodeScaled(encodeScaled(value));
+    }
+    return value;
+}
+
+size_t ValueEncoding::bytesPerValue() const {
+    switch (m_codec) {
+        case ValueCodec::Double: return sizeof(double);
+        case ValueCodec::Float: return sizeof(float);
+        case ValueCodec::Scaled16: return sizeof(int16_t);
+    }
+    return sizeof(double);
+}
+
+std::string ValueEncoding::codecName() const {
+    switch (m_codec) {
+        case ValueCodec::Double: return "double";
+        case ValueCodec::Float: return "float";
+        case ValueCodec::Scaled16: return "scaled16";
+    }
+    return "double";
+}
+
+ValueCodec ValueEncoding::codecFromName(const std::string& name) {
+    if (name == "float") return ValueCodec::Float;
+    if (name == "scaled16") return ValueCodec::Scaled16;
+    return ValueCodec::Double;
+}
@@ -0,0 +1,55 @@
+#ifndef VALUEENCODING_H
+#define VALUEENCODING_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Storage type of the values of a channel.
+ * 
+ * Double: 8 bytes, lossless (default).
+ * Float: 4 bytes, ~7 significant digits.
+ * Scaled16: 2 bytes, value = offset + scale * raw with raw a 16 bit
+ * integer, enough for sensors with 12-16 bits of real resolution.
+ */
+
+enum class ValueCodec : uint8_t { Double, Float, Scaled16 };
+
+/**
+ * @class ValueEncoding
+ * 
+ * @brief Codec (+ scale and offset) used to store the values of a channel.
+ * 
+ * Values are encoded at ingest and decoded in queries and persistence.
+ * In Scaled16, values outside of the representable range are clamped
+ * and NaN is stored as the reserved raw value kScaledNan. Encodings can
+ * be registered per unit (forUnit / setForUnit), so channels get the
+ * right one when the collector creates them from their DataInput.
+ * 
+ */
+
+class ValueEncoding {
+
+    public:
+        static constexpr int16_t kScaledNan = INT16_MIN;
+
+        ValueCodec m_codec = ValueCodec::Double;
+        double m_scale = 1.0;
+        double m_offset = 0.0;
+
+        ValueEncoding() = default;
+        ValueEncoding(ValueCodec codec, double scale = 1.0, double offset = 0.0);
+
+        static ValueEncoding scaled16(double minValue, double maxValue);
+        static ValueEncoding forUnit(const std::string& unit);
+        static void setForUnit(const std::string& unit, const ValueEncoding& encoding);
+
+        int16_t encodeScaled(double value) const;
+        double decodeScaled(int16_t raw) const;
+        double quantize(double value) const;
+        size_t bytesPerValue() const;
+        std::string codecName() const;
+        static ValueCodec codecFromName(const std::string& name);
+};
+
+#endif // VALUEENCODING_H